@@ -1,13 +1,69 @@
 #include "Functions.h"
+#include "printer.h"
+#include "instrumentation.h"
+
+#include <vector>
+
+std::shared_ptr<Function> Function::simplifyNode(std::shared_ptr<Function>, std::shared_ptr<Function>) const{
+    return simplify();
+}
+
+void Function::release(std::shared_ptr<Function>& child){
+    // A trivially destructible pointer, nodes can still be freed while the thread shuts down
+    thread_local std::vector<std::shared_ptr<Function>>* queue = nullptr;
+    if(!child || child.use_count() > 1){
+        child.reset();
+        return;
+    }
+    if(queue){
+        queue->push_back(std::move(child));
+        return;
+    }
+    std::vector<std::shared_ptr<Function>> pending;
+    pending.push_back(std::move(child));
+    queue = &pending;
+    while(!pending.empty()){
+        std::shared_ptr<Function> next = std::move(pending.back());
+        pending.pop_back();
+        next.reset();
+    }
+    queue = nullptr;
+}
 
 //Constant
 
-double Constant::getValue(){
+const std::shared_ptr<Function>& Constant::zero(){
+    static const std::shared_ptr<Function> constant = std::make_shared<Constant>(0.0);
+    return constant;
+}
+
+const std::shared_ptr<Function>& Constant::one(){
+    static const std::shared_ptr<Function> constant = std::make_shared<Constant>(1.0);
+    return constant;
+}
+
+const std::shared_ptr<Function>& Constant::negativeOne(){
+    static const std::shared_ptr<Function> constant = std::make_shared<Constant>(-1.0);
+    return constant;
+}
+
+const std::shared_ptr<Function>& Constant::two(){
+    static const std::shared_ptr<Function> constant = std::make_shared<Constant>(2.0);
+    return constant;
+}
+
+const std::shared_ptr<Function>& Constant::e(){
+    static const std::shared_ptr<Function> constant = std::make_shared<Constant>(std::exp(1.0));
+    return constant;
+}
+
+double Constant::getValue() const{
     return value;
 }
 
 
 std::shared_ptr<Function> Constant::simplify() const{
+    CALC_PROBE(Simplify, Constant);
     return std::make_shared<Constant>(value);
 }
 
@@ -20,37 +76,43 @@ bool Constant::isEqual(const std::shared_ptr<Function>& other) const{
 }
 
 std::string Constant::display() const{
-    return std::to_string(value);
+    return toString(*this);
 }
 
 // Variable
 
-std::string Variable::getName(){
+const std::string& Variable::getName() const{
     return name;
 }
 
 std::shared_ptr<Function> Variable::simplify() const{
+    CALC_PROBE(Simplify, Variable);
     return std::make_shared<Variable>(name);
 }
 
 bool Variable::isEqual(const std::shared_ptr<Function>& other) const{
     auto otherVar = dynamic_cast<Variable*>(other.get());
     if(!otherVar) return false;
-    return name.compare(otherVar->name);
+    return name == otherVar->name;
 }
 
 std::string Variable::display() const{
-    return name;
+    return toString(*this);
 }
 
 // Absolute Value
 
-std::shared_ptr<Function> AbsVal::getArgument(){
+const std::shared_ptr<Function>& AbsVal::getArgument() const{
     return argument;
 }
 
 std::shared_ptr<Function> AbsVal::simplify() const{
-    return std::make_shared<AbsVal>(argument->simplify());
+    CALC_PROBE(Simplify, AbsVal);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> AbsVal::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
+    return std::make_shared<AbsVal>(simplifiedArgument);
 }
 
 bool AbsVal::isEqual(const std::shared_ptr<Function>& other) const{
@@ -60,50 +122,58 @@ bool AbsVal::isEqual(const std::shared_ptr<Function>& other) const{
 }
 
 std::string AbsVal::display() const{
-    return "| " + argument->display() + " |";
+    return toString(*this);
 }
 
 // Polynomial
 
-std::shared_ptr<Function> Polynomial::getCoefficient(){
+const std::shared_ptr<Function>& Polynomial::getCoefficient() const{
     return coefficient;
 }
-double Polynomial::getExponent(){
+double Polynomial::getExponent() const{
     return exponent;
 }
     
 std::shared_ptr<Function> Polynomial::simplify() const {
+    CALC_PROBE(Simplify, Polynomial);
+    return simplifyNode(coefficient->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> Polynomial::simplifyNode(std::shared_ptr<Function> simplifiedCoefficient, std::shared_ptr<Function>) const{
     if(auto constant = dynamic_cast<Constant*>(coefficient.get())){
         return std::make_shared<Constant>(this->evaluate(1));
     }
-    return std::make_shared<Polynomial>(coefficient->simplify());
+    return std::make_shared<Polynomial>(simplifiedCoefficient, exponent);
 }
 
 bool Polynomial::isEqual(const std::shared_ptr<Function>& other) const{
     auto otherPoly = dynamic_cast<Polynomial*>(other.get());
     if(!otherPoly) return false;
-    return coefficient->isEqual(otherPoly->coefficient) && exponent == otherPoly->getExponent();
+    return coefficient->isEqual(otherPoly->coefficient) && exponent == otherPoly->exponent;
 }
 
 std::string Polynomial::display() const{
-    if(auto var = dynamic_cast<Variable*>(coefficient.get())){
-        return coefficient->display() + "^" + std::to_string(exponent);
-    }
+    return toString(*this);
 }
 
 // Logarithmic
 
-std::shared_ptr<Function> Logarithmic::getBase(){
+const std::shared_ptr<Function>& Logarithmic::getBase() const{
     return base;
 }
-std::shared_ptr<Function> Logarithmic::getArgument(){
+const std::shared_ptr<Function>& Logarithmic::getArgument() const{
     return argument;
 }    
 
 std::shared_ptr<Function> Logarithmic::simplify() const{
-    if(base->isEqual(argument)) return std::make_shared<Constant>(1.0);
+    CALC_PROBE(Simplify, Logarithmic);
+    return simplifyNode(base->simplify(), argument->simplify());
+}
+
+std::shared_ptr<Function> Logarithmic::simplifyNode(std::shared_ptr<Function> simplifiedBase, std::shared_ptr<Function> simplifiedArgument) const{
+    if(base->isEqual(argument)) return Constant::one();
 
-    if(argument->isEqual(std::make_shared<Constant>(1.0))) return std::make_shared<Constant>(0.0);
+    if(argument->isEqual(Constant::one())) return Constant::zero();
 
     auto const1 = dynamic_cast<Constant*>(base.get());
     auto const2 = dynamic_cast<Constant*>(argument.get());
@@ -113,7 +183,7 @@ std::shared_ptr<Function> Logarithmic::simplify() const{
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<Logarithmic>(base->simplify(), argument->simplify());
+    return std::make_shared<Logarithmic>(simplifiedBase, simplifiedArgument);
 }
 
 bool Logarithmic::isEqual(const std::shared_ptr<Function>& other) const{
@@ -123,30 +193,30 @@ bool Logarithmic::isEqual(const std::shared_ptr<Function>& other) const{
 }
 
 std::string Logarithmic::display() const{
-    if(base->isEqual(std::make_shared<Constant>(std::exp(1.0)))){
-        return "ln(" + argument->display() + ")";
-    }
-    else {
-        return "log_" + base->display() + "(" + argument->display() + ")";
-    }
+    return toString(*this);
 }
 
 // Exponential
 
-std::shared_ptr<Function> Exponential::getArgument(){
+const std::shared_ptr<Function>& Exponential::getArgument() const{
     return argument;
 }
-std::shared_ptr<Function> Exponential::getBase(){
+const std::shared_ptr<Function>& Exponential::getBase() const{
     return base;
 }
 
 std::shared_ptr<Function> Exponential::simplify() const {
+    CALC_PROBE(Simplify, Exponential);
+    return simplifyNode(base->simplify(), argument->simplify());
+}
+
+std::shared_ptr<Function> Exponential::simplifyNode(std::shared_ptr<Function> simplifiedBase, std::shared_ptr<Function> simplifiedArgument) const{
     auto const1 = dynamic_cast<Constant*>(base.get());
     auto const2 = dynamic_cast<Constant*>(argument.get());
     if(const1 && const2){
         return std::make_shared<Constant>(this->evaluate(1));
     }
-    return std::make_shared<Exponential>(base->simplify(), argument->simplify());
+    return std::make_shared<Exponential>(simplifiedBase, simplifiedArgument);
 }
 
 bool Exponential::isEqual(const std::shared_ptr<Function>& other) const{
@@ -156,8 +226,29 @@ bool Exponential::isEqual(const std::shared_ptr<Function>& other) const{
 }
 
 std::string Exponential::display() const {
-    if(base->isEqual(std::make_shared<Constant>(std::exp(1.0)))){
-        return "e^" + argument->display();
-    }
-    else return base->display() + "^" + argument->display();
-}
\ No newline at end of file
+    return toString(*this);
+}
+// Derivative
+
+const std::shared_ptr<Function>& Derivative::getFunction() const{
+    return function;
+}
+
+std::shared_ptr<Function> Derivative::simplify() const{
+    return materialize()->simplify();
+}
+
+std::shared_ptr<Function> Derivative::simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const{
+    return materialize()->simplifyNode(std::move(a), std::move(b));
+}
+
+// Two lazy derivatives of equal functions are equal without building either one
+bool Derivative::isEqual(const std::shared_ptr<Function>& other) const{
+    auto otherDerivative = dynamic_cast<Derivative*>(other.get());
+    if(otherDerivative && function->isEqual(otherDerivative->function)) return true;
+    return materialize()->isEqual(otherDerivative ? otherDerivative->materialize() : other);
+}
+
+std::string Derivative::display() const{
+    return toString(*this);
+}
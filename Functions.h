@@ -4,12 +4,48 @@
 
 #include <iostream>
 #include <memory>
+#include <utility>
 #include <cmath>
 #include <map>
 #include <functional>
-#include "arithmeticOperands.h"
-#include "trigFunctions.h"
-#include "functionChecks.h"
+#include <mutex>
+#include <cstdint>
+#include <complex>
+#include "interval.h"
+#include "evaluationStatus.h"
+
+// Argument and value of evaluateComplex()
+typedef std::complex<double> Complex;
+
+/*
+    Size of the tree below a node, computed once when the node is constructed from the metrics of
+    its children (budgets that use it are in complexity.h)
+    A subtree shared by several parents is counted once per parent, as evaluate() visits it once per
+    parent. Counts saturate instead of wrapping. derivativeNodes follows the derivative rule of the
+    node, so the size of f' is known before it is built. It is exact for trees without lazy
+    derivatives; a lazy derivative knows its own size but estimates the size of its derivative.
+*/
+struct Complexity {
+    // Rough cost of one evaluate() of a node, in units of one floating point addition
+    static constexpr double LEAF = 1.0;
+    static constexpr double ARITHMETIC = 1.0;
+    static constexpr double DIVISION = 4.0;
+    static constexpr double POWER = 20.0;
+    static constexpr double TRANSCENDENTAL = 40.0;
+
+    // Size of the tree a derivative rule builds:
+    // constant + first * nodes(child 0) + second * nodes(child 1) + derivativeNodes of the children
+    struct Rule {
+        uint64_t constant;
+        uint64_t first;
+        uint64_t second;
+    };
+
+    uint64_t nodes = 1;             // Nodes of the tree
+    uint32_t depth = 1;             // Nodes on the longest path from the root to a leaf
+    double cost = LEAF;             // Estimated cost of evaluate()
+    uint64_t derivativeNodes = 1;   // Nodes of the tree of derivative()
+};
 
 
 /*
@@ -18,16 +54,41 @@
         Constant, Variable,
         Absolute Value, Logarithmic, Exponential,
         Sum, Difference, Product, Quotient
-        Trigonometric, Inverse Trig, Hyperbolic
+        Trigonometric, Inverse Trig, Hyperbolic,
+        Derivative (lazy)
 */
 class Function {
 public:
+#ifdef CALC_INSTRUMENTATION
+    // Count allocated and freed nodes (see instrumentation.h)
+    Function();
+    Function(const Function&);
+    virtual ~Function();
+#else
     virtual ~Function() = default;
+#endif
     virtual double evaluate(double x) const = 0;   // Evaluate the function at x
+    virtual Interval evaluateInterval(const Interval& x) const = 0;   // Bound the function over every x in [lo, hi]
+    virtual Complex evaluateComplex(const Complex& z) const = 0;   // Evaluate the function at a complex z (principal branches)
     virtual std::shared_ptr<Function> derivative() const = 0;  // Return the derivative of the function
     virtual std::shared_ptr<Function> simplify() const = 0;
+    // simplify() given the already simplified children (numbered as in nodeKind.h, null if absent):
+    // simplify() is simplifyNode(child 0->simplify(), child 1->simplify()). Leaves return simplify()
+    virtual std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const;
     virtual bool isEqual(const std::shared_ptr<Function>& other) const = 0;
     virtual std::string display() const = 0;
+
+    const Complexity& complexity() const { return metrics; }
+
+protected:
+    Complexity metrics;
+
+    // Drops a child from a destructor without recursion: freeing a chain of n nodes would otherwise
+    // nest n destructor calls. Nested releases only queue the child for the outermost one to free
+    static void release(std::shared_ptr<Function>& child);
+
+    // Sets metrics for a node of the given cost and derivative rule above a and b (b may be null)
+    void measure(double cost, Complexity::Rule rule, const Function* a, const Function* b = nullptr);
 };
 
 
@@ -37,13 +98,26 @@ class Constant : public Function {
 public:
     Constant(double val) : value(val) {} // Default constructor for Constant
 
+    /**
+     * Shared constants used by the derivative and simplification rules. Each one is allocated
+     * once and reused, instead of allocating a new Constant for every rule application
+     * 
+     * Precondition: None
+     * Postcondition: zero() = 0, one() = 1, negativeOne() = -1, two() = 2, e() = e
+     */
+    static const std::shared_ptr<Function>& zero();
+    static const std::shared_ptr<Function>& one();
+    static const std::shared_ptr<Function>& negativeOne();
+    static const std::shared_ptr<Function>& two();
+    static const std::shared_ptr<Function>& e();
+
     /**
      * Standard getter to return the value of C
      * 
      * Precondition: None
      * Postcondition: value = value, getValue() = value
      */
-    double getValue();
+    double getValue() const;
 
     /**
      * Evaluates the constant function for any given value and returns the value of the constant
@@ -53,6 +127,16 @@ public:
      */
     double evaluate(double x) const override;
 
+    /**
+     * Evaluates the constant over an interval, which is always the single point [value, value]
+     * 
+     * Precondition: None
+     * Postcondition: value = value, evaluateInterval(x) = [value, value]
+     */
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     /**
      * Calculates the derivative of the constant f'(x) = 0
      * 
@@ -92,7 +176,7 @@ public:
 class Variable : public Function {
     std::string name;
     public:
-    Variable(std::string x) : name(x){} 
+    Variable(std::string x) : name(std::move(x)){} 
 
     /**
      * Standard getter to return the name of the variable
@@ -100,7 +184,7 @@ class Variable : public Function {
      * Precondition: None
      * Postcondition: name = name, getName() = name
      */
-    std::string getName();
+    const std::string& getName() const;
 
     /**
      * Evaluates the variable for any given value and returns the value of the given value
@@ -110,6 +194,16 @@ class Variable : public Function {
      */
     double evaluate(double x) const override;
 
+    /**
+     * Evaluates the variable over an interval and returns the given interval
+     * 
+     * Precondition: None
+     * Postcondition: name = name, evaluateInterval(x) = x
+     */
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     /**
      * Calculates the derivative of the variable f'(x) = 1
      * 
@@ -149,16 +243,26 @@ class AbsVal : public Function {
     std::shared_ptr<Function> argument;
 
     public:
-    AbsVal(std::shared_ptr<Function> arg) : argument(arg) {}
+    static constexpr Complexity::Rule RULE = {3, 2, 0};     // (f * f') / |f|
+
+    AbsVal(std::shared_ptr<Function> arg) : argument(std::move(arg)) { measure(Complexity::ARITHMETIC, RULE, argument.get()); }
+    ~AbsVal() override { release(argument); }
 
-    std::shared_ptr<Function> getArgument();
+    const std::shared_ptr<Function>& getArgument() const;
+    const Function& getArgumentRef() const { return *argument; }
 
     double evaluate(double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -170,17 +274,30 @@ class Polynomial : public Function {
     std::shared_ptr<Function> coefficient;
     double exponent;
 public:
-    Polynomial(std::shared_ptr<Function> coef, double exp) : coefficient(coef), exponent(exp) {}
+    static constexpr Complexity::Rule RULE = {4, 1, 0};     // A * f^(A-1) * f'
 
-    std::shared_ptr<Function> getCoefficient();
-    double getExponent();
+    Polynomial(std::shared_ptr<Function> coef, double exp) : coefficient(std::move(coef)), exponent(exp) {
+        measure(Complexity::POWER, RULE, coefficient.get());
+        if(exponent == 0) metrics.derivativeNodes = 1;
+    }
+    ~Polynomial() override { release(coefficient); }
+
+    const std::shared_ptr<Function>& getCoefficient() const;
+    const Function& getCoefficientRef() const { return *coefficient; }
+    double getExponent() const;
 
     double evaluate(double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -191,17 +308,30 @@ class Logarithmic : public Function{
     std::shared_ptr<Function> base;
     std::shared_ptr<Function> argument;
     public:
-    Logarithmic(std::shared_ptr<Function> b, std::shared_ptr<Function> arg) : base(b), argument(arg) {}
+    static constexpr Complexity::Rule RULE = {10, 4, 3};
 
-    std::shared_ptr<Function> getBase();
-    std::shared_ptr<Function> getArgument();
+    Logarithmic(std::shared_ptr<Function> b, std::shared_ptr<Function> arg) : base(std::move(b)), argument(std::move(arg)) {
+        measure(Complexity::TRANSCENDENTAL, RULE, base.get(), argument.get());
+    }
+    ~Logarithmic() override { release(base); release(argument); }
+
+    const std::shared_ptr<Function>& getBase() const;
+    const std::shared_ptr<Function>& getArgument() const;
+    const Function& getBaseRef() const { return *base; }
+    const Function& getArgumentRef() const { return *argument; }
 
     double evaluate (double x) const override;
+
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
     
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -212,20 +342,90 @@ class Exponential : public Function{
     std::shared_ptr<Function> argument;
     std::shared_ptr<Function> base;
     public:
-    Exponential(std::shared_ptr<Function> a, std::shared_ptr<Function> arg) : base(a), argument(arg) {}
+    static constexpr Complexity::Rule RULE = {22, 5, 2};
+
+    Exponential(std::shared_ptr<Function> a, std::shared_ptr<Function> arg) : argument(std::move(arg)), base(std::move(a)) {
+        measure(Complexity::POWER, RULE, base.get(), argument.get());
+    }
+    ~Exponential() override { release(base); release(argument); }
 
-    std::shared_ptr<Function> getArgument();
-    std::shared_ptr<Function> getBase();
+    const std::shared_ptr<Function>& getArgument() const;
+    const std::shared_ptr<Function>& getBase() const;
+    const Function& getArgumentRef() const { return *argument; }
+    const Function& getBaseRef() const { return *base; }
 
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
+    std::shared_ptr<Function> derivative() const override;
+
+    std::shared_ptr<Function> simplify() const override;
+
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
+    bool isEqual(const std::shared_ptr<Function>& other) const override;
+
+    std::string display() const override;
+};
+
+// Lazy derivative node d/dx f(x)
+// Derivative rules wrap the derivatives of their children in this node, so a child's derivative is
+// only built once something evaluates, simplifies or displays it. The result is built once and shared
+class Derivative : public Function {
+    std::shared_ptr<Function> function;
+    mutable std::once_flag built;
+    mutable std::shared_ptr<Function> result;
+
+    // Metrics of the derivative before it is built, from those of f
+    void estimate();
+
+    public:
+    Derivative(std::shared_ptr<Function> f) : function(std::move(f)) { estimate(); }
+    ~Derivative() override { release(function); release(result); }
+
+    /**
+     * Returns the derivative of f without building it. Constants and variables are differentiated
+     * right away since their derivatives are shared constants
+     * 
+     * Precondition: f is not null
+     * Postcondition: of(f)->evaluate(x) = f->derivative()->evaluate(x)
+     */
+    static std::shared_ptr<Function> of(const std::shared_ptr<Function>& f);
+
+    const std::shared_ptr<Function>& getFunction() const;
+    const Function& getFunctionRef() const { return *function; }
+
+    /**
+     * Builds the derivative the first time it is called (thread safe) and returns it afterwards
+     * 
+     * Precondition: None
+     * Postcondition: materialize() = f'(x) with lazy children, the same pointer on every call
+     */
+    const std::shared_ptr<Function>& materialize() const;
+
+    double evaluate(double x) const override;
+
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
 };
 
+// Included after Function is defined since every derived class needs the full base class
+#include "arithmeticOperands.h"
+#include "trigFunctions.h"
+#include "functionChecks.h"
+
 #endif
\ No newline at end of file
@@ -1,33 +1,37 @@
 #include "arithmeticOperands.h"
+#include "printer.h"
+#include "instrumentation.h"
 
-std::shared_ptr<Function> Sum::getLeft(){
+const std::shared_ptr<Function>& Sum::getLeft() const{
     return left;
 }
 
-std::shared_ptr<Function> Sum::getRight(){
+const std::shared_ptr<Function>& Sum::getRight() const{
     return right;
 }
 
 //Add Trig identity checks
 std::shared_ptr<Function> Sum::simplify() const{
-    auto simplifiedLeft = left->simplify();
-    auto simplifiedRight = right->simplify();
+    CALC_PROBE(Simplify, Sum);
+    return simplifyNode(left->simplify(), right->simplify());
+}
 
+std::shared_ptr<Function> Sum::simplifyNode(std::shared_ptr<Function> simplifiedLeft, std::shared_ptr<Function> simplifiedRight) const{
     auto constLeft = dynamic_cast<Constant*>(simplifiedLeft.get());
     auto constRight = dynamic_cast<Constant*>(simplifiedRight.get());
 
-    if(constLeft && constRight) return std::make_shared<Constant>(simplifiedLeft->evaluate(1.0) + simplifiedRight->evaluate(1.0));
+    if(constLeft && constRight) return std::make_shared<Constant>(constLeft->getValue() + constRight->getValue());
 
-    if(constLeft && simplifiedLeft->evaluate(0.0) == 0.0){
+    if(constLeft && constLeft->getValue() == 0.0){
         return simplifiedRight;
     }
-    if(constRight && simplifiedRight->evaluate(0.0) == 0.0){
+    if(constRight && constRight->getValue() == 0.0){
         return simplifiedLeft;
     }
     if(simplifiedLeft->isEqual(simplifiedRight)){
-        return std::make_shared<Product>(std::make_shared<Constant>(2.0), simplifiedLeft);
+        return std::make_shared<Product>(Constant::two(), std::move(simplifiedLeft));
     }
-    return std::make_shared<Sum>(simplifiedLeft, simplifiedRight);
+    return std::make_shared<Sum>(std::move(simplifiedLeft), std::move(simplifiedRight));
 }
 
 bool Sum::isEqual(const std::shared_ptr<Function>& other) const{
@@ -38,38 +42,36 @@ bool Sum::isEqual(const std::shared_ptr<Function>& other) const{
     return left->isEqual(otherSum->left) && right->isEqual(otherSum->right);
 }
 
-std::shared_ptr<Function> Difference::getLeft(){
+const std::shared_ptr<Function>& Difference::getLeft() const{
     return left;
 }
-std::shared_ptr<Function> Difference::getRight(){
+const std::shared_ptr<Function>& Difference::getRight() const{
     return right;
 }
 
-double Difference::evaluate(double x) const{
-    return left->evaluate(x) - right->evaluate(x);
-}
-
 std::shared_ptr<Function> Difference::simplify() const{
-    auto simplifiedLeft = left->simplify();
-    auto simplifiedRight = right->simplify();
+    CALC_PROBE(Simplify, Difference);
+    return simplifyNode(left->simplify(), right->simplify());
+}
 
+std::shared_ptr<Function> Difference::simplifyNode(std::shared_ptr<Function> simplifiedLeft, std::shared_ptr<Function> simplifiedRight) const{
     auto leftConst = dynamic_cast<Constant*>(simplifiedLeft.get());
-    if(leftConst && simplifiedLeft->evaluate(0.0) == 0.0){
-        return std::make_shared<Product>(std::make_shared<Constant>(-1.0), simplifiedRight);
+    if(leftConst && leftConst->getValue() == 0.0){
+        return std::make_shared<Product>(Constant::negativeOne(), std::move(simplifiedRight));
     }
     auto rightConst = dynamic_cast<Constant*>(simplifiedRight.get());
-    if(rightConst && simplifiedRight->evaluate(0.0) == 0.0){
+    if(rightConst && rightConst->getValue() == 0.0){
         return simplifiedLeft;
     }
     if(leftConst && rightConst){
-        return std::make_shared<Constant>(simplifiedLeft->evaluate(1.0) - simplifiedRight->evaluate(1.0));
+        return std::make_shared<Constant>(leftConst->getValue() - rightConst->getValue());
     }
 
     if(simplifiedLeft->isEqual(simplifiedRight)){
-        return std::make_shared<Constant>(0.0);
+        return Constant::zero();
     }
 
-    return std::make_shared<Difference>(simplifiedLeft, simplifiedRight);
+    return std::make_shared<Difference>(std::move(simplifiedLeft), std::move(simplifiedRight));
 }
 
 bool Difference::isEqual(const std::shared_ptr<Function>& other) const{
@@ -80,38 +82,44 @@ bool Difference::isEqual(const std::shared_ptr<Function>& other) const{
     return left->isEqual(otherDiff->left) && right->isEqual(otherDiff->right);
 }
 
+std::string Sum::display() const{
+    return toString(*this);
+}
+
 std::string Difference::display() const{
-    return left->display() + " - " + right->display();
+    return toString(*this);
 }
 
-std::shared_ptr<Function> Product::getLeft(){
+const std::shared_ptr<Function>& Product::getLeft() const{
     return left;
 }
-std::shared_ptr<Function> Product::getRight(){
+const std::shared_ptr<Function>& Product::getRight() const{
     return right;
 }
 
 std::shared_ptr<Function> Product::simplify() const{
-    auto simplifiedLeft = left->simplify();
-    auto simplifiedRight = right->simplify();
+    CALC_PROBE(Simplify, Product);
+    return simplifyNode(left->simplify(), right->simplify());
+}
 
-    if(checkForZero(simplifiedRight)){
-        return std::make_shared<Constant>(0.0);
+std::shared_ptr<Function> Product::simplifyNode(std::shared_ptr<Function> simplifiedLeft, std::shared_ptr<Function> simplifiedRight) const{
+    if(checkForZero(*simplifiedRight)){
+        return Constant::zero();
     }
-    if(checkForOne(simplifiedLeft)){
+    if(checkForOne(*simplifiedLeft)){
         return simplifiedRight;
     }
-    if(checkForZero(simplifiedRight)){
-        return std::make_shared<Constant>(0.0);
+    if(checkForZero(*simplifiedRight)){
+        return Constant::zero();
     }
-    if(checkForOne(simplifiedRight)){
+    if(checkForOne(*simplifiedRight)){
         return simplifiedLeft;
     }
     if(simplifiedLeft->isEqual(simplifiedRight)){
-        return std::make_shared<Polynomial>(simplifiedLeft, 2.0);
+        return std::make_shared<Polynomial>(std::move(simplifiedLeft), 2.0);
     }
         
-    return std::make_shared<Product>(simplifiedLeft, simplifiedRight);
+    return std::make_shared<Product>(std::move(simplifiedLeft), std::move(simplifiedRight));
 }
 
 bool Product::isEqual(const std::shared_ptr<Function>& other) const{
@@ -121,48 +129,50 @@ bool Product::isEqual(const std::shared_ptr<Function>& other) const{
 }
 
 std::string Product::display() const{
-    return "(" + left->display() + ") * (" + right->display() + ")";
+    return toString(*this);
 }
 
 
-std::shared_ptr<Function> Quotient::getLeft(){
+const std::shared_ptr<Function>& Quotient::getLeft() const{
     return left;
 }
-std::shared_ptr<Function> Quotient::getRight(){
+const std::shared_ptr<Function>& Quotient::getRight() const{
     return right;
 }
 
 std::shared_ptr<Function> Quotient::simplify() const{
-    auto simplifiedTop = right->simplify();
-    auto simplifiedBottom = left->simplify();
+    CALC_PROBE(Simplify, Quotient);
+    return simplifyNode(left->simplify(), right->simplify());
+}
 
-    if(checkForOne(simplifiedBottom)){
+std::shared_ptr<Function> Quotient::simplifyNode(std::shared_ptr<Function> simplifiedTop, std::shared_ptr<Function> simplifiedBottom) const{
+    if(checkForOne(*simplifiedBottom)){
         return simplifiedTop;
     }
-    if(checkForZero(simplifiedTop)){
-        return std::make_shared<Constant>(0.0);
+    if(checkForZero(*simplifiedTop)){
+        return Constant::zero();
     }
-    if(checkForZero(simplifiedBottom)){
+    if(checkForZero(*simplifiedBottom)){
         throw std::runtime_error("Error denominator is 0");
     }
 
     // Trigonometric identities
     // tan(f(x)) = sin(f(x)) / cos(f(x))
-    if(tangentChange(std::make_shared<Quotient>(simplifiedTop, simplifiedBottom))){
-        auto sineArg = dynamic_cast<Sine*>(simplifiedTop.get());
+    if(tangentChange(*simplifiedTop, *simplifiedBottom)){
+        auto sineArg = static_cast<Sine*>(simplifiedTop.get());
         return std::make_shared<Tangent>(sineArg->getArgument());
     }
     // cot(f(x)) = cos(f(x)) / sin(f(x))
-    if(cotangentChange(std::make_shared<Quotient>(simplifiedTop, simplifiedBottom))){
-        auto cosineArg = dynamic_cast<Cosine*>(simplifiedTop.get());
+    if(cotangentChange(*simplifiedTop, *simplifiedBottom)){
+        auto cosineArg = static_cast<Cosine*>(simplifiedTop.get());
         return std::make_shared<Cotangent>(cosineArg->getArgument());
     }
 
-    if(checkForOne(simplifiedTop)){
+    if(checkForOne(*simplifiedTop)){
         return trigonometricQuotient(simplifiedBottom);
     }
 
-    return std::make_shared<Quotient>(simplifiedTop, simplifiedBottom);
+    return std::make_shared<Quotient>(std::move(simplifiedTop), std::move(simplifiedBottom));
 }
     
 bool Quotient::isEqual(const std::shared_ptr<Function>& other) const{
@@ -172,5 +182,5 @@ bool Quotient::isEqual(const std::shared_ptr<Function>& other) const{
 }
 
 std::string Quotient::display() const{
-    return "(" + left->display() + ") / (" + right->display() + ")";
+    return toString(*this);
 }
\ No newline at end of file
@@ -8,24 +8,35 @@ class Sum : public Function {
     std::shared_ptr<Function> right;
 
     public:
+    static constexpr Complexity::Rule RULE = {1, 0, 0};     // f' + g'
+
     Sum(std::shared_ptr<Function> f, std::shared_ptr<Function> g) :
-        left(f), right(g) {}
+        left(std::move(f)), right(std::move(g)) {
+        measure(Complexity::ARITHMETIC, RULE, left.get(), right.get());
+    }
+    ~Sum() override { release(left); release(right); }
 
-    std::shared_ptr<Function> getLeft();
-    std::shared_ptr<Function> getRight();
+    const std::shared_ptr<Function>& getLeft() const;
+    const std::shared_ptr<Function>& getRight() const;
+    const Function& getLeftRef() const { return *left; }
+    const Function& getRightRef() const { return *right; }
 
     double evaluate(double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     //Add Trig identity checks
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
-    std::string display() const override{
-        return left->display() + " + " + right->display();
-    }
+    std::string display() const override;
 };
 
 //Add Trig identity checks
@@ -35,18 +46,31 @@ class Difference : public Function{
     std::shared_ptr<Function> right;
 
     public:
+    static constexpr Complexity::Rule RULE = {1, 0, 0};     // f' - g'
+
     Difference(std::shared_ptr<Function> f, std::shared_ptr<Function> g) : 
-        left(f), right(g) {}
+        left(std::move(f)), right(std::move(g)) {
+        measure(Complexity::ARITHMETIC, RULE, left.get(), right.get());
+    }
+    ~Difference() override { release(left); release(right); }
     
-    std::shared_ptr<Function> getLeft();
-    std::shared_ptr<Function> getRight();
+    const std::shared_ptr<Function>& getLeft() const;
+    const std::shared_ptr<Function>& getRight() const;
+    const Function& getLeftRef() const { return *left; }
+    const Function& getRightRef() const { return *right; }
 
     double evaluate(double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -58,18 +82,31 @@ class Product : public Function {
     std::shared_ptr<Function> right;
 
     public:
+    static constexpr Complexity::Rule RULE = {3, 1, 1};     // f' * g + f * g'
+
     Product(std::shared_ptr<Function> f, std::shared_ptr<Function> g) : 
-        left(f), right(g) {}
+        left(std::move(f)), right(std::move(g)) {
+        measure(Complexity::ARITHMETIC, RULE, left.get(), right.get());
+    }
+    ~Product() override { release(left); release(right); }
 
-    std::shared_ptr<Function> getLeft();
-    std::shared_ptr<Function> getRight();
+    const std::shared_ptr<Function>& getLeft() const;
+    const std::shared_ptr<Function>& getRight() const;
+    const Function& getLeftRef() const { return *left; }
+    const Function& getRightRef() const { return *right; }
 
     double evaluate(double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -81,16 +118,29 @@ class Quotient : public Function {
     std::shared_ptr<Function> left;     //Numerator
     std::shared_ptr<Function> right;    //Denominator
     public:
-    Quotient(std::shared_ptr<Function> f, std::shared_ptr<Function> g) : left(f), right(g){}
+    static constexpr Complexity::Rule RULE = {5, 1, 2};     // (f' * g - f * g') / g^2
 
-    std::shared_ptr<Function> getLeft();
-    std::shared_ptr<Function> getRight();
+    Quotient(std::shared_ptr<Function> f, std::shared_ptr<Function> g) : left(std::move(f)), right(std::move(g)){
+        measure(Complexity::DIVISION, RULE, left.get(), right.get());
+    }
+    ~Quotient() override { release(left); release(right); }
+
+    const std::shared_ptr<Function>& getLeft() const;
+    const std::shared_ptr<Function>& getRight() const;
+    const Function& getLeftRef() const { return *left; }
+    const Function& getRightRef() const { return *right; }
 
     double evaluate(double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
+
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
     
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
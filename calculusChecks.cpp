@@ -0,0 +1,518 @@
+#include "Functions.h"
+#include "expressionSplit.h"
+#include "evaluationStatus.h"
+#include "program.h"
+#include "serialize.h"
+#include "derivativeService.h"
+#include "parameters.h"
+#include "codegen.h"
+#include "jit.h"
+#include "complexity.h"
+#include "flatExpression.h"
+#include "traversal.h"
+#include "arithmeticOperands.h"
+#include "parallelTraversal.h"
+#include "printer.h"
+#include "complexStep.h"
+#include "fusion.h"
+#include "guardAnalysis.h"
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <stdexcept>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+#include <memory>
+#include <cstdlib>
+
+/*
+    Checks
+    One section per feature, each comparing it with evaluate() or with another way to get the same
+    result. Every failed check prints a line; the exit status is the number of failures. Build it
+    with the library sources, as the command line:
+        g++ -std=c++17 -O2 -o calculusChecks <library sources> calculusChecks.cpp -lpthread -ldl
+*/
+
+static int failures = 0;
+static int skipped = 0;
+
+static void check(bool condition, const std::string& what){
+    if(condition) return;
+    failures++;
+    std::printf("FAIL %s\n", what.c_str());
+}
+
+// Same value up to a relative tolerance, NaNs and infinities of the same sign included
+static bool agrees(double a, double b, double tolerance){
+    if(std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b);
+    if(std::isinf(a) || std::isinf(b)) return a == b;
+    return std::abs(a - b) <= tolerance * std::max(1.0, std::abs(b));
+}
+
+// Evenly spaced points of [low, high], both ends included
+static std::vector<double> grid(double low, double high, size_t count){
+    std::vector<double> xs(count);
+    for(size_t i = 0; i < count; i++) xs[i] = low + (high - low) * i / (count - 1);
+    return xs;
+}
+
+/*
+    Intervals
+*/
+
+static void checkIntervals(){
+    const char* expressions[] = {"x^2 - 3*x", "sin(x)*cos(x)", "e^(x) / (x^2 + 1)", "ln(x + 5)*tan(x/4)",
+        "arctan(x) + sinh(x/2)", "abs(x - 1)^3"};
+    const double bounds[][2] = {{-2.0, 3.0}, {0.1, 0.2}, {-1.0, 1.0}, {0.5, 4.0}};
+    for(const char* expr : expressions){
+        std::shared_ptr<Function> f = buildFunction(expr);
+        for(const auto& bound : bounds){
+            Interval enclosure = f->evaluateInterval(Interval(bound[0], bound[1]));
+            for(double x : grid(bound[0], bound[1], 101)){
+                double y = f->evaluate(x);
+                check(!std::isfinite(y) || enclosure.contains(y),
+                    std::string("interval of ") + expr + " misses f(" + std::to_string(x) + ") = " + std::to_string(y));
+            }
+        }
+    }
+    check(buildFunction("1/x")->evaluateInterval(Interval(-1.0, 1.0)).contains(1e300), "interval of 1/x across 0 is not unbounded");
+    // Values snapped to 0 and 1 by evaluate() are inside the enclosures
+    for(const char* expr : {"sin(x)", "tan(x)", "csc(x)", "cos(x)", "sec(x)"}){
+        std::shared_ptr<Function> f = buildFunction(expr);
+        for(double x : {1.5e-13, 1e-7}){
+            Interval enclosure = f->evaluateInterval(Interval(x - 5e-14, x + 5e-14));
+            check(enclosure.contains(f->evaluate(x)), std::string("interval of ") + expr + " misses the snapped value at " + std::to_string(x));
+        }
+    }
+}
+
+/*
+    Division by zero
+*/
+
+static void checkDivisionByZero(){
+    std::shared_ptr<Function> f = buildFunction("1/x");
+
+    clearEvaluationErrors();
+    double y = f->evaluate(0.0);
+    check(std::isinf(y) && (evaluationErrors() & EVAL_DIVIDE_BY_ZERO), "1/0 does not record a division by zero");
+    std::vector<double> values;
+    std::vector<unsigned char> errors;
+    evaluateGrid(*f, {-1.0, 0.0, 2.0}, values, &errors);
+    check(errors[0] == EVAL_OK && errors[1] == EVAL_DIVIDE_BY_ZERO && errors[2] == EVAL_OK && values[2] == 0.5,
+        "evaluateGrid() of 1/x does not flag 0 alone");
+    clearEvaluationErrors();
+
+    setStrictEvaluation(true);
+    bool threw = false;
+    try{ f->evaluate(0.0); }
+    catch(const std::runtime_error&){ threw = true; }
+    check(threw, "strict evaluate() of 1/0 does not throw");
+
+    threw = false;
+    try{ evaluateProgram(buildProgram(*f), 0.0); }
+    catch(const std::runtime_error&){ threw = true; }
+    check(threw, "strict evaluateProgram() of 1/0 does not throw");
+
+    check(f->evaluate(2.0) == 0.5, "strict evaluate() of 1/2 is not 0.5");
+    setStrictEvaluation(false);
+    clearEvaluationErrors();
+}
+
+/*
+    Binary expression files
+*/
+
+// Whether opening the file at path throws std::runtime_error
+static bool refused(const std::string& path){
+    try{ MappedExpressions mapped(path); }
+    catch(const std::runtime_error&){ return true; }
+    return false;
+}
+
+static void checkSerialization(){
+    std::string path = "/tmp/calculusChecks-" + std::to_string(getpid()) + ".ccxb";
+    std::shared_ptr<Function> f = buildFunction("sin(x)*x^2 - 3/(x + 1)");
+    std::vector<std::shared_ptr<Function>> roots = {f, f->derivative(), f->derivative()->derivative()};
+    ExpressionWriter writer;
+    for(const auto& root : roots) writer.add(*root);
+    writer.writeFile(path);
+
+    {
+        MappedExpressions mapped(path);
+        check(mapped.size() == roots.size(), "expression file holds " + std::to_string(mapped.size()) + " expressions");
+        for(size_t r = 0; r < roots.size(); r++){
+            std::shared_ptr<Function> loaded = mapped.load(r);
+            for(double x : grid(-0.9, 3.0, 41)){
+                double y = roots[r]->evaluate(x);
+                check(agrees(mapped.evaluate(r, x), y, 0.0) && agrees(loaded->evaluate(x), y, 0.0),
+                    "expression file root " + std::to_string(r) + " differs at " + std::to_string(x));
+            }
+        }
+    }
+
+    // Corrupted copies: a bad magic, a child that is not below its parent, a truncated node array
+    std::ifstream in(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    const SerializedHeader* header = reinterpret_cast<const SerializedHeader*>(bytes.data());
+    uint32_t last = header->nodeCount - 1;
+    auto corrupted = [&](const std::string& copy){
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << copy;
+        return refused(path);
+    };
+    std::string copy = bytes;
+    copy[0] = 'X';
+    check(corrupted(copy), "expression file with a bad magic is opened");
+    copy = bytes;
+    std::memcpy(&copy[sizeof(SerializedHeader) + last * sizeof(SerializedNode) + offsetof(SerializedNode, child)], &last, sizeof(last));
+    check(corrupted(copy), "expression file with a cyclic child index is opened");
+    check(corrupted(bytes.substr(0, sizeof(SerializedHeader) + sizeof(SerializedNode))), "truncated expression file is opened");
+    std::remove(path.c_str());
+}
+
+/*
+    Derivative service
+*/
+
+static void checkService(){
+    ComplexityBudget budget;
+    budget.maxNodes = 10000;
+    DerivativeService service(100, budget, 20);
+    check(service.handle("PARSE x^2") == "OK x^2", "PARSE x^2 answers " + service.handle("PARSE x^2"));
+    check(service.handle("EVAL 1 0.5,2 x^3") == "OK 0.75 12", "EVAL 1 0.5,2 x^3 answers " + service.handle("EVAL 1 0.5,2 x^3"));
+    std::string derived = service.handle("DERIVE 2 sin(x)");
+    check(derived.compare(0, 3, "OK ") == 0 && agrees(buildFunction(derived.substr(3))->evaluate(0.7), -std::sin(0.7), 1e-15),
+        "DERIVE 2 sin(x) answers " + derived);
+    for(const char* request : {"DERIVE 21 x", "DERIVE -1 x", "EVAL 12 0.5 sin(x)*cos(x)", "PARSE sin(", "FROB x"}){
+        std::string response = service.handle(request);
+        check(response.compare(0, 6, "ERROR ") == 0, std::string(request) + " answers " + response);
+    }
+
+    // Orders are built from the highest cached order, one at a time
+    service.handle("DERIVE 4 x^6");
+    std::string stats = service.handle("STATS");
+    size_t misses = service.cacheMisses();
+    service.handle("DERIVE 5 x^6");
+    check(service.cacheMisses() == misses + 1, "DERIVE 5 after DERIVE 4 builds " + std::to_string(service.cacheMisses() - misses) + " orders");
+    check(stats.compare(0, 8, "OK hits=") == 0, "STATS answers " + stats);
+}
+
+/*
+    Parameters
+*/
+
+static void checkParameters(){
+    auto table = std::make_shared<ParameterTable>();
+    table->define("a", 2.0);
+    table->define("b", 2.0);
+    std::shared_ptr<Function> f = buildFunction("a*sin(x) + b*x^2 + 3", table);
+    std::vector<double> xs = grid(-2.0, 2.0, 33);
+    ParametricEvaluator evaluator(*f, table, xs);
+    evaluator.evaluate();
+    size_t all = evaluator.lastRecomputed();
+
+    table->set("a", -1.5);
+    const std::vector<double>& values = evaluator.evaluate();
+    check(evaluator.lastRecomputed() < all, "rebinding a recomputes " + std::to_string(evaluator.lastRecomputed()) + " of "
+        + std::to_string(all) + " nodes");
+    for(size_t i = 0; i < xs.size(); i++){
+        double y = -1.5 * std::sin(xs[i]) + 2.0 * xs[i] * xs[i] + 3.0;
+        check(agrees(values[i], y, 1e-15) && agrees(f->evaluate(xs[i]), y, 1e-15),
+            "a*sin(x) + b*x^2 + 3 after rebinding a differs at " + std::to_string(xs[i]));
+    }
+
+    // a and b hold equal values, but a program keeps them apart
+    table->set("a", 2.0);
+    Program program = buildProgram(*buildFunction("a + b", table));
+    check(program.instructions.size() == 3, "a + b with a = b compiles to " + std::to_string(program.instructions.size()) + " instructions");
+    check(agrees(f->derivative()->evaluate(1.0), 2.0 * std::cos(1.0) + 4.0, 1e-15), "derivative of a*sin(x) + b*x^2 + 3 differs at 1");
+}
+
+/*
+    Generated code
+*/
+
+static const char* compiledExpressions[] = {"sin(x)*cos(2*x) + e^(sin(x)) - ln(x^2 + 1)*tan(x/3)",
+    "sinh(x/4)*cos(x) + x^2.5", "(x^3 - 2*x)/(x^2 + 1) + arctan(x)", "sec(x)*tan(x) + csc(x + 2)"};
+
+static void checkCodegen(){
+    // A private cache for this run, so that nothing from earlier builds is loaded
+    char directory[] = "/tmp/calculusChecks-XXXXXX";
+    if(!mkdtemp(directory)) throw std::runtime_error("Error cannot create a temporary directory");
+    CodegenOptions options;
+    options.cacheDirectory = directory;
+    std::vector<double> xs = grid(0.05, 6.0, 997);
+    for(const char* expr : compiledExpressions){
+        std::shared_ptr<Function> f = buildFunction(expr);
+        std::shared_ptr<CompiledFunction> compiled;
+        try{
+            compiled = compileFunction(*f, options);
+        }
+        catch(const std::runtime_error& error){
+            // No C compiler here: nothing to compare
+            skipped++;
+            std::printf("SKIP generated code of %s: %s\n", expr, error.what());
+            continue;
+        }
+        check(!compiled->wasCached() && compileFunction(*f, options)->wasCached(), std::string("generated code of ") + expr + " is not cached");
+        std::vector<double> out;
+        compiled->evaluate(xs, out);
+        for(size_t i = 0; i < xs.size(); i++){
+            // The generated code does not snap to 0 and 1 (codegen.h)
+            double y = f->evaluate(xs[i]);
+            check(agrees((*compiled)(xs[i]), y, 1e-9) && agrees(out[i], y, 1e-9),
+                std::string("generated code of ") + expr + " differs at " + std::to_string(xs[i]));
+        }
+    }
+    std::string remove = std::string("rm -rf ") + directory;
+    check(std::system(remove.c_str()) == 0, std::string("cannot remove ") + directory);
+}
+
+/*
+    JIT
+*/
+
+static void checkJit(){
+    std::vector<double> xs = grid(0.05, 6.0, 997);
+    for(const char* expr : compiledExpressions){
+        std::shared_ptr<Function> f = buildFunction(expr);
+        for(bool allowNative : {true, false}){
+            std::shared_ptr<JitFunction> jit = jitCompile(*f, allowNative);
+            std::vector<double> out;
+            jit->evaluate(xs, out);
+            for(size_t i = 0; i < xs.size(); i++){
+                double y = f->evaluate(xs[i]);
+                check(agrees((*jit)(xs[i]), y, 0.0) && agrees(out[i], y, 0.0),
+                    std::string(allowNative ? "JIT" : "interpreted JIT") + " of " + expr + " differs at " + std::to_string(xs[i]));
+            }
+        }
+    }
+
+    // Strict mode runs the interpreter, so the exception does not cross generated code
+    std::shared_ptr<JitFunction> reciprocal = jitCompile(*buildFunction("1/x"));
+    setStrictEvaluation(true);
+    bool threw = false;
+    try{ (*reciprocal)(0.0); }
+    catch(const std::runtime_error&){ threw = true; }
+    setStrictEvaluation(false);
+    clearEvaluationErrors();
+    check(threw, "strict JIT of 1/0 does not throw");
+}
+
+/*
+    Complexity budgets
+*/
+
+static void checkBudgets(){
+    std::shared_ptr<Function> f = buildFunction("sin(x)*e^(x)/(x^2 + 1)");
+    std::shared_ptr<Function> symbolic = f;
+    for(int order = 0; order < 5; order++) symbolic = symbolic->derivative();
+
+    ComplexityBudget budget;
+    budget.maxNodes = 200;
+    bool threw = false;
+    try{ differentiate(f, 5, budget); }
+    catch(const std::runtime_error&){ threw = true; }
+    check(threw, "5th derivative of sin(x)*e^(x)/(x^2 + 1) within 200 nodes does not throw");
+
+    budget.onExceeded = BudgetAction::Numeric;
+    GuardedDerivative numeric = differentiate(f, 5, budget);
+    check(!numeric.isSymbolic() && numeric.exceeded() != nullptr, "5th derivative within 200 nodes is not numeric");
+    check(differentiate(f, 5, ComplexityBudget()).isSymbolic(), "5th derivative without a budget is not symbolic");
+    std::vector<double> xs = grid(-2.0, 2.0, 41), values;
+    numeric.evaluate(xs, values);
+    for(size_t i = 0; i < xs.size(); i++){
+        double y = symbolic->evaluate(xs[i]);
+        check(agrees(numeric.evaluate(xs[i]), y, 1e-9) && agrees(values[i], y, 1e-9),
+            "Taylor mode 5th derivative differs at " + std::to_string(xs[i]));
+    }
+}
+
+/*
+    Flat expressions
+*/
+
+static void checkFlatExpressions(){
+    std::shared_ptr<Function> f = buildFunction("sin(x^2)*ln(x + 2) - 3/(x + 1) + cosh(x)");
+    FlatExpression flat(f);
+    FlatExpression flatDerivative = flat.derivative();
+    std::shared_ptr<Function> tree = f->derivative();
+    std::vector<double> xs = grid(-0.5, 3.0, 36), values;
+    flatDerivative.evaluate(xs, values);
+    for(size_t i = 0; i < xs.size(); i++){
+        check(agrees(flat.evaluate(xs[i]), f->evaluate(xs[i]), 0.0), "flat expression differs at " + std::to_string(xs[i]));
+        double y = tree->evaluate(xs[i]);
+        check(agrees(flatDerivative.evaluate(xs[i]), y, 1e-15) && agrees(values[i], y, 1e-15),
+            "flat derivative differs from the tree derivative at " + std::to_string(xs[i]));
+    }
+    check(agrees(flatDerivative.toFunction()->evaluate(0.7), tree->evaluate(0.7), 1e-15), "flat derivative rebuilt as a tree differs at 0.7");
+    check(FlatExpression(buildFunction("x*sin(x) + 2")).hash() == FlatExpression(buildFunction("2 + sin(x)*x")).hash(),
+        "x*sin(x) + 2 and 2 + sin(x)*x hash differently");
+}
+
+/*
+    Deep trees
+*/
+
+static void checkDeepTrees(){
+    std::shared_ptr<Function> f = buildFunction("sin(x)*e^(x) + ln(x + 2)/(x^2 + 1)");
+    check(evaluateIterative(*f, 0.4) == f->evaluate(0.4), "iterative evaluation of a shallow tree differs from evaluate()");
+
+    // 0.5*x + 1*x + 1.5*x + ... chained to the left, far deeper than the call stack allows
+    const int terms = 100000;
+    std::shared_ptr<Function> x = std::make_shared<Variable>("x");
+    std::shared_ptr<Function> chain = std::make_shared<Product>(std::make_shared<Constant>(0.5), x);
+    for(int k = 2; k <= terms; k++){
+        chain = std::make_shared<Sum>(chain, std::make_shared<Product>(std::make_shared<Constant>(0.5*k), x));
+    }
+    check(isDeep(*chain), "a chain of 100000 sums is not deep");
+    double slope = 0.25*terms*(terms + 1.0);
+    check(agrees(evaluateIterative(*chain, 2.0), 2.0*slope, 1e-12), "iterative evaluation of the chain is wrong");
+    check(agrees(evaluateIterative(*derivativeIterative(chain), 2.0), slope, 1e-12), "iterative derivative of the chain is wrong");
+    check(agrees(evaluateIterative(*simplifyIterative(chain), 2.0), 2.0*slope, 1e-12), "iterative simplify changes the value of the chain");
+    std::shared_ptr<Function> balanced = rebalance(chain);
+    check(!isDeep(*balanced), "a rebalanced chain is still deep");
+    check(agrees(balanced->evaluate(2.0), 2.0*slope, 1e-12), "rebalancing changes the value of the chain");
+}
+
+/*
+    Parallel traversals
+*/
+
+static void checkParallelTraversals(){
+    TaskPool pool(4);
+    // A grain of 8 nodes makes nearly every node fork, so the tasks really interleave
+    std::shared_ptr<Function> f = buildFunction("sin(x^2)*e^(cos(x)) + ln(x^2 + 1)*tan(x/3) - (x + 1)^3*sec(x)");
+    for(int order = 1; order <= 3; order++){
+        std::shared_ptr<Function> serial = f->derivative();
+        std::shared_ptr<Function> parallel = parallelDerivative(f, pool, 8);
+        check(toString(*parallel) == toString(*serial), "parallel derivative " + std::to_string(order) + " prints differently");
+        check(toString(*parallelSimplify(serial, pool, 8)) == toString(*serial->simplify()),
+            "parallel simplify of derivative " + std::to_string(order) + " prints differently");
+        check(parallel->evaluate(0.6) == serial->evaluate(0.6), "parallel derivative " + std::to_string(order) + " evaluates differently");
+        f = serial;
+    }
+}
+
+/*
+    Complex step
+*/
+
+static void checkComplexStep(){
+    std::shared_ptr<Function> f = buildFunction("e^(sin(x))/(x^2 + 1) + arctan(x)*ln(x + 3) - cosh(x)^2");
+    std::shared_ptr<Function> d = f->derivative();
+    std::vector<double> xs = grid(-2.0, 2.0, 41), out;
+    complexStepDerivative(*f, xs, out);
+    for(size_t i = 0; i < xs.size(); i++){
+        double step = complexStepDerivative(*f, xs[i]);
+        check(agrees(step, d->evaluate(xs[i]), 1e-12), "complex step differs from derivative() at " + std::to_string(xs[i]));
+        check(out[i] == step, "batch complex step differs from the scalar one at " + std::to_string(xs[i]));
+    }
+    DerivativeCheck result = checkDerivative(*f, xs);
+    check(result.points == xs.size() && result.mismatches == 0, "checkDerivative reports mismatches on a correct derivative");
+}
+
+/*
+    Batch evaluation
+*/
+
+static void checkBatchLayout(){
+    std::shared_ptr<Function> f = buildFunction("sin(x)*e^(x/2) + 1/(x^2 + 1)");
+    std::vector<std::shared_ptr<Function>> roots = {f, f->derivative(), f->derivative()->derivative(), buildFunction("x^3 - x")};
+    // More points than one block of runBlocks(), so the layout is checked across blocks
+    std::vector<double> xs = grid(-3.0, 3.0, 601), values, outputs;
+    evaluateBatch(roots, xs, values);
+    Program program = buildProgram(roots);
+    evaluateOutputs(program, xs, outputs);
+    check(values.size() == roots.size() * xs.size() && outputs.size() == values.size(), "batch results have the wrong size");
+    bool batchMatches = true, outputsMatch = true;
+    for(size_t j = 0; j < roots.size() && values.size() == outputs.size(); j++){
+        for(size_t i = 0; i < xs.size(); i++){
+            batchMatches = batchMatches && agrees(values[j * xs.size() + i], roots[j]->evaluate(xs[i]), 1e-14);
+            outputsMatch = outputsMatch && outputs[j * xs.size() + i] == evaluateProgram(program, xs[i], j);
+        }
+    }
+    check(batchMatches, "evaluateBatch is not column-major in the roots");
+    check(outputsMatch, "evaluateOutputs differs from evaluateProgram for some output");
+}
+
+/*
+    Transcendental fusion
+*/
+
+static void checkFusion(){
+    const char* expressions[] = {"tan(x)*sec(x) + sin(x)*cos(x)", "sinh(x)*cosh(x) - tanh(x)", "ln(x + 2)*ln(x + 2) + (x + 2)^x"};
+    std::vector<double> xs = grid(-1.2, 1.2, 25), out;
+    for(const char* expression : expressions){
+        std::shared_ptr<Function> f = buildFunction(expression);
+        Program program = buildProgram(*f->derivative());
+        FusedProgram fused = fuseTranscendentals(program);
+        check(fused.savedCalls > 0, std::string("nothing fused in the derivative of ") + expression);
+        evaluateFused(fused, xs, out);
+        for(size_t i = 0; i < xs.size(); i++){
+            double y = evaluateProgram(program, xs[i]);
+            check(agrees(evaluateFused(fused, xs[i]), y, 1e-12) && agrees(out[i], y, 1e-12),
+                std::string("fused derivative of ") + expression + " differs at " + std::to_string(xs[i]));
+        }
+    }
+}
+
+/*
+    Guard removal
+*/
+
+static void checkGuards(){
+    Program program = buildProgram(*buildFunction("sin(x)/x + sec(x) - arccot(x + 4)"));
+
+    UnguardedProgram inside = removeGuards(program, Interval(0.001, 1.5));
+    check(inside.removedGuards == 3 && inside.remainingGuards == 0,
+        "guards of sin(x)/x + sec(x) - arccot(x + 4) over [0.001, 1.5]: removed " + std::to_string(inside.removedGuards)
+        + ", kept " + std::to_string(inside.remainingGuards));
+    UnguardedProgram across = removeGuards(program, Interval(-1.0, 2.0));
+    check(across.removedGuards == 1 && across.remainingGuards == 2,
+        "guards of sin(x)/x + sec(x) - arccot(x + 4) over [-1, 2]: removed " + std::to_string(across.removedGuards)
+        + ", kept " + std::to_string(across.remainingGuards));
+
+    std::vector<double> xs = grid(0.001, 1.5, 1001);
+    std::vector<double> expected, unguarded;
+    evaluateProgram(program, xs, expected);
+    evaluateUnguarded(inside, xs, unguarded);
+    for(size_t i = 0; i < xs.size(); i++){
+        check(agrees(unguarded[i], expected[i], 0.0) && agrees(evaluateUnguarded(inside, xs[i]), expected[i], 0.0),
+            "unguarded evaluation differs at " + std::to_string(xs[i]));
+    }
+
+    // Outside the domain the guards are back: 0 still divides by zero
+    clearEvaluationErrors();
+    double y = evaluateUnguarded(inside, 0.0);
+    check(std::isnan(y) || std::isinf(y), "unguarded evaluation outside the domain skips the guard");
+    check(evaluationErrors() & EVAL_DIVIDE_BY_ZERO, "unguarded evaluation outside the domain records no division by zero");
+    clearEvaluationErrors();
+}
+
+int main(){
+    checkIntervals();
+    checkDivisionByZero();
+    checkSerialization();
+    checkService();
+    checkParameters();
+    checkCodegen();
+    checkJit();
+    checkBudgets();
+    checkFlatExpressions();
+    checkDeepTrees();
+    checkParallelTraversals();
+    checkComplexStep();
+    checkBatchLayout();
+    checkFusion();
+    checkGuards();
+    std::printf("%d failed, %d skipped\n", failures, skipped);
+    return failures;
+}
@@ -0,0 +1,306 @@
+#include "Functions.h"
+#include "expressionSplit.h"
+#include "printer.h"
+#include "instrumentation.h"
+#include "tracing.h"
+#include "complexity.h"
+#include "traversal.h"
+#include "parallelTraversal.h"
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <condition_variable>
+
+/*
+    Streaming batch command line interface
+    Reads one expression per line from the given files (or stdin if there are none) and runs every
+    line through parse -> derivative (--order times) -> simplify (optional) -> evaluate (--at points).
+    Lines are processed by a pool of worker threads and written in input order. At most --in-flight
+    lines are held in memory: the reader blocks until the writer catches up, so memory use does not
+    depend on the size of the input.
+
+    Output is one tab separated line per input line:
+        <derivative>	<value at x1>	<value at x2> ...
+    or "error: <message>" if the line could not be processed. With --numeric-fallback a derivative
+    over the complexity budget is evaluated numerically and printed as "numeric <order> <f>".
+*/
+
+struct CliOptions {
+    int order = 1;
+    bool simplify = false;
+    bool rebalance = false;
+    bool splitTrees = false;
+    TaskPool* treePool = nullptr;   // Set with splitTrees
+    std::vector<double> points;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t inFlight = 0;    // 0 = 4 lines per thread
+    std::string statsPath;  // Empty = no stats
+    std::string tracePath;  // Empty = no tracing
+    ComplexityBudget budget;
+    bool budgeted = false;  // A limit was given
+    std::vector<std::string> files;
+};
+
+static void usage(const char* program){
+    std::cerr << "usage: " << program << " [options] [files...]\n"
+        << "  -d, --order N       differentiate N times (default 1, 0 = only evaluate)\n"
+        << "  -s, --simplify      simplify the result before printing and evaluating\n"
+        << "  -b, --rebalance     rebalance chains of sums and products after parsing\n"
+        << "  -x, --at X          evaluate the result at X, can be given more than once\n"
+        << "  -j, --threads N     number of worker threads (default: number of cores)\n"
+        << "  -q, --in-flight N   maximum number of lines held in memory (default 4 per thread)\n"
+        << "  -p, --split-trees   also split large trees of one line over the threads\n"
+        << "      --stats FILE    write instrumentation stats as JSON to FILE (- for stderr)\n"
+        << "      --trace FILE    write a Chrome trace of every stage to FILE\n"
+        << "      --max-nodes N   fail lines whose derivative has more than N nodes\n"
+        << "      --max-dag N     fail lines whose derivative has more than N distinct nodes\n"
+        << "      --numeric-fallback  evaluate derivatives over the budget numerically instead of failing\n";
+}
+
+// Runs one input line through every stage and returns its output line
+static std::string processLine(const std::string& line, const CliOptions& options){
+    if(trim(line).empty()) return "";
+    TraceSpan span("line");
+    try{
+        std::shared_ptr<Function> f = buildFunction(line);
+        if(options.rebalance){
+            TraceSpan rebalanceSpan("rebalance");
+            f = rebalance(f);
+        }
+        if(options.budgeted){
+            TraceSpan derivativeSpan("derivative", "order", options.order);
+            GuardedDerivative guarded = differentiate(f, options.order, options.budget);
+            if(!guarded.isSymbolic()){
+                std::ostringstream out;
+                out.precision(17);
+                out << "numeric " << options.order << ' ';
+                print(*f, out);
+                std::vector<double> values;
+                guarded.evaluate(options.points, values);
+                for(double value : values){
+                    out << '\t' << value;
+                }
+                return out.str();
+            }
+            f = guarded.symbolic();
+        }
+        else{
+            for(int i = 0; i < options.order; i++){
+                TraceSpan derivativeSpan("derivative", "order", i + 1);
+                f = options.treePool ? parallelDerivative(f, *options.treePool) : f->derivative();
+            }
+        }
+        if(options.simplify){
+            TraceSpan simplifySpan("simplify");
+            if(options.treePool){
+                f = parallelSimplify(f, *options.treePool);
+            }
+            else{
+                f = isDeep(*f) ? simplifyIterative(f) : f->simplify();
+            }
+        }
+
+        std::ostringstream out;
+        out.precision(17);
+        {
+            // Lazy derivatives are built here when the result is not simplified
+            TraceSpan printSpan("print");
+            print(*f, out);
+        }
+        if(!options.points.empty()){
+            std::vector<double> values;
+            evaluateGrid(*f, options.points, values);
+            for(double value : values){
+                out << '\t' << value;
+            }
+        }
+        return out.str();
+    }
+    catch(const std::exception& error){
+        return std::string("error: ") + error.what();
+    }
+}
+
+// Bounded, order preserving pipeline between the reader, the workers and the writer
+class Pipeline {
+    std::mutex lock;
+    std::condition_variable inputReady;
+    std::condition_variable outputReady;
+    std::condition_variable spaceReady;
+
+    std::deque<std::pair<uint64_t, std::string>> input;
+    std::map<uint64_t, std::string> output;
+    uint64_t nextRead = 0;      // Sequence number of the next line read
+    uint64_t nextWrite = 0;     // Sequence number of the next line written
+    bool closed = false;
+
+    const CliOptions& options;
+    const size_t capacity;
+
+    public:
+    Pipeline(const CliOptions& opts, size_t cap) : options(opts), capacity(cap) {}
+
+    // Called by the reader, blocks while capacity lines are in flight
+    void push(std::string line){
+        std::unique_lock<std::mutex> guard(lock);
+        spaceReady.wait(guard, [this]{ return nextRead - nextWrite < capacity; });
+        input.emplace_back(nextRead++, std::move(line));
+        inputReady.notify_one();
+    }
+
+    // Called by the reader once every line has been pushed
+    void close(){
+        std::lock_guard<std::mutex> guard(lock);
+        closed = true;
+        inputReady.notify_all();
+        outputReady.notify_all();
+    }
+
+    void work(){
+        while(true){
+            std::pair<uint64_t, std::string> job;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                inputReady.wait(guard, [this]{ return !input.empty() || closed; });
+                if(input.empty()) return;
+                job = std::move(input.front());
+                input.pop_front();
+            }
+
+            std::string result = processLine(job.second, options);
+
+            std::lock_guard<std::mutex> guard(lock);
+            output.emplace(job.first, std::move(result));
+            if(job.first == nextWrite) outputReady.notify_one();
+        }
+    }
+
+    // Writes results in input order until every line has been written
+    void write(std::ostream& out){
+        std::unique_lock<std::mutex> guard(lock);
+        while(true){
+            outputReady.wait(guard, [this]{
+                return output.count(nextWrite) || (closed && nextWrite == nextRead);
+            });
+            if(!output.count(nextWrite)) return;
+
+            // Write every result that is ready without holding the lock
+            std::vector<std::string> ready;
+            for(auto next = output.find(nextWrite); next != output.end() && next->first == nextWrite; next = output.erase(next)){
+                ready.push_back(std::move(next->second));
+                nextWrite++;
+            }
+            spaceReady.notify_all();
+
+            guard.unlock();
+            for(const std::string& line : ready){
+                out << line << '\n';
+            }
+            guard.lock();
+        }
+    }
+};
+
+static bool parseOptions(int argc, char* argv[], CliOptions& options){
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if(arg == "-h" || arg == "--help") return false;
+        else if(arg == "-s" || arg == "--simplify") options.simplify = true;
+        else if(arg == "-b" || arg == "--rebalance") options.rebalance = true;
+        else if(arg == "-p" || arg == "--split-trees") options.splitTrees = true;
+        else if((arg == "-d" || arg == "--order") && hasValue) options.order = std::stoi(argv[++i]);
+        else if((arg == "-x" || arg == "--at") && hasValue) options.points.push_back(std::stod(argv[++i]));
+        else if((arg == "-j" || arg == "--threads") && hasValue) options.threads = std::max(1, std::stoi(argv[++i]));
+        else if((arg == "-q" || arg == "--in-flight") && hasValue) options.inFlight = std::max(1, std::stoi(argv[++i]));
+        else if(arg == "--stats" && hasValue) options.statsPath = argv[++i];
+        else if(arg == "--trace" && hasValue) options.tracePath = argv[++i];
+        else if(arg == "--max-nodes" && hasValue) options.budget.maxNodes = std::stoull(argv[++i]);
+        else if(arg == "--max-dag" && hasValue) options.budget.maxDagNodes = std::stoull(argv[++i]);
+        else if(arg == "--numeric-fallback") options.budget.onExceeded = BudgetAction::Numeric;
+        else if(arg.size() > 1 && arg[0] == '-') return false;
+        else options.files.push_back(arg);
+    }
+    ComplexityBudget unlimited;
+    options.budgeted = options.budget.maxNodes != unlimited.maxNodes || options.budget.maxDagNodes != unlimited.maxDagNodes;
+    return options.order >= 0;
+}
+
+int main(int argc, char* argv[]){
+    CliOptions options;
+    try{
+        if(!parseOptions(argc, argv, options)){
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    catch(const std::exception&){
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::ios::sync_with_stdio(false);
+    setTracing(!options.tracePath.empty());
+    std::unique_ptr<TaskPool> treePool;
+    if(options.splitTrees){
+        treePool = std::make_unique<TaskPool>(options.threads);
+        options.treePool = treePool.get();
+    }
+    size_t capacity = options.inFlight ? options.inFlight : 4 * options.threads;
+    Pipeline pipeline(options, capacity);
+
+    std::vector<std::thread> workers;
+    for(unsigned i = 0; i < options.threads; i++){
+        workers.emplace_back(&Pipeline::work, &pipeline);
+    }
+    std::thread writer(&Pipeline::write, &pipeline, std::ref(std::cout));
+
+    int status = 0;
+    std::string line;
+    if(options.files.empty()){
+        while(std::getline(std::cin, line)) pipeline.push(std::move(line));
+    }
+    for(const std::string& path : options.files){
+        std::ifstream file(path);
+        if(!file){
+            std::cerr << "error: cannot open " << path << '\n';
+            status = 1;
+            continue;
+        }
+        while(std::getline(file, line)) pipeline.push(std::move(line));
+    }
+    pipeline.close();
+
+    for(std::thread& worker : workers) worker.join();
+    writer.join();
+    std::cout.flush();
+
+    if(!options.tracePath.empty()){
+        std::ofstream trace(options.tracePath);
+        writeTrace(trace);
+        if(!trace){
+            std::cerr << "error: cannot write " << options.tracePath << '\n';
+            status = 1;
+        }
+    }
+    if(options.statsPath == "-"){
+        writeInstrumentationJson(std::cerr);
+        std::cerr << '\n';
+    }
+    else if(!options.statsPath.empty()){
+        std::ofstream stats(options.statsPath);
+        writeInstrumentationJson(stats);
+        stats << '\n';
+        if(!stats){
+            std::cerr << "error: cannot write " << options.statsPath << '\n';
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,241 @@
+#include "chebyshev.h"
+#include "tracing.h"
+
+#include <cmath>
+#include <complex>
+#include <algorithm>
+#include <stdexcept>
+
+/*
+    Proxy evaluation and calculus
+*/
+
+void ChebyshevProxy::addPiece(double lower, double upper, const std::vector<double>& c){
+    if(breakpoints.empty()){
+        breakpoints.push_back(lower);
+        offsets.push_back(0);
+    }
+    breakpoints.push_back(upper);
+    coefficients.insert(coefficients.end(), c.begin(), c.end());
+    offsets.push_back(coefficients.size());
+}
+
+size_t ChebyshevProxy::pieceOf(double x) const{
+    // Interior breakpoints only, so x outside the range maps to the first or last piece
+    auto it = std::upper_bound(breakpoints.begin() + 1, breakpoints.end() - 1, x);
+    return it - (breakpoints.begin() + 1);
+}
+
+// Clenshaw recurrence for sum c_k T_k(t)
+static double clenshaw(const double* c, size_t n, double t){
+    if(n == 0) return 0.0;
+    double b1 = 0.0, b2 = 0.0;
+    for(size_t k = n - 1; k >= 1; k--){
+        double b0 = c[k] + 2.0 * t * b1 - b2;
+        b2 = b1;
+        b1 = b0;
+    }
+    return c[0] + t * b1 - b2;
+}
+
+double ChebyshevProxy::operator()(double x) const{
+    size_t i = pieceOf(x);
+    double lo = breakpoints[i], hi = breakpoints[i + 1];
+    double t = (2.0 * x - lo - hi) / (hi - lo);
+    return clenshaw(coefficients.data() + offsets[i], offsets[i + 1] - offsets[i], t);
+}
+
+void ChebyshevProxy::evaluate(const std::vector<double>& xs, std::vector<double>& out) const{
+    out.resize(xs.size());
+    for(size_t i = 0; i < xs.size(); i++) out[i] = (*this)(xs[i]);
+}
+
+// (sum c_k T_k)' = sum d_k T_k with d_{k-1} = d_{k+1} + 2k c_k, scaled by dt/dx
+ChebyshevProxy ChebyshevProxy::derivative() const{
+    ChebyshevProxy result;
+    for(size_t i = 0; i < pieceCount(); i++){
+        const double* c = coefficients.data() + offsets[i];
+        size_t n = offsets[i + 1] - offsets[i];
+        double scale = 2.0 / (breakpoints[i + 1] - breakpoints[i]);
+        std::vector<double> d(n > 1 ? n - 1 : 1, 0.0);
+        double next = 0.0, nextNext = 0.0;      // d_{k}, d_{k+1}
+        for(size_t k = n - 1; k >= 1 && n > 1; k--){
+            double current = nextNext + 2.0 * k * c[k];
+            d[k - 1] = current;
+            nextNext = next;
+            next = current;
+        }
+        d[0] *= 0.5;
+        for(double& value : d) value *= scale;
+        result.addPiece(breakpoints[i], breakpoints[i + 1], d);
+    }
+    return result;
+}
+
+// int T_0 = T_1, int T_k = T_{k+1} / (2(k+1)) - T_{k-1} / (2(k-1)), scaled by dx/dt
+ChebyshevProxy ChebyshevProxy::integral() const{
+    ChebyshevProxy result;
+    double total = 0.0;
+    for(size_t i = 0; i < pieceCount(); i++){
+        const double* c = coefficients.data() + offsets[i];
+        size_t n = offsets[i + 1] - offsets[i];
+        double scale = 0.5 * (breakpoints[i + 1] - breakpoints[i]);
+        auto at = [&](size_t k){ return k < n ? c[k] : 0.0; };
+
+        std::vector<double> C(n + 1, 0.0);
+        if(n > 0) C[1] = (at(0) - 0.5 * at(2)) * scale;
+        for(size_t k = 2; k <= n; k++) C[k] = (at(k - 1) - at(k + 1)) / (2.0 * k) * scale;
+
+        // The constant term makes the piece start at the end value of the previous one
+        double atStart = 0.0, atEnd = 0.0;
+        for(size_t k = 1; k <= n; k++){
+            atStart += k % 2 ? -C[k] : C[k];
+            atEnd += C[k];
+        }
+        C[0] = total - atStart;
+        total = C[0] + atEnd;
+        result.addPiece(breakpoints[i], breakpoints[i + 1], C);
+    }
+    return result;
+}
+
+// int_{-1}^{1} T_k = 2 / (1 - k^2) for even k, 0 for odd k
+double ChebyshevProxy::integrate() const{
+    double total = 0.0;
+    for(size_t i = 0; i < pieceCount(); i++){
+        double sum = 0.0;
+        for(size_t k = 0; k < offsets[i + 1] - offsets[i]; k += 2){
+            sum += coefficients[offsets[i] + k] * 2.0 / (1.0 - double(k) * k);
+        }
+        total += 0.5 * (breakpoints[i + 1] - breakpoints[i]) * sum;
+    }
+    return total;
+}
+
+/*
+    Construction
+*/
+
+static const size_t FIRST_LEVEL = 16;          // Intervals between points at the first level
+static const size_t LAST_LEVEL = 64;
+static const int MAX_DEPTH = 48;
+
+// In place radix 2 FFT, size is a power of 2
+static void fft(std::vector<std::complex<double>>& data){
+    size_t n = data.size();
+    for(size_t i = 1, j = 0; i < n; i++){
+        size_t bit = n >> 1;
+        for(; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if(i < j) std::swap(data[i], data[j]);
+    }
+    for(size_t length = 2; length <= n; length <<= 1){
+        std::complex<double> step = std::polar(1.0, -2.0 * M_PI / length);
+        for(size_t start = 0; start < n; start += length){
+            std::complex<double> w = 1.0;
+            for(size_t k = 0; k < length / 2; k++){
+                std::complex<double> even = data[start + k];
+                std::complex<double> odd = data[start + k + length / 2] * w;
+                data[start + k] = even + odd;
+                data[start + k + length / 2] = even - odd;
+                w *= step;
+            }
+        }
+    }
+}
+
+/**
+ * Coefficients of the interpolant through values[j] = f(cos(pi j / n)), j = 0..n (a DCT-I)
+ *
+ * Precondition: values.size() = n + 1, n is a power of 2
+ * Postcondition: sum c_k T_k(cos(pi j / n)) = values[j] for every j
+ */
+static std::vector<double> chebyshevCoefficients(const std::vector<double>& values){
+    size_t n = values.size() - 1;
+    // Even extension of length 2n, its FFT is the cosine transform
+    std::vector<std::complex<double>> data(2 * n);
+    for(size_t j = 0; j <= n; j++) data[j] = values[j];
+    for(size_t j = 1; j < n; j++) data[2 * n - j] = values[j];
+    fft(data);
+
+    std::vector<double> c(n + 1);
+    for(size_t k = 0; k <= n; k++) c[k] = data[k].real() / n;
+    c[0] *= 0.5;
+    c[n] *= 0.5;
+    return c;
+}
+
+static double sample(const Function& f, double x){
+    double value = f.evaluate(x);
+    if(!std::isfinite(value)){
+        throw std::runtime_error("Error cannot approximate, f is not finite at x = " + std::to_string(x));
+    }
+    return value;
+}
+
+// Values at the Chebyshev points of [lo, hi] for n intervals, refined from the values for n / 2
+static std::vector<double> refine(const Function& f, double lo, double hi, const std::vector<double>& coarse, size_t n){
+    double middle = 0.5 * (lo + hi), half = 0.5 * (hi - lo);
+    std::vector<double> values(n + 1);
+    for(size_t j = 0; j <= n; j++){
+        if(j % 2 == 0 && !coarse.empty()) values[j] = coarse[j / 2];
+        else values[j] = sample(f, middle + half * std::cos(M_PI * j / n));
+    }
+    return values;
+}
+
+/**
+ * Truncates a series once its tail is negligible
+ *
+ * Precondition: c holds the coefficients of an interpolant
+ * Postcondition: returns the shortest prefix whose dropped tail sums to at most tolerance / 4 in
+ *                absolute value, or an empty vector if that prefix is longer than 3/4 of c
+ *                (the series has not decayed yet)
+ */
+static std::vector<double> chop(const std::vector<double>& c, double tolerance){
+    size_t length = c.size();
+    double tail = 0.0;
+    while(length > 1 && tail + std::abs(c[length - 1]) <= 0.25 * tolerance){
+        tail += std::abs(c[length - 1]);
+        length--;
+    }
+    if(4 * length > 3 * c.size()) return {};
+    return std::vector<double>(c.begin(), c.begin() + length);
+}
+
+static void resolve(const Function& f, double lo, double hi, double tolerance, int depth, ChebyshevProxy& proxy){
+    double middle = 0.5 * (lo + hi), half = 0.5 * (hi - lo);
+    std::vector<double> values = refine(f, lo, hi, {}, FIRST_LEVEL);
+    for(size_t n = FIRST_LEVEL; n <= LAST_LEVEL; n *= 2){
+        std::vector<double> finer = refine(f, lo, hi, values, 2 * n);
+        std::vector<double> candidate = chop(chebyshevCoefficients(values), tolerance);
+        if(!candidate.empty()){
+            // The odd points of the finer level lie between the points used for the fit
+            bool accepted = true;
+            for(size_t j = 1; j < 2 * n && accepted; j += 2){
+                double t = std::cos(M_PI * j / (2 * n));
+                accepted = std::abs(clenshaw(candidate.data(), candidate.size(), t) - finer[j]) <= tolerance;
+            }
+            if(accepted){
+                proxy.addPiece(lo, hi, candidate);
+                return;
+            }
+        }
+        values = std::move(finer);
+    }
+
+    if(depth >= MAX_DEPTH || middle <= lo || middle >= hi || half <= 0.0){
+        throw std::runtime_error("Error cannot approximate f within the tolerance near x = " + std::to_string(middle));
+    }
+    resolve(f, lo, middle, tolerance, depth + 1, proxy);
+    resolve(f, middle, hi, tolerance, depth + 1, proxy);
+}
+
+ChebyshevProxy approximate(const Function& f, double a, double b, double tolerance){
+    TraceSpan span("approximate");
+    if(!(a < b) || !std::isfinite(a) || !std::isfinite(b)) throw std::runtime_error("Error invalid interval for approximation");
+    if(!(tolerance > 0.0)) throw std::runtime_error("Error approximation tolerance must be positive");
+    ChebyshevProxy proxy;
+    resolve(f, a, b, tolerance, 0, proxy);
+    return proxy;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "Functions.h"
+
+/*
+    Chebyshev proxies
+    approximate() samples a Function tree at Chebyshev points and replaces it by a piecewise
+    Chebyshev series on [a, b]. Each piece is resolved adaptively: the number of points doubles
+    (17, 33, 65, reusing the values already computed) until the coefficients decay below the
+    tolerance, otherwise the piece is split in two. Short pieces of low degree keep evaluation cheap.
+    Coefficients come from a DCT computed with an FFT.
+    Evaluating the proxy is a binary search for the piece and a Clenshaw recurrence, with no virtual
+    calls and no allocation.
+
+    Error: every piece is checked against f at the midpoints between its sample points as well, and
+    accepted only if the absolute error is at most tol at all of them. This is a sampled check, not a
+    proof: features narrower than the point spacing can be missed.
+*/
+class ChebyshevProxy {
+    std::vector<double> breakpoints;        // Piece i covers [breakpoints[i], breakpoints[i + 1]]
+    std::vector<size_t> offsets;            // Coefficients of piece i: [offsets[i], offsets[i + 1])
+    std::vector<double> coefficients;       // c_k of sum c_k T_k(t), t mapped from the piece to [-1, 1]
+
+    size_t pieceOf(double x) const;
+
+    public:
+    ChebyshevProxy() = default;
+
+    /**
+     * Appends a piece covering [breakpoints.back(), upper]
+     *
+     * Precondition: upper > upper() (or this is the first piece, then lower is used as its start)
+     * Postcondition: the proxy covers [lower(), upper], c holds the coefficients of the new piece
+     */
+    void addPiece(double lower, double upper, const std::vector<double>& c);
+
+    // Value at x, pieces are extrapolated outside [lower(), upper()]
+    double operator()(double x) const;
+
+    // out[i] = proxy(xs[i]) for every i
+    void evaluate(const std::vector<double>& xs, std::vector<double>& out) const;
+
+    /**
+     * Differentiates every piece, O(number of coefficients)
+     *
+     * Precondition: None
+     * Postcondition: the derivative of the proxy. Its error is not bounded by the tolerance of f,
+     *                each derivative loses about a factor of n^2 / (b - a) in accuracy
+     */
+    ChebyshevProxy derivative() const;
+
+    /**
+     * Antiderivative, O(number of coefficients)
+     *
+     * Precondition: None
+     * Postcondition: F(lower()) = 0, F' = proxy and F is continuous across the pieces
+     */
+    ChebyshevProxy integral() const;
+
+    // Integral of the proxy over [lower(), upper()]
+    double integrate() const;
+
+    double lower() const { return breakpoints.empty() ? 0.0 : breakpoints.front(); }
+    double upper() const { return breakpoints.empty() ? 0.0 : breakpoints.back(); }
+    size_t pieceCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    size_t coefficientCount() const { return coefficients.size(); }
+};
+
+/**
+ * Builds a piecewise Chebyshev approximation of f on [a, b]
+ *
+ * Precondition: a < b, tolerance > 0, f is finite on [a, b]
+ * Postcondition: |proxy(x) - f(x)| <= tolerance at every sampled and checked point, throws
+ *                std::runtime_error if f is not finite at a sample point or cannot be resolved
+ */
+ChebyshevProxy approximate(const Function& f, double a, double b, double tolerance = 1e-10);
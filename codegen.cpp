@@ -0,0 +1,339 @@
+#include "codegen.h"
+#include "instrumentation.h"
+#include "tracing.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <stdexcept>
+#include <filesystem>
+#include <atomic>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*
+    Source generation
+*/
+
+// Shortest literal that reads back as the same double
+static std::string literal(double value){
+    if(std::isnan(value)) return "NAN";
+    if(std::isinf(value)) return value > 0 ? "INFINITY" : "(-INFINITY)";
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    std::string text = buffer;
+    if(text.find_first_of(".en") == std::string::npos) text += ".0";
+    return value < 0 || std::signbit(value) ? "(" + text + ")" : text;
+}
+
+static bool isConstant(const Program& program, uint32_t index, double value){
+    const Instruction& instruction = program.instructions[index];
+    return instruction.kind == NodeKind::Constant && instruction.payload == value;
+}
+
+namespace {
+
+class SourceWriter {
+    const Program& program;
+    const CodegenOptions& options;
+    std::vector<uint32_t> uses;
+    std::vector<bool> fused;            // Products folded into an fma by their only user
+    std::vector<int> sinCosNeeded;      // Per argument: bit 1 = sin needed, bit 2 = cos needed
+    std::vector<bool> sinCosDone;
+    std::ostringstream out;
+
+    std::string operand(uint32_t index) const{
+        const Instruction& instruction = program.instructions[index];
+        if(instruction.kind == NodeKind::Constant) return literal(instruction.payload);
+        if(instruction.kind == NodeKind::Variable) return "x";
+        return "t" + std::to_string(index);
+    }
+
+    bool fusable(uint32_t index) const{
+        return options.useFma && program.instructions[index].kind == NodeKind::Product && uses[index] == 1;
+    }
+
+    // sin and cos of the argument, computed once with sincos() when both are needed
+    std::string sinCos(uint32_t argument, bool cosine){
+        const std::string name = (cosine ? "c" : "s") + std::to_string(argument);
+        if(sinCosNeeded[argument] != 3) return std::string(cosine ? "cos(" : "sin(") + operand(argument) + ")";
+        if(!sinCosDone[argument]){
+            out << "    double s" << argument << ", c" << argument << ";\n"
+                << "    sincos(" << operand(argument) << ", &s" << argument << ", &c" << argument << ");\n";
+            sinCosDone[argument] = true;
+        }
+        return name;
+    }
+
+    std::string expression(const Instruction& instruction){
+        const std::string a = operand(instruction.a);
+        const std::string b = operand(instruction.b);
+        switch(instruction.kind){
+            case NodeKind::Sum:
+                if(fusable(instruction.a)){
+                    const Instruction& p = program.instructions[instruction.a];
+                    return "fma(" + operand(p.a) + ", " + operand(p.b) + ", " + b + ")";
+                }
+                if(fusable(instruction.b)){
+                    const Instruction& p = program.instructions[instruction.b];
+                    return "fma(" + operand(p.a) + ", " + operand(p.b) + ", " + a + ")";
+                }
+                return a + " + " + b;
+            case NodeKind::Difference:
+                if(fusable(instruction.a)){
+                    const Instruction& p = program.instructions[instruction.a];
+                    return "fma(" + operand(p.a) + ", " + operand(p.b) + ", -" + b + ")";
+                }
+                if(fusable(instruction.b)){
+                    const Instruction& p = program.instructions[instruction.b];
+                    return "fma(-" + operand(p.a) + ", " + operand(p.b) + ", " + a + ")";
+                }
+                return a + " - " + b;
+            case NodeKind::Product: return a + " * " + b;
+            case NodeKind::Quotient: return a + " / " + b;
+            case NodeKind::AbsVal: return "fabs(" + a + ")";
+            case NodeKind::Polynomial:
+                if(instruction.payload == 0.0) return "1.0";
+                if(instruction.payload == 1.0) return a;
+                if(instruction.payload == 2.0) return a + " * " + a;
+                if(instruction.payload == -1.0) return "1.0 / " + a;
+                if(instruction.payload == 0.5) return "sqrt(" + a + ")";
+                return "pow(" + a + ", " + literal(instruction.payload) + ")";
+            case NodeKind::Logarithmic:
+                if(isConstant(program, instruction.a, std::exp(1.0))) return "log(" + b + ")";
+                return "log(" + b + ") / log(" + a + ")";
+            case NodeKind::Exponential:
+                if(isConstant(program, instruction.a, std::exp(1.0))) return "exp(" + b + ")";
+                return "pow(" + a + ", " + b + ")";
+            case NodeKind::Sine: return sinCos(instruction.a, false);
+            case NodeKind::Cosine: return sinCos(instruction.a, true);
+            case NodeKind::Tangent: return "tan(" + a + ")";
+            case NodeKind::Secant: return "1.0 / " + sinCos(instruction.a, true);
+            case NodeKind::Cosecant: return "1.0 / " + sinCos(instruction.a, false);
+            case NodeKind::Cotangent: return "1.0 / tan(" + a + ")";
+            case NodeKind::Arcsin: return "asin(" + a + ")";
+            case NodeKind::Arccos: return "acos(" + a + ")";
+            case NodeKind::Arctan: return "atan(" + a + ")";
+            case NodeKind::Arccot: return "atan(1.0 / " + a + ")";
+            case NodeKind::Arcsec: return "acos(1.0 / " + a + ")";
+            case NodeKind::Arccsc: return "asin(1.0 / " + a + ")";
+            case NodeKind::SineH: return "sinh(" + a + ")";
+            case NodeKind::CosineH: return "cosh(" + a + ")";
+            case NodeKind::TangentH: return "tanh(" + a + ")";
+            case NodeKind::SecantH: return "1.0 / cosh(" + a + ")";
+            case NodeKind::CosecantH: return "1.0 / sinh(" + a + ")";
+            case NodeKind::CotangentH: return "1.0 / tanh(" + a + ")";
+            default:
+                throw std::runtime_error(std::string("Error cannot generate code for ") + kindName(instruction.kind));
+        }
+    }
+
+    public:
+    SourceWriter(const Program& p, const CodegenOptions& o)
+        : program(p), options(o), uses(p.useCounts()), fused(p.instructions.size(), false),
+          sinCosNeeded(p.instructions.size(), 0), sinCosDone(p.instructions.size(), false) {}
+
+    std::string write(){
+        if(program.outputs.size() != 1){
+            throw std::runtime_error("Error code generation needs exactly one root");
+        }
+        for(const Instruction& instruction : program.instructions){
+            if(instruction.kind == NodeKind::Parameter){
+                throw std::runtime_error("Error cannot generate code for a parameter, replace it with a constant first");
+            }
+            if(options.useSincos){
+                if(instruction.kind == NodeKind::Sine || instruction.kind == NodeKind::Cosecant) sinCosNeeded[instruction.a] |= 1;
+                if(instruction.kind == NodeKind::Cosine || instruction.kind == NodeKind::Secant) sinCosNeeded[instruction.a] |= 2;
+            }
+            if(instruction.kind == NodeKind::Sum || instruction.kind == NodeKind::Difference){
+                if(fusable(instruction.a)) fused[instruction.a] = true;
+                else if(fusable(instruction.b)) fused[instruction.b] = true;
+            }
+        }
+
+        out << "/* Generated by codegen.cpp, do not edit */\n"
+            << "#define _GNU_SOURCE\n"
+            << "#include <math.h>\n"
+            << "#include <stddef.h>\n\n"
+            << "static inline double calc_kernel(double x){\n";
+        for(uint32_t i = 0; i < program.instructions.size(); i++){
+            const Instruction& instruction = program.instructions[i];
+            if(instruction.kind == NodeKind::Constant || instruction.kind == NodeKind::Variable || fused[i]) continue;
+            std::string value = expression(instruction);
+            out << "    const double t" << i << " = " << value << ";\n";
+        }
+        out << "    return " << operand(program.outputs[0]) << ";\n"
+            << "}\n\n"
+            << "double calc_eval(double x){\n"
+            << "    return calc_kernel(x);\n"
+            << "}\n\n"
+            << "void calc_eval_batch(const double* xs, double* out, size_t n){\n"
+            << "    for(size_t i = 0; i < n; i++) out[i] = calc_kernel(xs[i]);\n"
+            << "}\n";
+        return out.str();
+    }
+};
+
+}
+
+std::string generateSource(const Program& program, const CodegenOptions& options){
+    return SourceWriter(program, options).write();
+}
+
+std::string generateSource(const Function& f, const CodegenOptions& options){
+    return generateSource(buildProgram(f), options);
+}
+
+/*
+    Compilation and loading
+*/
+
+CompiledFunction::CompiledFunction(void* library, bool loadedFromCache) : handle(library), cached(loadedFromCache){
+    scalar = reinterpret_cast<double (*)(double)>(dlsym(handle, "calc_eval"));
+    batch = reinterpret_cast<void (*)(const double*, double*, size_t)>(dlsym(handle, "calc_eval_batch"));
+    if(!scalar || !batch){
+        dlclose(handle);
+        throw std::runtime_error("Error compiled expression is missing its entry points");
+    }
+}
+
+CompiledFunction::~CompiledFunction(){
+    dlclose(handle);
+}
+
+void CompiledFunction::evaluate(const std::vector<double>& xs, std::vector<double>& out) const{
+    TraceSpan span("evaluateCompiled", "points", xs.size());
+    out.resize(xs.size());
+    batch(xs.data(), out.data(), xs.size());
+}
+
+// 64-bit FNV-1a
+static uint64_t hashText(const std::string& text){
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for(unsigned char c : text){
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static std::string readFile(const std::string& path){
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Suffix unique to this call among every process and thread writing to the cache
+static std::string uniqueSuffix(){
+    static std::atomic<unsigned long> counter{0};
+    return "." + std::to_string(getpid()) + "." + std::to_string(counter++);
+}
+
+// Writes through a temporary file so other processes never see a partial file
+static void writeFileAtomic(const std::string& path, const std::string& contents){
+    std::string temporary = path + ".tmp" + uniqueSuffix();
+    {
+        std::ofstream out(temporary, std::ios::binary);
+        out << contents;
+        if(!out) throw std::runtime_error("Error writing " + temporary);
+    }
+    std::filesystem::rename(temporary, path);
+}
+
+static std::string shellQuoted(const std::string& text){
+    std::string result = "'";
+    for(char c : text){
+        if(c == '\'') result += "'\\''";
+        else result += c;
+    }
+    return result + "'";
+}
+
+// True if path is owned by the current user and not writable by group or others; a directory
+// must also not be a symbolic link
+static bool isPrivate(const std::string& path, bool directory){
+    struct stat info;
+    if(lstat(path.c_str(), &info) != 0) return false;
+    if(directory ? !S_ISDIR(info.st_mode) : !S_ISREG(info.st_mode)) return false;
+    return info.st_uid == geteuid() && (info.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+// The cache directory: the option, $CALC_CODEGEN_CACHE, $XDG_CACHE_HOME/calculus-codegen,
+// ~/.cache/calculus-codegen, or else a fresh directory under /tmp for this process
+static std::string cacheDirectory(const CodegenOptions& options){
+    std::string directory = options.cacheDirectory;
+    const char* environment = std::getenv("CALC_CODEGEN_CACHE");
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+    if(directory.empty() && environment && *environment) directory = environment;
+    if(directory.empty() && xdg && *xdg) directory = std::string(xdg) + "/calculus-codegen";
+    if(directory.empty() && home && *home) directory = std::string(home) + "/.cache/calculus-codegen";
+    if(directory.empty()){
+        static std::string temporary = []{
+            char pattern[] = "/tmp/calculus-codegen-XXXXXX";
+            if(!mkdtemp(pattern)) throw std::runtime_error("Error creating a codegen cache directory");
+            return std::string(pattern);
+        }();
+        directory = temporary;
+    }
+
+    std::filesystem::path parent = std::filesystem::path(directory).parent_path();
+    if(!parent.empty()) std::filesystem::create_directories(parent);
+    mkdir(directory.c_str(), 0700);
+    // Another user could plant a shared object in a directory they can write to
+    if(!isPrivate(directory, true)){
+        throw std::runtime_error("Error codegen cache directory " + directory + " must be a directory owned by the user and not writable by others");
+    }
+    return directory;
+}
+
+static std::shared_ptr<CompiledFunction> load(const std::string& path, bool cached){
+    if(!isPrivate(path, false)){
+        throw std::runtime_error("Error refusing to load " + path + ", it is not owned by the user or is writable by others");
+    }
+    void* library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if(!library) throw std::runtime_error(std::string("Error loading compiled expression: ") + dlerror());
+    return std::make_shared<CompiledFunction>(library, cached);
+}
+
+std::shared_ptr<CompiledFunction> compileFunction(const Function& f, const CodegenOptions& options){
+    TraceSpan span("compile");
+    std::string source = generateSource(f, options);
+
+    std::string directory = cacheDirectory(options);
+
+    // The compiler and flags are part of the key, the same source built differently is a different object
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hashText(options.compiler + "\n" + options.flags + "\n" + source)));
+    std::string base = directory + "/calc_" + key;
+    std::string sourcePath = base + ".c";
+    std::string objectPath = base + ".so";
+
+    // The saved source guards against hash collisions
+    if(std::filesystem::exists(objectPath) && readFile(sourcePath) == source){
+        CALC_CACHE_ACCESS(CompiledObject, true);
+        return load(objectPath, true);
+    }
+    CALC_CACHE_ACCESS(CompiledObject, false);
+
+    writeFileAtomic(sourcePath, source);
+    std::string suffix = uniqueSuffix();
+    std::string temporary = objectPath + ".tmp" + suffix;
+    std::string log = base + ".log" + suffix;
+    std::string command = options.compiler + " " + options.flags + " -shared -fPIC -o " + shellQuoted(temporary) + " " +
+        shellQuoted(sourcePath) + " -lm > " + shellQuoted(log) + " 2>&1";
+    int status = std::system(command.c_str());
+    std::string output = readFile(log);
+    std::filesystem::remove(log);
+    if(status != 0){
+        std::filesystem::remove(temporary);
+        throw std::runtime_error("Error compiling expression: " + output);
+    }
+    // Private whatever the umask, so load() accepts it
+    chmod(temporary.c_str(), S_IRWXU);
+    std::filesystem::rename(temporary, objectPath);
+    return load(objectPath, false);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include "program.h"
+
+/*
+    C code generation
+    Turns a Function tree (after common subexpression elimination, see program.h) into a standalone
+    C source file with two entry points:
+        double calc_eval(double x);
+        void calc_eval_batch(const double* xs, double* out, size_t n);
+    compileFunction() builds it with the system C compiler into a shared object, loads it with dlopen
+    and keeps the shared object in an on-disk cache keyed by a hash of the generated source, which
+    only depends on the structure of the tree. A later run (or another process) loads it directly.
+    The cache is $CALC_CODEGEN_CACHE, $XDG_CACHE_HOME/calculus-codegen or ~/.cache/calculus-codegen,
+    created with mode 0700, and a fresh mkdtemp() directory for the process when none of them is set.
+    The directory and every shared object must be owned by the user and not writable by group or
+    others, or compileFunction() throws instead of loading them.
+
+    The generated code uses the C math library directly, like the compile-time expressions in
+    staticExpressions.h: results near 0 are not snapped to 0 and division by 0 returns the IEEE result
+    without recording an evaluation error. Trees containing Parameter nodes cannot be compiled.
+*/
+
+struct CodegenOptions {
+    bool useSincos = true;          // One sincos() call when sin and cos of the same argument are needed
+    bool useFma = false;            // a*b + c as fma(a, b, c), pair it with flags such as -mfma or -march=native
+    std::string compiler = "cc";
+    std::string flags = "-O2";
+    std::string cacheDirectory;     // Empty: $CALC_CODEGEN_CACHE, else $XDG_CACHE_HOME or ~/.cache (see below)
+};
+
+/**
+ * Generates the C source for f
+ *
+ * Precondition: f contains no Parameter nodes
+ * Postcondition: the same tree structure always gives the same source
+ */
+std::string generateSource(const Function& f, const CodegenOptions& options = CodegenOptions());
+std::string generateSource(const Program& program, const CodegenOptions& options = CodegenOptions());
+
+// A compiled expression loaded from a shared object, unloaded when destroyed
+class CompiledFunction {
+    void* handle;
+    double (*scalar)(double);
+    void (*batch)(const double*, double*, size_t);
+    bool cached;
+
+    public:
+    CompiledFunction(void* library, bool loadedFromCache);
+    ~CompiledFunction();
+    CompiledFunction(const CompiledFunction&) = delete;
+    CompiledFunction& operator=(const CompiledFunction&) = delete;
+
+    double operator()(double x) const { return scalar(x); }
+
+    // out[i] = f(xs[i]) for every i < n
+    void evaluate(const double* xs, double* out, size_t n) const { batch(xs, out, n); }
+    void evaluate(const std::vector<double>& xs, std::vector<double>& out) const;
+
+    // Whether the shared object came from the cache instead of the compiler
+    bool wasCached() const { return cached; }
+};
+
+/**
+ * Compiles f into native code, or loads it from the cache
+ *
+ * Precondition: f contains no Parameter nodes, options.compiler can build shared objects
+ * Postcondition: returns a loaded function, throws std::runtime_error with the compiler output if
+ *                compilation fails
+ */
+std::shared_ptr<CompiledFunction> compileFunction(const Function& f, const CodegenOptions& options = CodegenOptions());
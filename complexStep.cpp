@@ -0,0 +1,47 @@
+#include "complexStep.h"
+#include "program.h"
+#include "traversal.h"
+#include "tracing.h"
+
+#include <cmath>
+#include <algorithm>
+
+double complexStepDerivative(const Function& f, double x, double h){
+    if(isDeep(f)){
+        return evaluateProgram<Complex>(buildProgram(f), Complex(x, h)).imag() / h;
+    }
+    return f.evaluateComplex(Complex(x, h)).imag() / h;
+}
+
+void complexStepDerivative(const Function& f, const std::vector<double>& xs, std::vector<double>& out, double h){
+    TraceSpan span("complexStep", "points", xs.size());
+    std::vector<Complex> zs;
+    zs.reserve(xs.size());
+    for(double x : xs) zs.push_back(Complex(x, h));
+    std::vector<Complex> values;
+    evaluateProgram(buildProgram(f), zs, values);
+    out.resize(xs.size());
+    for(size_t i = 0; i < xs.size(); i++) out[i] = values[i].imag() / h;
+}
+
+DerivativeCheck checkDerivative(const Function& f, const std::vector<double>& xs, double tolerance){
+    std::vector<double> symbolic, numeric;
+    evaluateGrid(*f.derivative(), xs, symbolic);
+    complexStepDerivative(f, xs, numeric);
+
+    DerivativeCheck check;
+    for(size_t i = 0; i < xs.size(); i++){
+        if(!std::isfinite(symbolic[i]) || !std::isfinite(numeric[i])){
+            check.skipped++;
+            continue;
+        }
+        check.points++;
+        double error = std::abs(symbolic[i] - numeric[i]) / std::max(1.0, std::abs(numeric[i]));
+        if(error > tolerance) check.mismatches++;
+        if(error > check.worstError){
+            check.worstError = error;
+            check.worstX = xs[i];
+        }
+    }
+    return check;
+}
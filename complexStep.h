@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include "Functions.h"
+
+/*
+    Complex-step differentiation
+    For f real on the real line and analytic near x, f(x + ih) = f(x) + ih f'(x) + O(h^2), so
+        f'(x) = Im f(x + ih) / h
+    with no subtraction of nearly equal values: h can be far below the rounding error of x and the
+    result is exact to machine precision, from one complex evaluation and without building f'.
+    It does not apply where f is not analytic: at the cusp of an absolute value, on a branch cut
+    (log of a negative number, arcsin outside [-1, 1]) or at a pole.
+*/
+
+// Step used by default, small enough that the O(h^2) error vanishes for any reasonable f
+const double COMPLEX_STEP = 1e-20;
+
+/**
+ * First derivative of f at x by the complex step
+ *
+ * Precondition: h > 0
+ * Postcondition: returns Im f(x + ih) / h
+ */
+double complexStepDerivative(const Function& f, double x, double h = COMPLEX_STEP);
+
+/**
+ * First derivative of f at every point of xs; f is compiled to a Program once (program.h)
+ *
+ * Precondition: h > 0
+ * Postcondition: out[i] = complexStepDerivative(f, xs[i], h)
+ */
+void complexStepDerivative(const Function& f, const std::vector<double>& xs, std::vector<double>& out,
+    double h = COMPLEX_STEP);
+
+// Outcome of checkDerivative()
+struct DerivativeCheck {
+    size_t points = 0;          // Points where both derivatives are finite and were compared
+    size_t skipped = 0;         // Points where either one is not finite
+    size_t mismatches = 0;      // Compared points whose relative error exceeds the tolerance
+    double worstError = 0.0;    // Largest relative error |symbolic - numeric| / max(1, |numeric|)
+    double worstX = 0.0;        // Point of worstError
+};
+
+/**
+ * Cross-checks f.derivative() against the complex step at every point of xs
+ *
+ * Precondition: tolerance > 0
+ * Postcondition: returns the comparison, f.derivative() is evaluated with evaluateGrid()
+ */
+DerivativeCheck checkDerivative(const Function& f, const std::vector<double>& xs, double tolerance = 1e-9);
@@ -0,0 +1,188 @@
+#include "complexity.h"
+#include "nodeKind.h"
+#include "arithmeticOperands.h"
+#include "trigFunctions.h"
+
+#include <algorithm>
+#include <typeinfo>
+#include <unordered_map>
+#include <stdexcept>
+
+/*
+    Metrics at construction
+*/
+
+static uint64_t saturatingAdd(uint64_t a, uint64_t b){
+    return a > std::numeric_limits<uint64_t>::max() - b ? std::numeric_limits<uint64_t>::max() : a + b;
+}
+
+static uint64_t saturatingMultiply(uint64_t a, uint64_t b){
+    return b && a > std::numeric_limits<uint64_t>::max() / b ? std::numeric_limits<uint64_t>::max() : a * b;
+}
+
+void Function::measure(double cost, Complexity::Rule rule, const Function* a, const Function* b){
+    metrics.nodes = 1;
+    metrics.depth = 1;
+    metrics.cost = cost;
+    metrics.derivativeNodes = rule.constant;
+    uint64_t factors[] = {rule.first, rule.second};
+    const Function* children[] = {a, b};
+    for(int i = 0; i < 2 && children[i]; i++){
+        const Complexity& c = children[i]->complexity();
+        metrics.nodes = saturatingAdd(metrics.nodes, c.nodes);
+        metrics.depth = std::max<uint32_t>(metrics.depth, c.depth + 1);
+        metrics.cost += c.cost;
+        metrics.derivativeNodes = saturatingAdd(metrics.derivativeNodes, saturatingAdd(saturatingMultiply(factors[i], c.nodes), c.derivativeNodes));
+    }
+}
+
+// The size of f' is known from the rule of f. Its derivative is assumed to grow by the same factor
+// as f' did over f. Growth speeds up with the order, so stacked lazy derivatives are underestimated
+// (by 2 to 25 times at the sixth derivative): measureTree() gives the exact numbers
+void Derivative::estimate(){
+    const Complexity& f = function->complexity();
+    double growth = double(f.derivativeNodes) / double(f.nodes);
+    metrics.nodes = f.derivativeNodes;
+    metrics.depth = f.depth + 2;
+    metrics.cost = f.cost * growth;
+    double next = double(f.derivativeNodes) * growth;
+    metrics.derivativeNodes = next >= 1.8e19 ? std::numeric_limits<uint64_t>::max() : uint64_t(next);
+}
+
+/*
+    Budgets
+*/
+
+static const Function& resolved(const Function& f){
+    const Function* node = &f;
+    while(typeid(*node) == typeid(Derivative)){
+        node = static_cast<const Derivative*>(node)->materialize().get();
+    }
+    return *node;
+}
+
+// Derivative rule and evaluation cost of a kind, as given to measure() by the constructors
+static Complexity::Rule ruleOf(NodeKind kind, double& cost){
+    cost = Complexity::TRANSCENDENTAL;
+    switch(kind){
+        case NodeKind::Sum: cost = Complexity::ARITHMETIC; return Sum::RULE;
+        case NodeKind::Difference: cost = Complexity::ARITHMETIC; return Difference::RULE;
+        case NodeKind::Product: cost = Complexity::ARITHMETIC; return Product::RULE;
+        case NodeKind::Quotient: cost = Complexity::DIVISION; return Quotient::RULE;
+        case NodeKind::AbsVal: cost = Complexity::ARITHMETIC; return AbsVal::RULE;
+        case NodeKind::Polynomial: cost = Complexity::POWER; return Polynomial::RULE;
+        case NodeKind::Exponential: cost = Complexity::POWER; return Exponential::RULE;
+        case NodeKind::Logarithmic: return Logarithmic::RULE;
+        case NodeKind::Sine: return Sine::RULE;
+        case NodeKind::Cosine: return Cosine::RULE;
+        case NodeKind::Tangent: return Tangent::RULE;
+        case NodeKind::Secant: return Secant::RULE;
+        case NodeKind::Cosecant: return Cosecant::RULE;
+        case NodeKind::Cotangent: return Cotangent::RULE;
+        case NodeKind::Arcsin: return Arcsin::RULE;
+        case NodeKind::Arccos: return Arccos::RULE;
+        case NodeKind::Arctan: return Arctan::RULE;
+        case NodeKind::Arccot: return Arccot::RULE;
+        case NodeKind::Arcsec: return Arcsec::RULE;
+        case NodeKind::Arccsc: return Arccsc::RULE;
+        case NodeKind::SineH: return SineH::RULE;
+        case NodeKind::CosineH: return CosineH::RULE;
+        case NodeKind::TangentH: return TangentH::RULE;
+        case NodeKind::SecantH: return SecantH::RULE;
+        case NodeKind::CosecantH: return CosecantH::RULE;
+        case NodeKind::CotangentH: return CotangentH::RULE;
+        default: cost = Complexity::LEAF; return {1, 0, 0};
+    }
+}
+
+TreeMetrics measureTree(const Function& f, uint64_t dagLimit){
+    TreeMetrics result;
+    std::unordered_map<const Function*, Complexity> measured;
+    // Post-order without recursion: a node is measured once both children are
+    std::vector<std::pair<const Function*, bool>> stack{{&resolved(f), false}};
+    while(!stack.empty()){
+        auto [node, childrenDone] = stack.back();
+        if(measured.count(node)){
+            stack.pop_back();
+            continue;
+        }
+        NodeKind kind = kindOf(*node);
+        int children = childCount(kind);
+        if(!childrenDone){
+            if(measured.size() + stack.size() > dagLimit){
+                result.complete = false;
+                break;
+            }
+            stack.back().second = true;
+            for(int i = 0; i < children; i++) stack.push_back({&resolved(*childOf(*node, i)), false});
+            continue;
+        }
+        stack.pop_back();
+
+        double cost;
+        Complexity::Rule rule = ruleOf(kind, cost);
+        Complexity c;
+        c.cost = cost;
+        c.derivativeNodes = rule.constant;
+        uint64_t factors[] = {rule.first, rule.second};
+        for(int i = 0; i < children; i++){
+            const Complexity& child = measured.at(&resolved(*childOf(*node, i)));
+            c.nodes = saturatingAdd(c.nodes, child.nodes);
+            c.depth = std::max<uint32_t>(c.depth, child.depth + 1);
+            c.cost += child.cost;
+            c.derivativeNodes = saturatingAdd(c.derivativeNodes, saturatingAdd(saturatingMultiply(factors[i], child.nodes), child.derivativeNodes));
+        }
+        if(kind == NodeKind::Polynomial && payloadOf(*node) == 0.0) c.derivativeNodes = 1;
+        measured.emplace(node, c);
+    }
+    result.dagNodes = measured.size();
+    if(result.complete) result.complexity = measured.at(&resolved(f));
+    return result;
+}
+
+const char* exceededLimit(const Complexity& metrics, const ComplexityBudget& budget){
+    if(metrics.nodes > budget.maxNodes) return "nodes";
+    if(metrics.depth > budget.maxDepth) return "depth";
+    if(metrics.cost > budget.maxCost) return "cost";
+    return nullptr;
+}
+
+static void exceeded(const char* limit){
+    throw std::runtime_error(std::string("Error expression exceeds the complexity budget (") + limit + ")");
+}
+
+void checkBudget(const Function& f, const ComplexityBudget& budget){
+    if(const char* limit = exceededLimit(f.complexity(), budget)) exceeded(limit);
+}
+
+double GuardedDerivative::evaluate(double x) const{
+    return tree ? tree->evaluate(x) : taylor->derivative(x);
+}
+
+void GuardedDerivative::evaluate(const std::vector<double>& xs, std::vector<double>& out) const{
+    if(tree){
+        evaluateGrid(*tree, xs, out);
+    }
+    else{
+        taylor->derivative(xs, out);
+    }
+}
+
+GuardedDerivative differentiate(const std::shared_ptr<Function>& f, int order, const ComplexityBudget& budget){
+    if(order < 0) throw std::runtime_error("Error derivative order must not be negative");
+    std::shared_ptr<Function> current = f;
+    for(int i = 0; i <= order; i++){
+        TreeMetrics metrics = measureTree(*current, budget.maxDagNodes);
+        const char* limit = metrics.complete ? exceededLimit(metrics.complexity, budget) : "dag nodes";
+        // The next order is not built at all if it would be too large
+        if(!limit && i < order && metrics.complexity.derivativeNodes > budget.maxNodes) limit = "nodes";
+        if(limit){
+            // The Taylor evaluator works on the tree of f, which has to be within budget itself
+            bool withinBudget = i > 0 || (metrics.complete && !exceededLimit(metrics.complexity, budget));
+            if(budget.onExceeded == BudgetAction::Throw || !withinBudget) exceeded(limit);
+            return GuardedDerivative(std::make_shared<TaylorEvaluator>(*f, order), limit);
+        }
+        if(i < order) current = current->derivative();
+    }
+    return GuardedDerivative(current);
+}
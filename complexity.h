@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <memory>
+#include "Functions.h"
+#include "taylor.h"
+
+/*
+    Complexity budgets
+    Repeated differentiation of products, quotients and logarithms grows trees exponentially with the
+    order. Every node knows the size, depth and evaluation cost of its tree (Complexity in
+    Functions.h), so a tree can be checked against a budget in O(1) before anything walks it, and
+    knows the size of its derivative before it is built.
+    differentiate() checks before every order and either throws or switches to Taylor mode automatic
+    differentiation (taylor.h), whose cost depends on the tree of f only.
+*/
+
+enum class BudgetAction : unsigned char {
+    Throw,          // std::runtime_error naming the exceeded limit
+    Numeric         // Evaluate the derivative numerically from the tree of f
+};
+
+struct ComplexityBudget {
+    uint64_t maxNodes = std::numeric_limits<uint64_t>::max();
+    uint64_t maxDagNodes = std::numeric_limits<uint64_t>::max();    // Bounds the nodes built, see measureTree()
+    uint32_t maxDepth = std::numeric_limits<uint32_t>::max();
+    double maxCost = std::numeric_limits<double>::infinity();
+    BudgetAction onExceeded = BudgetAction::Throw;
+};
+
+// Exact metrics of a tree, see measureTree()
+struct TreeMetrics {
+    Complexity complexity;
+    uint64_t dagNodes = 0;      // Distinct nodes
+    bool complete = true;       // False if the walk stopped at the DAG limit
+};
+
+/**
+ * Walks the DAG of f once, building lazy derivatives on the way, and computes its metrics exactly
+ * (the metrics stored in a node are estimates as soon as it has unbuilt lazy derivatives below it)
+ *
+ * Precondition: None
+ * Postcondition: exact metrics and DAG size of f, derivativeNodes is the exact size of f'. If f has
+ *                more than dagLimit distinct nodes the walk stops there (so about dagLimit nodes are
+ *                built at most) and complete = false
+ */
+TreeMetrics measureTree(const Function& f, uint64_t dagLimit = std::numeric_limits<uint64_t>::max());
+
+/**
+ * First limit of budget that metrics exceed
+ *
+ * Precondition: None
+ * Postcondition: "nodes", "depth" or "cost", nullptr if the metrics are within the budget
+ *                (maxDagNodes is checked by measureTree)
+ */
+const char* exceededLimit(const Complexity& metrics, const ComplexityBudget& budget);
+
+// Throws std::runtime_error if the stored metrics of f exceed budget, O(1)
+void checkBudget(const Function& f, const ComplexityBudget& budget);
+
+// Derivative of some order, symbolic while within a budget and numeric otherwise
+class GuardedDerivative {
+    std::shared_ptr<Function> tree;                 // Null when numeric
+    std::shared_ptr<TaylorEvaluator> taylor;        // Null when symbolic
+    const char* limit = nullptr;
+
+    public:
+    explicit GuardedDerivative(std::shared_ptr<Function> symbolic) : tree(std::move(symbolic)) {}
+    GuardedDerivative(std::shared_ptr<TaylorEvaluator> numeric, const char* exceeded) : taylor(std::move(numeric)), limit(exceeded) {}
+
+    bool isSymbolic() const { return tree != nullptr; }
+    const std::shared_ptr<Function>& symbolic() const { return tree; }
+
+    // Limit that made it numeric, nullptr when symbolic
+    const char* exceeded() const { return limit; }
+
+    double evaluate(double x) const;
+    void evaluate(const std::vector<double>& xs, std::vector<double>& out) const;
+};
+
+/**
+ * Differentiates f order times. Before every order the current tree is measured with measureTree()
+ * and the next order is only built if its exact size is within maxNodes
+ *
+ * Precondition: f is not null, order >= 0
+ * Postcondition: the symbolic derivative if every tree was within budget. Otherwise throws
+ *                std::runtime_error (BudgetAction::Throw, or f itself exceeds the budget) or returns a
+ *                numeric derivative (BudgetAction::Numeric)
+ */
+GuardedDerivative differentiate(const std::shared_ptr<Function>& f, int order, const ComplexityBudget& budget);
@@ -0,0 +1,126 @@
+#include "socketIO.h"
+
+#include <chrono>
+#include <limits>
+#include <thread>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <unistd.h>
+
+/*
+    Load generator for the derivative server
+    Opens a number of connections and sends requests in a closed loop (each connection waits for
+    its response before sending the next request), then reports throughput and latency percentiles.
+*/
+
+static const std::vector<std::string> sampleExpressions = {
+    "x^3 + 2*x^2 - 5",
+    "sin(x)*cos(x)",
+    "e^(2*x)/(x^2 + 1)",
+    "ln(x^2 + 1)",
+    "tan(x) - sec(x)",
+    "arctan(x)*sqrt(x)",
+    "sinh(x)/cosh(x)",
+    "|x - 2|*x"
+};
+
+static void usage(const char* program){
+    std::cerr << "usage: " << program << " (--socket PATH | --port N) [--connections N] [--requests N]\n"
+        << "  --socket PATH      connect to a Unix domain socket\n"
+        << "  --port N           connect to 127.0.0.1:N\n"
+        << "  --connections N    concurrent connections (default 8)\n"
+        << "  --requests N       requests per connection (default 10000)\n";
+}
+
+// Builds the i-th request of a connection, a mix of derivative and evaluation requests
+static std::string request(int connection, int i){
+    const std::string& expr = sampleExpressions[(connection + i) % sampleExpressions.size()];
+    int order = 1 + i % 3;
+    if(i % 2 == 0) return "DERIVE " + std::to_string(order) + " " + expr + "\n";
+    double x = 0.5 + (i % 7) * 0.25;
+    return "EVAL " + std::to_string(order) + " " + std::to_string(x) + "," + std::to_string(x + 1) + " " + expr + "\n";
+}
+
+// Runs one connection, records the latency of every request in microseconds
+static void runConnection(const std::string& socketPath, int port, int connection, int requests,
+                          std::vector<double>& latencies, size_t& errors){
+    int fd;
+    try{
+        fd = socketPath.empty() ? connectLoopback(port) : connectUnix(socketPath);
+    }
+    catch(const std::exception& error){
+        std::cerr << error.what() << '\n';
+        errors++;
+        return;
+    }
+    // Responses hold whole printed derivatives, which the load generator reads however long
+    LineReader reader(fd, std::numeric_limits<size_t>::max());
+    std::string response;
+    for(int i = 0; i < requests; i++){
+        auto start = std::chrono::steady_clock::now();
+        if(!writeAll(fd, request(connection, i)) || !reader.readLine(response)) break;
+        auto end = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        if(response.compare(0, 2, "OK") != 0) errors++;
+    }
+    close(fd);
+}
+
+static double percentile(const std::vector<double>& sorted, double p){
+    if(sorted.empty()) return 0;
+    size_t index = std::min(sorted.size() - 1, size_t(p * sorted.size()));
+    return sorted[index];
+}
+
+int main(int argc, char* argv[]){
+    std::string socketPath;
+    int port = -1;
+    int connections = 8;
+    int requests = 10000;
+
+    try{
+        for(int i = 1; i + 1 < argc; i += 2){
+            std::string arg = argv[i];
+            if(arg == "--socket") socketPath = argv[i + 1];
+            else if(arg == "--port") port = std::stoi(argv[i + 1]);
+            else if(arg == "--connections") connections = std::max(1, std::stoi(argv[i + 1]));
+            else if(arg == "--requests") requests = std::max(1, std::stoi(argv[i + 1]));
+            else throw std::invalid_argument(arg);
+        }
+    }
+    catch(const std::exception&){
+        usage(argv[0]);
+        return 2;
+    }
+    if(argc % 2 == 0 || socketPath.empty() == (port < 0)){
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<std::vector<double>> latencies(connections);
+    std::vector<size_t> errors(connections, 0);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for(int c = 0; c < connections; c++){
+        threads.emplace_back(runConnection, socketPath, port, c, requests, std::ref(latencies[c]), std::ref(errors[c]));
+    }
+    for(std::thread& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    size_t errorCount = 0;
+    for(int c = 0; c < connections; c++){
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+        errorCount += errors[c];
+    }
+    std::sort(all.begin(), all.end());
+
+    std::cout << "requests:    " << all.size() << " (" << errorCount << " errors)\n"
+              << "throughput:  " << all.size() / seconds << " requests/s\n"
+              << "latency p50: " << percentile(all, 0.50) << " us\n"
+              << "latency p99: " << percentile(all, 0.99) << " us\n"
+              << "latency max: " << (all.empty() ? 0 : all.back()) << " us\n";
+    return errorCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+#include "derivativeService.h"
+#include "socketIO.h"
+
+#include <cerrno>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <sys/socket.h>
+
+/*
+    Local derivative server
+    Listens on a Unix domain socket or a loopback TCP port and answers the line protocol described
+    in derivativeService.h. Every connection is served by its own thread; all connections share one
+    DerivativeService, so parsed trees and derivatives are built once per process.
+    The budget, the maximum order and the line length are finite unless "unlimited" is given, so a
+    single request cannot hold a connection thread or the memory of the process for long.
+*/
+
+const uint64_t DEFAULT_MAX_NODES = 1000000;
+const uint64_t DEFAULT_MAX_DAG_NODES = 1000000;
+const int DEFAULT_MAX_ORDER = 100;
+
+static void usage(const char* program){
+    std::cerr << "usage: " << program << " (--socket PATH | --port N) [--cache N] [--max-nodes N] [--max-dag N]\n"
+        << "                  [--max-order N] [--max-line N]\n"
+        << "  --socket PATH   listen on a Unix domain socket\n"
+        << "  --port N        listen on 127.0.0.1:N\n"
+        << "  --cache N       maximum number of cached trees (default 100000)\n"
+        << "  --max-nodes N   refuse derivatives whose tree has more than N nodes (default " << DEFAULT_MAX_NODES << ")\n"
+        << "  --max-dag N     refuse derivatives with more than N distinct nodes (default " << DEFAULT_MAX_DAG_NODES << ")\n"
+        << "  --max-order N   refuse derivatives of order above N (default " << DEFAULT_MAX_ORDER << ")\n"
+        << "  --max-line N    close connections that send a line longer than N bytes (default " << LINE_LIMIT << ")\n"
+        << "  The four limits accept \"unlimited\".\n";
+}
+
+// Value of a limit flag, the largest value of T for "unlimited"
+template<class T>
+static T limit(const std::string& value){
+    if(value == "unlimited") return std::numeric_limits<T>::max();
+    unsigned long long parsed = std::stoull(value);
+    if(parsed > static_cast<unsigned long long>(std::numeric_limits<T>::max())) throw std::out_of_range(value);
+    return static_cast<T>(parsed);
+}
+
+static void serve(int fd, DerivativeService& service, size_t maxLine){
+    LineReader reader(fd, maxLine);
+    std::string request;
+    try{
+        while(reader.readLine(request)){
+            if(!writeAll(fd, service.handle(request) + "\n")) break;
+        }
+    }
+    catch(const std::exception& error){
+        // The line is too long: answer it and drop the connection instead of reading the rest
+        writeAll(fd, std::string("ERROR ") + error.what() + "\n");
+    }
+    close(fd);
+}
+
+int main(int argc, char* argv[]){
+    std::string socketPath;
+    int port = -1;
+    size_t cacheCapacity = 100000;
+    ComplexityBudget budget;
+    budget.maxNodes = DEFAULT_MAX_NODES;
+    budget.maxDagNodes = DEFAULT_MAX_DAG_NODES;
+    int maxOrder = DEFAULT_MAX_ORDER;
+    size_t maxLine = LINE_LIMIT;
+
+    try{
+        for(int i = 1; i + 1 < argc; i += 2){
+            std::string arg = argv[i];
+            if(arg == "--socket") socketPath = argv[i + 1];
+            else if(arg == "--port") port = std::stoi(argv[i + 1]);
+            else if(arg == "--cache") cacheCapacity = std::stoul(argv[i + 1]);
+            else if(arg == "--max-nodes") budget.maxNodes = limit<uint64_t>(argv[i + 1]);
+            else if(arg == "--max-dag") budget.maxDagNodes = limit<uint64_t>(argv[i + 1]);
+            else if(arg == "--max-order") maxOrder = limit<int>(argv[i + 1]);
+            else if(arg == "--max-line") maxLine = limit<size_t>(argv[i + 1]);
+            else throw std::invalid_argument(arg);
+        }
+    }
+    catch(const std::exception&){
+        usage(argv[0]);
+        return 2;
+    }
+    if(argc % 2 == 0 || socketPath.empty() == (port < 0)){
+        usage(argv[0]);
+        return 2;
+    }
+
+    int listener;
+    try{
+        listener = socketPath.empty() ? listenLoopback(port) : listenUnix(socketPath);
+    }
+    catch(const std::exception& error){
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    std::cerr << "listening on " << (socketPath.empty() ? "127.0.0.1:" + std::to_string(port) : socketPath) << '\n';
+
+    DerivativeService service(cacheCapacity, budget, maxOrder);
+    while(true){
+        int fd = accept(listener, nullptr, nullptr);
+        if(fd < 0){
+            if(errno == EINTR) continue;
+            std::cerr << "Error accepting connection\n";
+            break;
+        }
+        std::thread(serve, fd, std::ref(service), maxLine).detach();
+    }
+    close(listener);
+    return 1;
+}
@@ -0,0 +1,216 @@
+#include "derivativeService.h"
+#include "expressionSplit.h"
+#include "printer.h"
+#include "instrumentation.h"
+#include "tracing.h"
+
+#include <sstream>
+
+std::shared_ptr<Function> DerivativeService::compute(const std::string& expr, int order, const std::shared_ptr<Function>& previous){
+    if(order == 0){
+        std::shared_ptr<Function> f = buildFunction(expr);
+        checkBudget(*f, budget);
+        return f;
+    }
+    TraceSpan span("derivative", "order", order);
+    if(budget.maxNodes != ComplexityBudget().maxNodes || budget.maxDagNodes != ComplexityBudget().maxDagNodes){
+        // The size of the next order is exact once the previous one has been walked
+        TreeMetrics metrics = measureTree(*previous, budget.maxDagNodes);
+        if(!metrics.complete || metrics.complexity.derivativeNodes > budget.maxNodes){
+            throw std::runtime_error(std::string("Error derivative exceeds the complexity budget (") + (metrics.complete ? "nodes" : "dag nodes") + ")");
+        }
+    }
+    return previous->derivative();
+}
+
+std::shared_ptr<Function> DerivativeService::step(const std::string& expr, int order, const std::shared_ptr<Function>& previous){
+    std::string key = std::to_string(order) + " " + expr;
+    std::promise<std::shared_ptr<Function>> promise;
+    std::shared_future<std::shared_ptr<Function>> running;
+    {
+        std::lock_guard<std::mutex> guard(cacheLock);
+        auto cached = cache.find(key);
+        if(cached != cache.end()){
+            hits++;
+            CALC_CACHE_ACCESS(DerivativeService, true);
+            return cached->second;
+        }
+        auto flying = inFlight.find(key);
+        if(flying != inFlight.end()){
+            coalesced++;
+            CALC_CACHE_ACCESS(DerivativeService, true);
+            running = flying->second;
+        }
+        else{
+            misses++;
+            CALC_CACHE_ACCESS(DerivativeService, false);
+            inFlight.emplace(key, promise.get_future().share());
+        }
+    }
+
+    // Someone else is already building this tree, wait for their result (or error)
+    if(running.valid()) return running.get();
+
+    std::shared_ptr<Function> result;
+    try{
+        result = compute(expr, order, previous);
+    }
+    catch(...){
+        promise.set_exception(std::current_exception());
+        std::lock_guard<std::mutex> guard(cacheLock);
+        inFlight.erase(key);
+        throw;
+    }
+    promise.set_value(result);
+
+    std::lock_guard<std::mutex> guard(cacheLock);
+    if(cache.emplace(key, result).second){
+        cacheOrder.push_back(key);
+        if(cache.size() > capacity){
+            cache.erase(cacheOrder.front());
+            cacheOrder.pop_front();
+        }
+    }
+    inFlight.erase(key);
+    return result;
+}
+
+std::shared_ptr<Function> DerivativeService::derivative(const std::string& expr, int order){
+    if(order > maxOrder){
+        throw std::runtime_error("Error derivative order " + std::to_string(order) + " exceeds the maximum order " + std::to_string(maxOrder));
+    }
+    // Start from the highest order already cached, every order above it is built from the one below
+    int lowest = 0;
+    std::shared_ptr<Function> f;
+    {
+        std::lock_guard<std::mutex> guard(cacheLock);
+        for(int below = order - 1; below >= 0 && !f; below--){
+            auto cached = cache.find(std::to_string(below) + " " + expr);
+            if(cached == cache.end()) continue;
+            f = cached->second;
+            lowest = below + 1;
+        }
+    }
+    for(int next = lowest; next <= order; next++) f = step(expr, next, f);
+    return f;
+}
+
+std::vector<double> DerivativeService::evaluate(const std::string& expr, int order, const std::vector<double>& xs){
+    std::shared_ptr<Function> f = derivative(expr, order);
+    std::string key = std::to_string(order) + " " + expr;
+
+    std::unique_lock<std::mutex> guard(batchLock);
+    std::shared_ptr<Batch> batch = batches[key].pending;
+    if(!batch){
+        batch = std::make_shared<Batch>();
+        batches[key].pending = batch;
+    }
+    size_t offset = batch->points.size();
+    batch->points.insert(batch->points.end(), xs.begin(), xs.end());
+
+    while(!batch->done){
+        EvaluationQueue& queue = batches[key];
+        if(!queue.running && queue.pending == batch){
+            // Run every request merged into this batch, later requests start the next batch
+            queue.running = true;
+            queue.pending = nullptr;
+            guard.unlock();
+
+            // An exception (strict mode, bad_alloc) must still finish the batch, or the queue stays
+            // running and every waiter blocks forever
+            std::vector<double> values;
+            std::exception_ptr error;
+            try{
+                evaluateGrid(*f, batch->points, values);
+            }
+            catch(...){
+                error = std::current_exception();
+            }
+
+            guard.lock();
+            batch->values = std::move(values);
+            batch->error = error;
+            batch->done = true;
+            EvaluationQueue& finished = batches[key];
+            finished.running = false;
+            if(!finished.pending) batches.erase(key);
+            batchDone.notify_all();
+        }
+        else{
+            batchDone.wait(guard);
+        }
+    }
+    if(batch->error) std::rethrow_exception(batch->error);
+    return std::vector<double>(batch->values.begin() + offset, batch->values.begin() + offset + xs.size());
+}
+
+// Reads the rest of a request line as the expression
+static std::string restOfLine(std::istringstream& in){
+    std::string rest;
+    std::getline(in, rest);
+    return trim(rest);
+}
+
+std::string DerivativeService::handle(const std::string& request){
+    TraceSpan span("request");
+    try{
+        std::istringstream in(request);
+        std::string command;
+        in >> command;
+
+        std::ostringstream out;
+        out.precision(17);
+        if(command == "PARSE"){
+            out << "OK ";
+            print(*derivative(restOfLine(in), 0), out);
+        }
+        else if(command == "DERIVE"){
+            int order = -1;
+            in >> order;
+            if(order < 0) return "ERROR invalid derivative order";
+            out << "OK ";
+            print(*derivative(restOfLine(in), order), out);
+        }
+        else if(command == "EVAL"){
+            int order = -1;
+            std::string list;
+            in >> order >> list;
+            if(order < 0) return "ERROR invalid derivative order";
+
+            std::vector<double> xs;
+            std::istringstream points(list);
+            for(std::string point; std::getline(points, point, ',');){
+                xs.push_back(std::stod(point));
+            }
+            out << "OK";
+            for(double value : evaluate(restOfLine(in), order, xs)){
+                out << ' ' << value;
+            }
+        }
+        else if(command == "STATS"){
+            out << "OK hits=" << cacheHits() << " misses=" << cacheMisses() << " coalesced=" << coalescedRequests();
+        }
+        else{
+            return "ERROR unknown command \"" + command + "\"";
+        }
+        return out.str();
+    }
+    catch(const std::exception& error){
+        return std::string("ERROR ") + error.what();
+    }
+}
+
+size_t DerivativeService::cacheHits(){
+    std::lock_guard<std::mutex> guard(cacheLock);
+    return hits;
+}
+
+size_t DerivativeService::cacheMisses(){
+    std::lock_guard<std::mutex> guard(cacheLock);
+    return misses;
+}
+
+size_t DerivativeService::coalescedRequests(){
+    std::lock_guard<std::mutex> guard(cacheLock);
+    return coalesced;
+}
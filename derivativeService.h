@@ -0,0 +1,103 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <exception>
+#include <future>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <condition_variable>
+#include "Functions.h"
+#include "complexity.h"
+
+/*
+    Process-wide derivative service
+    Shared by every connection of the derivative server (derivativeServer.cpp):
+        - Parsed expressions and their derivatives are cached by (expression, order)
+        - Identical requests that arrive while one is being computed wait for that result
+          instead of building the same tree again
+        - Evaluation requests for the same (expression, order) that arrive while one is running
+          are merged and evaluated in one evaluateGrid call
+        - A derivative is only built if its exact size is within the complexity budget
+          (complexity.h), so one request cannot take unbounded memory or time
+        - Orders above the maximum order are refused. An order is built from the highest order of
+          the same expression that is cached, one order at a time, so the stack depth does not
+          depend on the order
+
+    Request protocol, one request per line, one response line per request:
+        PARSE <expression>                      -> OK <expression>
+        DERIVE <order> <expression>             -> OK <derivative>
+        EVAL <order> <x1,x2,...> <expression>   -> OK <value1> <value2> ...
+        STATS                                   -> OK hits=<n> misses=<n> coalesced=<n>
+    Errors are returned as "ERROR <message>".
+*/
+class DerivativeService {
+    // An evaluation batch shared by every request merged into it
+    struct Batch {
+        std::vector<double> points;
+        std::vector<double> values;
+        std::exception_ptr error;   // Set if the evaluation threw, rethrown to every merged request
+        bool done = false;
+    };
+
+    // Evaluations of one (expression, order): at most one runs at a time, the rest wait in pending
+    struct EvaluationQueue {
+        bool running = false;
+        std::shared_ptr<Batch> pending;
+    };
+
+    size_t capacity;
+    ComplexityBudget budget;
+    int maxOrder;
+
+    std::mutex cacheLock;
+    std::unordered_map<std::string, std::shared_ptr<Function>> cache;
+    std::list<std::string> cacheOrder;      // Oldest entry first, evicted when the cache is full
+    std::unordered_map<std::string, std::shared_future<std::shared_ptr<Function>>> inFlight;
+
+    std::mutex batchLock;
+    std::condition_variable batchDone;
+    std::unordered_map<std::string, EvaluationQueue> batches;
+
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t coalesced = 0;
+
+    // Order order of expr from previous, the order below it (null for order 0)
+    std::shared_ptr<Function> compute(const std::string& expr, int order, const std::shared_ptr<Function>& previous);
+
+    // Cached order of expr, built from previous if it is neither cached nor being built
+    std::shared_ptr<Function> step(const std::string& expr, int order, const std::shared_ptr<Function>& previous);
+
+    public:
+    explicit DerivativeService(size_t cacheCapacity = 100000, ComplexityBudget limits = ComplexityBudget(),
+        int maximumOrder = 1000)
+        : capacity(cacheCapacity), budget(limits), maxOrder(maximumOrder) {}
+
+    /**
+     * Returns the order-th derivative of expr (order 0 = the parsed expression)
+     *
+     * Precondition: order >= 0
+     * Postcondition: the result is cached, concurrent identical calls build it only once. Throws
+     *                std::runtime_error if order is above the maximum order or the result exceeds
+     *                the budget
+     */
+    std::shared_ptr<Function> derivative(const std::string& expr, int order);
+
+    /**
+     * Evaluates the order-th derivative of expr at every point of xs
+     *
+     * Precondition: order >= 0
+     * Postcondition: returns f(xs[i]) for every i, never throws for division by 0
+     */
+    std::vector<double> evaluate(const std::string& expr, int order, const std::vector<double>& xs);
+
+    // Handles one protocol line and returns the response line (without the newline)
+    std::string handle(const std::string& request);
+
+    // Cache statistics: lookups served from the cache, computed, and merged into a running computation
+    size_t cacheHits();
+    size_t cacheMisses();
+    size_t coalescedRequests();
+};
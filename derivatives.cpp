@@ -1,171 +1,193 @@
 #include "Functions.h"
 #include "trigFunctions.h"
 #include "arithmeticOperands.h"
+#include "parameters.h"
+#include "instrumentation.h"
 
 // Derivatives of arithmetic operations
 
 // (f(x) + g(x))' = f'(x) + g'(x)
 std::shared_ptr<Function> Sum::derivative() const{
-    return std::make_shared<Sum>(left->derivative(), right->derivative());
+    CALC_PROBE(Derivative, Sum);
+    return std::make_shared<Sum>(Derivative::of(left), Derivative::of(right));
 }
 
 // (f(x) - g(x))' = f'(x) - g'(x)
 std::shared_ptr<Function> Difference::derivative() const{
-    return std::make_shared<Difference>(left->derivative(), right->derivative());
+    CALC_PROBE(Derivative, Difference);
+    return std::make_shared<Difference>(Derivative::of(left), Derivative::of(right));
 }
 
 // (f(x)*g(x))' = f'(x)*g(x) + f(x)*g'(x)
 std::shared_ptr<Function> Product::derivative() const{
+    CALC_PROBE(Derivative, Product);
     return std::make_shared<Sum>(
-        std::make_shared<Product>(left -> derivative(), right),
-        std::make_shared<Product>(left, right->derivative()));
+        std::make_shared<Product>(Derivative::of(left), right),
+        std::make_shared<Product>(left, Derivative::of(right)));
 }
 
 // (f(x) / g(x))' = f'(x) * g(x) - f(x) * g'(x) /
 //                            (g(x)^2)
 std::shared_ptr<Function> Quotient::derivative() const{
+    CALC_PROBE(Derivative, Quotient);
     return std::make_shared<Quotient>(
-        std::make_shared<Difference>(std::make_shared<Product>(right->derivative(), left), 
-                std::make_shared<Product>(right, left->derivative())),
-        std::make_shared<Polynomial>(left, 2.0));
+        std::make_shared<Difference>(std::make_shared<Product>(Derivative::of(left), right), 
+                std::make_shared<Product>(left, Derivative::of(right))),
+        std::make_shared<Polynomial>(right, 2.0));
 }
 
 // Base derivatives
 
 // (C)' = 0
 std::shared_ptr<Function> Constant::derivative() const {
-    return std::make_shared<Constant>(0.0);
+    CALC_PROBE(Derivative, Constant);
+    return Constant::zero();
 }
 
 // x' = 1
 std::shared_ptr<Function> Variable::derivative() const{
-    return std::make_shared<Constant>(1.0);
+    CALC_PROBE(Derivative, Variable);
+    return Constant::one();
 }
 
 // Elementary function derivatives
 
 // (|f(x)|)' = (f(x) * f'(x)) / |f(x)|
 std::shared_ptr<Function> AbsVal::derivative() const{
-    return std::make_shared<Quotient>(std::make_shared<Product>(argument, argument->derivative()), 
+    CALC_PROBE(Derivative, AbsVal);
+    return std::make_shared<Quotient>(std::make_shared<Product>(argument, Derivative::of(argument)), 
         std::make_shared<AbsVal>(argument));
 }
 
 // A * f'(x) * f(x)^(A-1)
 std::shared_ptr<Function> Polynomial::derivative() const{
-    if (exponent == 0) return std::make_shared<Constant>(0);  // Derivative of constant
+    CALC_PROBE(Derivative, Polynomial);
+    if (exponent == 0) return Constant::zero();  // Derivative of constant
     return std::make_shared<Product>(                                   //Af'(x)f(x)^(A-1)
-        std::make_shared<Polynomial>(                                  //Af(x)^(A-1)
-        std::make_shared<Product>(                                                                  
-            std::make_shared<Product>(coefficient, std::make_shared<Constant>(exponent))), exponent - 1), 
-            coefficient->derivative());                                 //f'(x)
+        std::make_shared<Product>(                                      //Af(x)^(A-1)
+            std::make_shared<Constant>(exponent), std::make_shared<Polynomial>(coefficient, exponent - 1)), 
+            Derivative::of(coefficient));                                 //f'(x)
 }
 
 
 // (log_g(x)(f(x)))' = (g(x) * f'(x) - g'(x) * f(x) * log_g(x)(f(X))) / 
 //                            (g(x) * f(x) * ln(g(x)))
 std::shared_ptr<Function> Logarithmic::derivative() const{
+    CALC_PROBE(Derivative, Logarithmic);
     return std::make_shared<Quotient>(
-        std::make_shared<Difference>(std::make_shared<Product>(base, argument->derivative()),
+        std::make_shared<Difference>(std::make_shared<Product>(base, Derivative::of(argument)),
         std::make_shared<Product>(
-            std::make_shared<Product>(base->derivative(), argument), std::make_shared<Logarithmic>(base, argument))),
+            std::make_shared<Product>(Derivative::of(base), argument), std::make_shared<Logarithmic>(base, argument))),
             std::make_shared<Product>(std::make_shared<Product>(base, argument), 
-                std::make_shared<Logarithmic>(std::make_shared<Constant>(std::exp(1.0)), base)));
+                std::make_shared<Logarithmic>(Constant::e(), base)));
 }
 
 // (g(x)^f(X))' = g(x)^f(x) * (f(x)ln(g(x)))'
 std::shared_ptr<Function> Exponential::derivative() const{
+    CALC_PROBE(Derivative, Exponential);
     return std::make_shared<Product>(std::make_shared<Exponential>(base, argument), 
         std::make_shared<Product>(argument,
-            std::make_shared<Logarithmic>(std::make_shared<Constant>(std::exp(1.0)), base))->derivative());
+            std::make_shared<Logarithmic>(Constant::e(), base))->derivative());
 }
 
 // Trigonometric derivatives
 
 // sin(f(X))' = cos(f(x)) * f'(x)
 std::shared_ptr<Function> Sine::derivative() const{
-    return std::make_shared<Product>(std::make_shared<Cosine>(this->getArgument()), this->getArgument()->derivative());
+    CALC_PROBE(Derivative, Sine);
+    return std::make_shared<Product>(std::make_shared<Cosine>(argument), Derivative::of(argument));
 }
 
 // cos(f(x))' = -sin(f(x)) * f'(x)
 std::shared_ptr<Function> Cosine::derivative() const{
-    return std::make_shared<Product>(
-        std::make_shared<Product>(std::make_shared<Constant>(-1.0), 
-            std::make_shared<Product>(std::make_shared<Sine>(argument), argument->derivative())));
+    CALC_PROBE(Derivative, Cosine);
+    return std::make_shared<Product>(Constant::negativeOne(), 
+            std::make_shared<Product>(std::make_shared<Sine>(argument), Derivative::of(argument)));
 }
 
 // tan(f(x))' = sec^2(f(x)) * f'(x)
 std::shared_ptr<Function> Tangent::derivative() const{
+    CALC_PROBE(Derivative, Tangent);
     return std::make_shared<Product>(
         std::make_shared<Polynomial>(std::make_shared<Secant>(argument), 2.0), 
-        argument->derivative());
+        Derivative::of(argument));
 }
 
 // sec(f(x))' = sec(f(x)) * tan(f(x)) * f'(x)
 std::shared_ptr<Function> Secant::derivative() const{
+    CALC_PROBE(Derivative, Secant);
     return std::make_shared<Product>(
         std::make_shared<Product>(std::make_shared<Secant>(argument), std::make_shared<Tangent>(argument)), 
-        argument->derivative());
+        Derivative::of(argument));
 }
 
 // csc(f(x))' = -csc(f(x)) * cot(f(x)) * f'(x)
 std::shared_ptr<Function> Cosecant::derivative() const{
+    CALC_PROBE(Derivative, Cosecant);
     return std::make_shared<Product>(
-        std::make_shared<Constant>(-1.0),
+        Constant::negativeOne(),
         std::make_shared<Product>(
             std::make_shared<Product>(std::make_shared<Cosecant>(argument), std::make_shared<Cotangent>(argument)),
-            argument->derivative()));
+            Derivative::of(argument)));
 }
 
 // cot(f(x))' = -csc(f(x))^2 * f'(x)
 std::shared_ptr<Function> Cotangent::derivative() const{
+    CALC_PROBE(Derivative, Cotangent);
         return std::make_shared<Product>(
-            std::make_shared<Constant>(-1.0), 
+            Constant::negativeOne(), 
             std::make_shared<Product>(
                 std::make_shared<Polynomial>(std::make_shared<Cosecant>(argument), 2.0),
-                argument->derivative()));
+                Derivative::of(argument)));
     }
 
 // Inverse trig derivatives
 
 // sin^-1(f(x))' = arcsin(f(x))' = f'(x)(1-f(x)^2)^(-1/2) = f'(x)/sqrt(1-f(x)^2)
 std::shared_ptr<Function> Arcsin::derivative() const{
+    CALC_PROBE(Derivative, Arcsin);
     return std::make_shared<Product>(
         std::make_shared<Polynomial>(
-            std::make_shared<Difference>(std::make_shared<Constant>(1.0), 
-                std::make_shared<Polynomial>(argument), 2.0), 
+            std::make_shared<Difference>(Constant::one(), 
+                std::make_shared<Polynomial>(argument, 2.0)), 
             (-1.0/2.0)), 
-        argument->derivative());
+        Derivative::of(argument));
 }
 
 // cos^-1(f(x))' = arccos(f(x))' = -f'(x)(1-f(x)^2)^(-1/2) = -f'(x)/sqrt(1-f(x)^2) = -arcsin'(f(x))
 std::shared_ptr<Function> Arccos::derivative() const{
-    return std::make_shared<Product>(std::make_shared<Constant>(-1.0), 
+    CALC_PROBE(Derivative, Arccos);
+    return std::make_shared<Product>(Constant::negativeOne(), 
         std::make_shared<Arcsin>(argument)->derivative());
 }
 
 // arctan(x)' = f'(x)/(1 + f(x)^2)
 std::shared_ptr<Function> Arctan::derivative() const{
-    return std::make_shared<Quotient>(argument->derivative(),
-        std::make_shared<Sum>(std::make_shared<Constant>(1.0), std::make_shared<Polynomial>(argument, 2.0)));
+    CALC_PROBE(Derivative, Arctan);
+    return std::make_shared<Quotient>(Derivative::of(argument),
+        std::make_shared<Sum>(Constant::one(), std::make_shared<Polynomial>(argument, 2.0)));
 }
 
 // arccot(f(x))' = -arctan(f(x))' = -f'(x)/(1 + f(x)^2) 
 std::shared_ptr<Function> Arccot::derivative() const{
-        return std::make_shared<Product>(std::make_shared<Constant>(-1.0), 
+    CALC_PROBE(Derivative, Arccot);
+        return std::make_shared<Product>(Constant::negativeOne(), 
         std::make_shared<Arctan>(argument)->derivative());
 }
 
 // arcsec(f(x))' = f'(x) / (|f(x)|sqrt(f(x)^2 - 1))
 std::shared_ptr<Function> Arcsec::derivative() const{
-    return std::make_shared<Quotient>(argument->derivative(),
+    CALC_PROBE(Derivative, Arcsec);
+    return std::make_shared<Quotient>(Derivative::of(argument),
     std::make_shared<Product>(std::make_shared<AbsVal>(argument), 
     std::make_shared<Polynomial>(
-        std::make_shared<Difference>(std::make_shared<Polynomial>(argument, 2.0), std::make_shared<Constant>(1.0)), 1.0/2.0)));
+        std::make_shared<Difference>(std::make_shared<Polynomial>(argument, 2.0), Constant::one()), 1.0/2.0)));
 }
 
 // arccsc(f(x))' = -arcsec(f(x))' = -f'(x) / (|f(x)|sqrt(f(x)^2 - 1))
 std::shared_ptr<Function> Arccsc::derivative() const{
-    return std::make_shared<Product>(std::make_shared<Constant>(-1.0), 
+    CALC_PROBE(Derivative, Arccsc);
+    return std::make_shared<Product>(Constant::negativeOne(), 
         std::make_shared<Arcsec>(argument)->derivative());
 }
 
@@ -173,26 +195,30 @@ std::shared_ptr<Function> Arccsc::derivative() const{
 
 // sinh(f(x))' = cosh(f(x)) * f'(x)
 std::shared_ptr<Function> SineH::derivative() const{
-    return std::make_shared<Product>(std::make_shared<CosineH>(argument), argument->derivative());
+    CALC_PROBE(Derivative, SineH);
+    return std::make_shared<Product>(std::make_shared<CosineH>(argument), Derivative::of(argument));
 }
 
 // cosh(f(x))' = sinh(f(x)) * f'(x)
 std::shared_ptr<Function> CosineH::derivative() const{
-     return std::make_shared<Product>(std::make_shared<SineH>(argument), argument->derivative());
+    CALC_PROBE(Derivative, CosineH);
+     return std::make_shared<Product>(std::make_shared<SineH>(argument), Derivative::of(argument));
 }
 
 // tanh(f(x))' = sech(f(x))^2 * f'(x)
 std::shared_ptr<Function> TangentH::derivative() const{
+    CALC_PROBE(Derivative, TangentH);
     return std::make_shared<Product>(
-        std::make_shared<Polynomial>(std::make_shared<SecantH>(argument),2.0), argument->derivative());
+        std::make_shared<Polynomial>(std::make_shared<SecantH>(argument),2.0), Derivative::of(argument));
 }
 
 // sech(f(x))' = -sech(f(x)) * tanh(f(x)) * f'(x)
 std::shared_ptr<Function> SecantH::derivative() const{
+    CALC_PROBE(Derivative, SecantH);
     return std::make_shared<Product>(
-        std::make_shared<Constant>(-1.0),
+        Constant::negativeOne(),
         std::make_shared<Product>(
-            argument->derivative(),
+            Derivative::of(argument),
             std::make_shared<Product>(
                 std::make_shared<SecantH>(argument), 
                 std::make_shared<TangentH>(argument))));
@@ -200,20 +226,46 @@ std::shared_ptr<Function> SecantH::derivative() const{
 
 // csch(f(x))' = -csch(f(x)) * coth(f(x)) * f'(x) 
 std::shared_ptr<Function> CosecantH::derivative() const{
+    CALC_PROBE(Derivative, CosecantH);
     return std::make_shared<Product>(
-        std::make_shared<Constant>(-1.0),
+        Constant::negativeOne(),
         std::make_shared<Product>(
-            argument->derivative(),
+            Derivative::of(argument),
             std::make_shared<Product>(
                 std::make_shared<CosecantH>(argument), 
-                std::make_shared<Cotangent>(argument))));
+                std::make_shared<CotangentH>(argument))));
 }
 
 // coth(f(x))' =  -csch(f(x))^2 * f'(x)
 std::shared_ptr<Function> CotangentH::derivative() const{
+    CALC_PROBE(Derivative, CotangentH);
     return std::make_shared<Product>(
-        std::make_shared<Polynomial>(std::make_shared<Constant>(-1.0), 
+        Constant::negativeOne(), 
         std::make_shared<Product>(
-            std::make_shared<CosecantH>(argument),2.0),
-            argument->derivative()));
-}
\ No newline at end of file
+            std::make_shared<Polynomial>(std::make_shared<CosecantH>(argument),2.0),
+            Derivative::of(argument)));
+}
+// Lazy derivatives
+
+std::shared_ptr<Function> Derivative::of(const std::shared_ptr<Function>& f){
+    if(dynamic_cast<const Constant*>(f.get()) || dynamic_cast<const Variable*>(f.get()) ||
+        dynamic_cast<const Parameter*>(f.get())){
+        return f->derivative();
+    }
+    return std::make_shared<Derivative>(f);
+}
+
+const std::shared_ptr<Function>& Derivative::materialize() const{
+    bool building = false;
+    std::call_once(built, [this, &building]{
+        building = true;
+        result = function->derivative();
+    });
+    CALC_CACHE_ACCESS(LazyDerivative, !building);
+    return result;
+}
+
+// (f'(x))' is built from the memoized f'(x), which only builds its top node
+std::shared_ptr<Function> Derivative::derivative() const{
+    return Derivative::of(materialize());
+}
@@ -1,4 +1,14 @@
 #include "Functions.h"
+#include "evaluateKernels.h"
+#include "scalarMath.h"
+#include "fastMath.h"
+#include "instrumentation.h"
+
+/*
+    Each function applies a scalar kernel to the values of its children.
+    The kernels are shared with the evaluators that do not walk a Function tree
+    (see evaluateKind in nodeKind.cpp) so every evaluator gives the same result.
+*/
 
 /*
     Base functions
@@ -6,10 +16,12 @@
 */
 
 double Constant::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Constant);
     return value;
 }
 
 double Variable::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Variable);
     return x;
 }
 
@@ -19,23 +31,31 @@ double Variable::evaluate(double x) const{
 */
 
 double Sum::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Sum);
     return left->evaluate(x) + right->evaluate(x);
 }
 
 double Difference::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Difference);
     return left->evaluate(x) - right->evaluate(x);
 }
 
 double Product::evaluate(double x) const {
+    CALC_PROBE(Evaluate, Product);
     return left->evaluate(x) * right->evaluate(x);
 }
 
-double Quotient::evaluate(double x) const{
-    double denominator = right->evaluate(0.0);
-    if(denominator == 0.0){
-        throw std::runtime_error("Error divide by 0");
+template<class T>
+T quotientKernel(T a, T b){
+    if(b == 0.0){
+        return divideByZero(a, b);
     }
-    return left->evaluate(x) / denominator;
+    return a / b;
+}
+
+double Quotient::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Quotient);
+    return quotientKernel(left->evaluate(x), right->evaluate(x));
 }
 
 /*
@@ -43,20 +63,46 @@ double Quotient::evaluate(double x) const{
     Function list: Absolute value, Polynomial, Logarithmic, Exponential
 */
 
+template<class T>
+T absKernel(T a){
+    return ScalarMath<T>::abs(a);
+}
+
 double AbsVal::evaluate(double x) const{
-    return std::abs(x);
+    CALC_PROBE(Evaluate, AbsVal);
+    return absKernel(argument->evaluate(x));
+}
+
+template<class T>
+T polynomialKernel(T a, T exponent){
+    return ScalarMath<T>::pow(a, exponent);
 }
 
 double Polynomial::evaluate(double x) const{
-    return std::pow(coefficient->evaluate(x), exponent);
+    CALC_PROBE(Evaluate, Polynomial);
+    return polynomialKernel(coefficient->evaluate(x), exponent);
+}
+
+// log_b(a) = ln(a) / ln(b)
+template<class T>
+T logarithmicKernel(T b, T a){
+    return ScalarMath<T>::log(a) / ScalarMath<T>::log(b);
 }
 
 double Logarithmic::evaluate (double x) const{
-    return std::log(argument->evaluate(x)) / std::log(base->evaluate(x));
+    CALC_PROBE(Evaluate, Logarithmic);
+    return logarithmicKernel(base->evaluate(x), argument->evaluate(x));
+}
+
+// b^a
+template<class T>
+T exponentialKernel(T b, T a){
+    return ScalarMath<T>::pow(b, a);
 }
 
 double Exponential::evaluate (double x) const{
-    return std::pow(base->evaluate(x), argument->evaluate(x));
+    CALC_PROBE(Evaluate, Exponential);
+    return exponentialKernel(base->evaluate(x), argument->evaluate(x));
 }
 
 /*
@@ -64,67 +110,103 @@ double Exponential::evaluate (double x) const{
     Function list: sin, cos, tan, sec, csc, cot, inverse trig functions, hyperbolic functions
 */
 
-double Sine::evaluate(double x) const{
-    double val = std::sin(this->getArgument()->evaluate(x));
-    if(std::abs(val) <= EPSILON){
-        return 0.0;
+template<class T>
+T sineKernel(T a){
+    T val = ScalarMath<T>::sin(a);
+    if(ScalarMath<T>::abs(val) <= epsilonOf<T>()){
+        return T(0);
     }
-    if(val > 1.0 - EPSILON && val < 1.0 + EPSILON){
-        return 1.0;
+    if(val > T(1) - epsilonOf<T>() && val < T(1) + epsilonOf<T>()){
+        return T(1);
         }
 
     return val;
 }
 
-double Cosine::evaluate (double x) const  {
-    double val = std::cos(this->getArgument()->evaluate(x));
-    if(std::abs(val) <= EPSILON){
-        return 0.0;
+double Sine::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Sine);
+    return sineKernel(argument->evaluate(x));
+}
+
+template<class T>
+T cosineKernel(T a){
+    T val = ScalarMath<T>::cos(a);
+    if(ScalarMath<T>::abs(val) <= epsilonOf<T>()){
+        return T(0);
     }
-    if(val > 1.0 - EPSILON && val < 1.0 + EPSILON){
-        return 1.0;
+    if(val > T(1) - epsilonOf<T>() && val < T(1) + epsilonOf<T>()){
+        return T(1);
     }
     return val;
 }
 
-double Tangent::evaluate (double x) const {
-    double val = std::tan(this->getArgument()->evaluate(x));
-    if(std::abs(val) <= EPSILON){
-        return 0.0;
+double Cosine::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Cosine);
+    return cosineKernel(argument->evaluate(x));
+}
+
+template<class T>
+T tangentKernel(T a){
+    T val = ScalarMath<T>::tan(a);
+    if(ScalarMath<T>::abs(val) <= epsilonOf<T>()){
+        return T(0);
     }
-    if(val > 1 - EPSILON && val < 1 + EPSILON){
-        return 1;
+    if(val > T(1) - epsilonOf<T>() && val < T(1) + epsilonOf<T>()){
+        return T(1);
     }
     return val;
 }
 
-double Secant::evaluate (double x) const {
-    double val = std::cos(this->getArgument()->evaluate(x));
-    if(val > 0 - EPSILON && val < 0 + EPSILON){
-        throw std::runtime_error("Error divide by 0");
+double Tangent::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Tangent);
+    return tangentKernel(argument->evaluate(x));
+}
+
+template<class T>
+T secantKernel(T a){
+    T val = ScalarMath<T>::cos(a);
+    if(val > T(0) - epsilonOf<T>() && val < T(0) + epsilonOf<T>()){
+        return divideByZero(T(1), val);
     }
-    if(val > 1.0 - EPSILON && val < 1.0 + EPSILON){
-        return 1.0;
+    if(val > T(1) - epsilonOf<T>() && val < T(1) + epsilonOf<T>()){
+        return T(1);
     }
-    return 1.0 / val;
+    return T(1) / val;
 }
 
-double Cosecant::evaluate (double x) const {
-    double aVal = std::sin(this->getArgument()->evaluate(x));
-    if(aVal > 0.0 - EPSILON && aVal < 0.0 + EPSILON){
-        throw std::runtime_error("Error divide by 0");
+double Secant::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Secant);
+    return secantKernel(argument->evaluate(x));
+}
+
+template<class T>
+T cosecantKernel(T a){
+    T aVal = ScalarMath<T>::sin(a);
+    if(aVal > T(0) - epsilonOf<T>() && aVal < T(0) + epsilonOf<T>()){
+        return divideByZero(T(1), aVal);
     }
-    if(aVal > 1.0 - EPSILON && aVal < 1.0 + EPSILON) return 1.0;
-    return 1.0 / aVal;
+    if(aVal > T(1) - epsilonOf<T>() && aVal < T(1) + epsilonOf<T>()) return T(1);
+    return T(1) / aVal;
+}
+
+double Cosecant::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Cosecant);
+    return cosecantKernel(argument->evaluate(x));
 }
 
-double Cotangent::evaluate (double x) const {
-    double aVal = std::tan(this->getArgument()->evaluate(x));
-    if(aVal > 0.0 - EPSILON && aVal < 0.0 + EPSILON){
-        throw std::runtime_error("Error divide by 0");
+template<class T>
+T cotangentKernel(T a){
+    T aVal = ScalarMath<T>::tan(a);
+    if(aVal > T(0) - epsilonOf<T>() && aVal < T(0) + epsilonOf<T>()){
+        return divideByZero(T(1), aVal);
     }
-    if(aVal > 1.0 - EPSILON && aVal < 1.0 + EPSILON) return 1.0;
-    return 1.0 / aVal;
+    if(aVal > T(1) - epsilonOf<T>() && aVal < T(1) + epsilonOf<T>()) return T(1);
+    return T(1) / aVal;
+}
+
+double Cotangent::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Cotangent);
+    return cotangentKernel(argument->evaluate(x));
 }
 
 /*
@@ -132,40 +214,76 @@ double Cotangent::evaluate (double x) const {
     Function List: arcsin, arccos, artan, arccot, arcsec, arccsc
 */
 
-double Arcsin::evaluate (double x) const {
-    return std::asin(this->getArgument()->evaluate(x));
+template<class T>
+T arcsinKernel(T a){
+    return ScalarMath<T>::asin(a);
+}
+
+double Arcsin::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Arcsin);
+    return arcsinKernel(argument->evaluate(x));
+}
+
+template<class T>
+T arccosKernel(T a){
+    return ScalarMath<T>::acos(a);
+}
+
+double Arccos::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Arccos);
+    return arccosKernel(argument->evaluate(x));
 }
 
-double Arccos::evaluate (double x) const {
-    return std::acos(argument->evaluate(x));
+template<class T>
+T arctanKernel(T a){
+    return ScalarMath<T>::atan(a);
 }
 
-double Arctan::evaluate (double x) const {
-    return std::atan(argument->evaluate(x));
+double Arctan::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Arctan);
+    return arctanKernel(argument->evaluate(x));
 }
 
-double Arccot::evaluate (double x) const {
-    double val = argument->evaluate(x);
-    if (val == 0.0) {
-        throw std::runtime_error("Error divide by 0");
+template<class T>
+T arccotKernel(T a){
+    T val = a;
+    if(val == 0.0){
+        return ScalarMath<T>::atan(divideByZero(T(1), val));
     }
-    return std::atan(1.0 / val);
+    return ScalarMath<T>::atan(T(1) / val);
+}
+
+double Arccot::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Arccot);
+    return arccotKernel(argument->evaluate(x));
 }
 
-double Arcsec::evaluate (double x) const {
-    double val = argument->evaluate(x);
+template<class T>
+T arcsecKernel(T a){
+    T val = a;
     if(val == 0.0){
-        throw std::runtime_error("Error divide by 0");
+        return ScalarMath<T>::acos(divideByZero(T(1), val));
     }
-    return std::acos(1.0 / val);
+    return ScalarMath<T>::acos(T(1) / val);
 }
 
-double Arccsc::evaluate (double x) const {
-    double val = argument->evaluate(x);
+double Arcsec::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Arcsec);
+    return arcsecKernel(argument->evaluate(x));
+}
+
+template<class T>
+T arccscKernel(T a){
+    T val = a;
     if(val == 0.0){
-        throw std::runtime_error("Error divide by 0");
+        return ScalarMath<T>::asin(divideByZero(T(1), val));
     }
-    return std::asin(1.0 / val);
+    return ScalarMath<T>::asin(T(1) / val);
+}
+
+double Arccsc::evaluate(double x) const{
+    CALC_PROBE(Evaluate, Arccsc);
+    return arccscKernel(argument->evaluate(x));
 }
 
 /*
@@ -174,41 +292,113 @@ double Arccsc::evaluate (double x) const {
     Function list: sinh, cosh, tanh, coth, sech, csch
 */
 
-double SineH::evaluate (double x) const {
-    return std::sinh(argument->evaluate(x));
+template<class T>
+T sineHKernel(T a){
+    return ScalarMath<T>::sinh(a);
+}
+
+double SineH::evaluate(double x) const{
+    CALC_PROBE(Evaluate, SineH);
+    return sineHKernel(argument->evaluate(x));
+}
+
+template<class T>
+T cosineHKernel(T a){
+    return ScalarMath<T>::cosh(a);
+}
+
+double CosineH::evaluate(double x) const{
+    CALC_PROBE(Evaluate, CosineH);
+    return cosineHKernel(argument->evaluate(x));
 }
 
-double CosineH::evaluate (double x) const {
-    return std::cosh(argument->evaluate(x));
+template<class T>
+T tangentHKernel(T a){
+    return ScalarMath<T>::tanh(a);
 }
 
-double TangentH::evaluate (double x) const {
-    return std::tanh(argument->evaluate(x));
+double TangentH::evaluate(double x) const{
+    CALC_PROBE(Evaluate, TangentH);
+    return tangentHKernel(argument->evaluate(x));
 }
 
-double SecantH::evaluate (double x) const {
-    double val = std::cosh(argument->evaluate(x));
-    if(val > 0.0 - EPSILON && val < 0.0 + EPSILON){
-        throw std::runtime_error("Error divide by 0");
+template<class T>
+T secantHKernel(T a){
+    T val = ScalarMath<T>::cosh(a);
+    if(val > T(0) - epsilonOf<T>() && val < T(0) + epsilonOf<T>()){
+        return divideByZero(T(1), val);
     }
-    if(val > 1.0 - EPSILON && val < 1.0 + EPSILON) return 1.0;
-    return 1.0 / val;
+    if(val > T(1) - epsilonOf<T>() && val < T(1) + epsilonOf<T>()) return T(1);
+    return T(1) / val;
+}
+
+double SecantH::evaluate(double x) const{
+    CALC_PROBE(Evaluate, SecantH);
+    return secantHKernel(argument->evaluate(x));
 }
 
-double CosecantH::evaluate (double x) const {
-    double val = std::sinh(argument->evaluate(x));
-    if(val > 0.0 - EPSILON && val < 0.0 + EPSILON){
-        throw std::runtime_error("Error divide by 0");
+template<class T>
+T cosecantHKernel(T a){
+    T val = ScalarMath<T>::sinh(a);
+    if(val > T(0) - epsilonOf<T>() && val < T(0) + epsilonOf<T>()){
+        return divideByZero(T(1), val);
     }
-    if(val > 1.0 - EPSILON && val < 1.0 + EPSILON) return 1.0;
-    return 1.0 / val;
+    if(val > T(1) - epsilonOf<T>() && val < T(1) + epsilonOf<T>()) return T(1);
+    return T(1) / val;
+}
+
+double CosecantH::evaluate(double x) const{
+    CALC_PROBE(Evaluate, CosecantH);
+    return cosecantHKernel(argument->evaluate(x));
 }
 
-double CotangentH::evaluate (double x) const {
-    double val = std::tanh(argument->evaluate(x));
-    if(val > 0.0 - EPSILON && val < 0.0 + EPSILON){
-        throw std::runtime_error("Error divide by 0");
+template<class T>
+T cotangentHKernel(T a){
+    T val = ScalarMath<T>::tanh(a);
+    if(val > T(0) - epsilonOf<T>() && val < T(0) + epsilonOf<T>()){
+        return divideByZero(T(1), val);
     }
-    if(val > 1.0 - EPSILON && val < 1.0 + EPSILON) return 1.0;
-    return 1.0 / val;
+    if(val > T(1) - epsilonOf<T>() && val < T(1) + epsilonOf<T>()) return T(1);
+    return T(1) / val;
 }
+
+double CotangentH::evaluate(double x) const{
+    CALC_PROBE(Evaluate, CotangentH);
+    return cotangentHKernel(argument->evaluate(x));
+}
+
+// Lazy derivative, builds f'(x) on the first evaluation
+double Derivative::evaluate(double x) const{
+    return materialize()->evaluate(x);
+}
+
+/*
+    Kernels for every scalar type (scalarMath.h)
+*/
+
+#define CALC_INSTANTIATE_KERNELS(T) \
+    template T quotientKernel<T>(T, T); \
+    template T absKernel<T>(T); \
+    template T polynomialKernel<T>(T, T); \
+    template T logarithmicKernel<T>(T, T); \
+    template T exponentialKernel<T>(T, T); \
+    template T sineKernel<T>(T); \
+    template T cosineKernel<T>(T); \
+    template T tangentKernel<T>(T); \
+    template T secantKernel<T>(T); \
+    template T cosecantKernel<T>(T); \
+    template T cotangentKernel<T>(T); \
+    template T arcsinKernel<T>(T); \
+    template T arccosKernel<T>(T); \
+    template T arctanKernel<T>(T); \
+    template T arccotKernel<T>(T); \
+    template T arcsecKernel<T>(T); \
+    template T arccscKernel<T>(T); \
+    template T sineHKernel<T>(T); \
+    template T cosineHKernel<T>(T); \
+    template T tangentHKernel<T>(T); \
+    template T secantHKernel<T>(T); \
+    template T cosecantHKernel<T>(T); \
+    template T cotangentHKernel<T>(T);
+
+CALC_FOR_EACH_SCALAR(CALC_INSTANTIATE_KERNELS)
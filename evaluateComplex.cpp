@@ -0,0 +1,300 @@
+#include "Functions.h"
+#include "evaluateKernels.h"
+#include "parameters.h"
+
+/*
+    Complex evaluation
+    Every function is continued to complex arguments with the principal branch of the C++ library:
+        log, non-integer powers     cut along the negative real axis
+        arcsin, arccos              cuts along the real axis outside [-1, 1]
+        arctan                      cuts along the imaginary axis outside [-i, i]
+    Integer powers are repeated multiplications and have no cut. The absolute value is continued as
+    z or -z by the sign of the real part (not the modulus), so it stays differentiable along the real
+    axis for the complex step. Values close to 0 and 1 are not snapped as evaluate() does, since the
+    imaginary part of a complex step is far smaller than EPSILON. A reciprocal of exactly 0 is
+    reported through divideByZero like in evaluate().
+*/
+
+/*
+    Kernels
+*/
+
+// 1 / a
+static Complex reciprocal(const Complex& a){
+    if(a == 0.0){
+        return divideByZero(1.0, a.real());
+    }
+    return 1.0 / a;
+}
+
+template<>
+Complex quotientKernel(Complex a, Complex b){
+    if(b == 0.0){
+        return divideByZero(a.real(), b.real());
+    }
+    return a / b;
+}
+
+template<>
+Complex absKernel(Complex a){
+    return a.real() < 0.0 ? -a : a;
+}
+
+template<>
+Complex polynomialKernel(Complex a, Complex exponent){
+    double n = exponent.real();
+    if(exponent.imag() == 0.0 && n == std::floor(n) && std::abs(n) <= 64){
+        Complex result = 1.0;
+        Complex power = a;
+        for(unsigned k = unsigned(std::abs(n)); k; k >>= 1){
+            if(k & 1) result *= power;
+            power *= power;
+        }
+        return n < 0 ? 1.0 / result : result;
+    }
+    if(a == 0.0 && exponent.imag() == 0.0) return std::pow(0.0, n);
+    return std::pow(a, exponent);
+}
+
+// log_b(a) = ln(a) / ln(b)
+template<>
+Complex logarithmicKernel(Complex b, Complex a){
+    return std::log(a) / std::log(b);
+}
+
+// b^a
+template<>
+Complex exponentialKernel(Complex b, Complex a){
+    return polynomialKernel(b, a);
+}
+
+template<>
+Complex sineKernel(Complex a){
+    return std::sin(a);
+}
+
+template<>
+Complex cosineKernel(Complex a){
+    return std::cos(a);
+}
+
+template<>
+Complex tangentKernel(Complex a){
+    return std::tan(a);
+}
+
+template<>
+Complex secantKernel(Complex a){
+    return reciprocal(std::cos(a));
+}
+
+template<>
+Complex cosecantKernel(Complex a){
+    return reciprocal(std::sin(a));
+}
+
+template<>
+Complex cotangentKernel(Complex a){
+    return reciprocal(std::tan(a));
+}
+
+template<>
+Complex arcsinKernel(Complex a){
+    return std::asin(a);
+}
+
+template<>
+Complex arccosKernel(Complex a){
+    return std::acos(a);
+}
+
+template<>
+Complex arctanKernel(Complex a){
+    return std::atan(a);
+}
+
+template<>
+Complex arccotKernel(Complex a){
+    return std::atan(reciprocal(a));
+}
+
+template<>
+Complex arcsecKernel(Complex a){
+    return std::acos(reciprocal(a));
+}
+
+template<>
+Complex arccscKernel(Complex a){
+    return std::asin(reciprocal(a));
+}
+
+template<>
+Complex sineHKernel(Complex a){
+    return std::sinh(a);
+}
+
+template<>
+Complex cosineHKernel(Complex a){
+    return std::cosh(a);
+}
+
+template<>
+Complex tangentHKernel(Complex a){
+    return std::tanh(a);
+}
+
+template<>
+Complex secantHKernel(Complex a){
+    return reciprocal(std::cosh(a));
+}
+
+template<>
+Complex cosecantHKernel(Complex a){
+    return reciprocal(std::sinh(a));
+}
+
+template<>
+Complex cotangentHKernel(Complex a){
+    return reciprocal(std::tanh(a));
+}
+
+/*
+    Base functions
+    Function list: Constant, variable, parameter
+*/
+
+Complex Constant::evaluateComplex(const Complex&) const{
+    return value;
+}
+
+Complex Variable::evaluateComplex(const Complex& z) const{
+    return z;
+}
+
+Complex Parameter::evaluateComplex(const Complex&) const{
+    return table->value(slot);
+}
+
+/*
+    Arithmetic functions
+    Function list: Sum, Difference, Product, Quotient
+*/
+
+Complex Sum::evaluateComplex(const Complex& z) const{
+    return left->evaluateComplex(z) + right->evaluateComplex(z);
+}
+
+Complex Difference::evaluateComplex(const Complex& z) const{
+    return left->evaluateComplex(z) - right->evaluateComplex(z);
+}
+
+Complex Product::evaluateComplex(const Complex& z) const{
+    return left->evaluateComplex(z) * right->evaluateComplex(z);
+}
+
+Complex Quotient::evaluateComplex(const Complex& z) const{
+    return quotientKernel(left->evaluateComplex(z), right->evaluateComplex(z));
+}
+
+/*
+    Miscellaneous elementary functions
+    Function list: Absolute value, Polynomial, Logarithmic, Exponential
+*/
+
+Complex AbsVal::evaluateComplex(const Complex& z) const{
+    return absKernel(argument->evaluateComplex(z));
+}
+
+Complex Polynomial::evaluateComplex(const Complex& z) const{
+    return polynomialKernel(coefficient->evaluateComplex(z), Complex(exponent));
+}
+
+Complex Logarithmic::evaluateComplex(const Complex& z) const{
+    return logarithmicKernel(base->evaluateComplex(z), argument->evaluateComplex(z));
+}
+
+Complex Exponential::evaluateComplex(const Complex& z) const{
+    return exponentialKernel(base->evaluateComplex(z), argument->evaluateComplex(z));
+}
+
+/*
+    Trigonometric functions
+    Function list: sin, cos, tan, sec, csc, cot, inverse trig functions, hyperbolic functions
+*/
+
+Complex Sine::evaluateComplex(const Complex& z) const{
+    return sineKernel(argument->evaluateComplex(z));
+}
+
+Complex Cosine::evaluateComplex(const Complex& z) const{
+    return cosineKernel(argument->evaluateComplex(z));
+}
+
+Complex Tangent::evaluateComplex(const Complex& z) const{
+    return tangentKernel(argument->evaluateComplex(z));
+}
+
+Complex Secant::evaluateComplex(const Complex& z) const{
+    return secantKernel(argument->evaluateComplex(z));
+}
+
+Complex Cosecant::evaluateComplex(const Complex& z) const{
+    return cosecantKernel(argument->evaluateComplex(z));
+}
+
+Complex Cotangent::evaluateComplex(const Complex& z) const{
+    return cotangentKernel(argument->evaluateComplex(z));
+}
+
+Complex Arcsin::evaluateComplex(const Complex& z) const{
+    return arcsinKernel(argument->evaluateComplex(z));
+}
+
+Complex Arccos::evaluateComplex(const Complex& z) const{
+    return arccosKernel(argument->evaluateComplex(z));
+}
+
+Complex Arctan::evaluateComplex(const Complex& z) const{
+    return arctanKernel(argument->evaluateComplex(z));
+}
+
+Complex Arccot::evaluateComplex(const Complex& z) const{
+    return arccotKernel(argument->evaluateComplex(z));
+}
+
+Complex Arcsec::evaluateComplex(const Complex& z) const{
+    return arcsecKernel(argument->evaluateComplex(z));
+}
+
+Complex Arccsc::evaluateComplex(const Complex& z) const{
+    return arccscKernel(argument->evaluateComplex(z));
+}
+
+Complex SineH::evaluateComplex(const Complex& z) const{
+    return sineHKernel(argument->evaluateComplex(z));
+}
+
+Complex CosineH::evaluateComplex(const Complex& z) const{
+    return cosineHKernel(argument->evaluateComplex(z));
+}
+
+Complex TangentH::evaluateComplex(const Complex& z) const{
+    return tangentHKernel(argument->evaluateComplex(z));
+}
+
+Complex SecantH::evaluateComplex(const Complex& z) const{
+    return secantHKernel(argument->evaluateComplex(z));
+}
+
+Complex CosecantH::evaluateComplex(const Complex& z) const{
+    return cosecantHKernel(argument->evaluateComplex(z));
+}
+
+Complex CotangentH::evaluateComplex(const Complex& z) const{
+    return cotangentHKernel(argument->evaluateComplex(z));
+}
+
+// Lazy derivative, builds f'(x) on the first evaluation
+Complex Derivative::evaluateComplex(const Complex& z) const{
+    return materialize()->evaluateComplex(z);
+}
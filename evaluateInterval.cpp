@@ -0,0 +1,185 @@
+#include "Functions.h"
+
+/*
+    Interval evaluation
+    Each function returns a guaranteed enclosure of the values evaluate() returns for every x in the
+    given interval. The operations of interval.h bound the exact functions, so the kernels that snap
+    values within EPSILON of 0 and 1 (sin, cos, tan and the reciprocal functions) add the snapped
+    values to their enclosures here.
+    A denominator whose enclosure excludes 0 is proven to never hit 0 on the whole interval.
+*/
+
+// Enclosure of the sin, cos and tan kernels from that of the exact function: 0 and 1 are added if
+// some value is close enough to be snapped to them
+static Interval snapped(const Interval& exact){
+    if(exact.isEmpty()) return exact;
+    Interval result = exact;
+    if(exact.lo <= EPSILON && exact.hi >= -EPSILON) result = hull(result, Interval(0.0));
+    if(exact.lo < 1.0 + EPSILON && exact.hi > 1.0 - EPSILON) result = hull(result, Interval(1.0));
+    return result;
+}
+
+// Enclosure of the reciprocal kernels (sec, csc, cot and their hyperbolic forms) from that of the
+// value they invert: a value within EPSILON of 0 divides by zero, one within EPSILON of 1 gives 1
+static Interval snappedReciprocal(const Interval& inverted){
+    if(inverted.isEmpty()) return inverted;
+    if(inverted.lo < EPSILON && inverted.hi > -EPSILON) return Interval::entire();
+    Interval result = intervalReciprocal(inverted);
+    if(inverted.lo < 1.0 + EPSILON && inverted.hi > 1.0 - EPSILON) result = hull(result, Interval(1.0));
+    return result;
+}
+
+/*
+    Base functions
+    Function list: Constant, variable
+*/
+
+Interval Constant::evaluateInterval(const Interval&) const{
+    return Interval(value);
+}
+
+Interval Variable::evaluateInterval(const Interval& x) const{
+    return x;
+}
+
+/*
+    Arithmetic functions
+    Function list: Sum, Difference, Product, Quotient
+*/
+
+Interval Sum::evaluateInterval(const Interval& x) const{
+    return intervalAdd(left->evaluateInterval(x), right->evaluateInterval(x));
+}
+
+Interval Difference::evaluateInterval(const Interval& x) const{
+    return intervalSub(left->evaluateInterval(x), right->evaluateInterval(x));
+}
+
+Interval Product::evaluateInterval(const Interval& x) const{
+    return intervalMul(left->evaluateInterval(x), right->evaluateInterval(x));
+}
+
+Interval Quotient::evaluateInterval(const Interval& x) const{
+    return intervalDiv(left->evaluateInterval(x), right->evaluateInterval(x));
+}
+
+/*
+    Miscellaneous elementary functions
+    Function list: Absolute value, Polynomial, Logarithmic, Exponential
+*/
+
+Interval AbsVal::evaluateInterval(const Interval& x) const{
+    return intervalAbs(argument->evaluateInterval(x));
+}
+
+Interval Polynomial::evaluateInterval(const Interval& x) const{
+    return intervalPow(coefficient->evaluateInterval(x), exponent);
+}
+
+Interval Logarithmic::evaluateInterval(const Interval& x) const{
+    return intervalLog(base->evaluateInterval(x), argument->evaluateInterval(x));
+}
+
+Interval Exponential::evaluateInterval(const Interval& x) const{
+    return intervalPow(base->evaluateInterval(x), argument->evaluateInterval(x));
+}
+
+/*
+    Trigonometric functions
+    Function list: sin, cos, tan, sec, csc, cot, inverse trig functions, hyperbolic functions
+*/
+
+Interval Sine::evaluateInterval(const Interval& x) const{
+    return snapped(intervalSin(argument->evaluateInterval(x)));
+}
+
+Interval Cosine::evaluateInterval(const Interval& x) const{
+    return snapped(intervalCos(argument->evaluateInterval(x)));
+}
+
+Interval Tangent::evaluateInterval(const Interval& x) const{
+    return snapped(intervalTan(argument->evaluateInterval(x)));
+}
+
+// sec(f(x)) = 1 / cos(f(x))
+Interval Secant::evaluateInterval(const Interval& x) const{
+    return snappedReciprocal(intervalCos(argument->evaluateInterval(x)));
+}
+
+// csc(f(x)) = 1 / sin(f(x))
+Interval Cosecant::evaluateInterval(const Interval& x) const{
+    return snappedReciprocal(intervalSin(argument->evaluateInterval(x)));
+}
+
+// cot(f(x)) = 1 / tan(f(x))
+Interval Cotangent::evaluateInterval(const Interval& x) const{
+    return snappedReciprocal(intervalTan(argument->evaluateInterval(x)));
+}
+
+/*
+    Inverse Trig function evaluations
+    Function List: arcsin, arccos, artan, arccot, arcsec, arccsc
+*/
+
+Interval Arcsin::evaluateInterval(const Interval& x) const{
+    return intervalAsin(argument->evaluateInterval(x));
+}
+
+Interval Arccos::evaluateInterval(const Interval& x) const{
+    return intervalAcos(argument->evaluateInterval(x));
+}
+
+Interval Arctan::evaluateInterval(const Interval& x) const{
+    return intervalAtan(argument->evaluateInterval(x));
+}
+
+// arccot(f(x)) = arctan(1 / f(x))
+Interval Arccot::evaluateInterval(const Interval& x) const{
+    return intervalAtan(intervalReciprocal(argument->evaluateInterval(x)));
+}
+
+// arcsec(f(x)) = arccos(1 / f(x))
+Interval Arcsec::evaluateInterval(const Interval& x) const{
+    return intervalAcos(intervalReciprocal(argument->evaluateInterval(x)));
+}
+
+// arccsc(f(x)) = arcsin(1 / f(x))
+Interval Arccsc::evaluateInterval(const Interval& x) const{
+    return intervalAsin(intervalReciprocal(argument->evaluateInterval(x)));
+}
+
+/*
+    Hyperbolic Functions
+    Function list: sinh, cosh, tanh, coth, sech, csch
+*/
+
+Interval SineH::evaluateInterval(const Interval& x) const{
+    return intervalSinh(argument->evaluateInterval(x));
+}
+
+Interval CosineH::evaluateInterval(const Interval& x) const{
+    return intervalCosh(argument->evaluateInterval(x));
+}
+
+Interval TangentH::evaluateInterval(const Interval& x) const{
+    return intervalTanh(argument->evaluateInterval(x));
+}
+
+// sech(f(x)) = 1 / cosh(f(x))
+Interval SecantH::evaluateInterval(const Interval& x) const{
+    return snappedReciprocal(intervalCosh(argument->evaluateInterval(x)));
+}
+
+// csch(f(x)) = 1 / sinh(f(x))
+Interval CosecantH::evaluateInterval(const Interval& x) const{
+    return snappedReciprocal(intervalSinh(argument->evaluateInterval(x)));
+}
+
+// coth(f(x)) = 1 / tanh(f(x))
+Interval CotangentH::evaluateInterval(const Interval& x) const{
+    return snappedReciprocal(intervalTanh(argument->evaluateInterval(x)));
+}
+
+Interval Derivative::evaluateInterval(const Interval& x) const{
+    return materialize()->evaluateInterval(x);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <complex>
+
+/*
+    Scalar kernels used by evaluate()
+    Each kernel takes the already evaluated children of a node and returns the value of the node.
+    Templates over the scalar type, instantiated in evaluate.cpp for every type of scalarMath.h;
+    evaluate() uses the double versions
+*/
+
+// Arithmetic (sum, difference and product are plain +, - and *)
+template<class T> T quotientKernel(T a, T b);
+
+// Miscellaneous elementary functions
+template<class T> T absKernel(T a);
+template<class T> T polynomialKernel(T a, T exponent);
+template<class T> T logarithmicKernel(T b, T a);
+template<class T> T exponentialKernel(T b, T a);
+
+// Trigonometric functions
+template<class T> T sineKernel(T a);
+template<class T> T cosineKernel(T a);
+template<class T> T tangentKernel(T a);
+template<class T> T secantKernel(T a);
+template<class T> T cosecantKernel(T a);
+template<class T> T cotangentKernel(T a);
+
+// Inverse trig functions
+template<class T> T arcsinKernel(T a);
+template<class T> T arccosKernel(T a);
+template<class T> T arctanKernel(T a);
+template<class T> T arccotKernel(T a);
+template<class T> T arcsecKernel(T a);
+template<class T> T arccscKernel(T a);
+
+// Hyperbolic functions
+template<class T> T sineHKernel(T a);
+template<class T> T cosineHKernel(T a);
+template<class T> T tangentHKernel(T a);
+template<class T> T secantHKernel(T a);
+template<class T> T cosecantHKernel(T a);
+template<class T> T cotangentHKernel(T a);
+
+// Complex arguments, specialized in evaluateComplex.cpp: principal branches and no snapping of
+// values close to 0 and 1
+template<> std::complex<double> quotientKernel(std::complex<double> a, std::complex<double> b);
+template<> std::complex<double> absKernel(std::complex<double> a);
+template<> std::complex<double> polynomialKernel(std::complex<double> a, std::complex<double> exponent);
+template<> std::complex<double> logarithmicKernel(std::complex<double> b, std::complex<double> a);
+template<> std::complex<double> exponentialKernel(std::complex<double> b, std::complex<double> a);
+template<> std::complex<double> sineKernel(std::complex<double> a);
+template<> std::complex<double> cosineKernel(std::complex<double> a);
+template<> std::complex<double> tangentKernel(std::complex<double> a);
+template<> std::complex<double> secantKernel(std::complex<double> a);
+template<> std::complex<double> cosecantKernel(std::complex<double> a);
+template<> std::complex<double> cotangentKernel(std::complex<double> a);
+template<> std::complex<double> arcsinKernel(std::complex<double> a);
+template<> std::complex<double> arccosKernel(std::complex<double> a);
+template<> std::complex<double> arctanKernel(std::complex<double> a);
+template<> std::complex<double> arccotKernel(std::complex<double> a);
+template<> std::complex<double> arcsecKernel(std::complex<double> a);
+template<> std::complex<double> arccscKernel(std::complex<double> a);
+template<> std::complex<double> sineHKernel(std::complex<double> a);
+template<> std::complex<double> cosineHKernel(std::complex<double> a);
+template<> std::complex<double> tangentHKernel(std::complex<double> a);
+template<> std::complex<double> secantHKernel(std::complex<double> a);
+template<> std::complex<double> cosecantHKernel(std::complex<double> a);
+template<> std::complex<double> cotangentHKernel(std::complex<double> a);
@@ -0,0 +1,50 @@
+#include "evaluationStatus.h"
+#include "Functions.h"
+#include "tracing.h"
+#include "traversal.h"
+
+static thread_local bool strictEvaluation = false;
+static thread_local unsigned char currentErrors = EVAL_OK;
+
+void setStrictEvaluation(bool strict){
+    strictEvaluation = strict;
+}
+
+bool isStrictEvaluation(){
+    return strictEvaluation;
+}
+
+unsigned char evaluationErrors(){
+    return currentErrors;
+}
+
+void clearEvaluationErrors(){
+    currentErrors = EVAL_OK;
+}
+
+double divideByZero(double numerator, double denominator){
+    if(strictEvaluation){
+        throw std::runtime_error("Error divide by 0");
+    }
+    currentErrors |= EVAL_DIVIDE_BY_ZERO;
+    return numerator / std::copysign(0.0, denominator);
+}
+
+void evaluateGrid(const Function& f, const std::vector<double>& xs, std::vector<double>& results,
+    std::vector<unsigned char>* errors){
+    TraceSpan span("evaluateGrid", "points", xs.size());
+    results.resize(xs.size());
+    if(errors) errors->resize(xs.size());
+
+    // Trees too deep for the recursive evaluate() go through the iterative walk
+    bool deep = isDeep(f);
+    for(size_t i = 0; i < xs.size(); i++){
+        currentErrors = EVAL_OK;
+        results[i] = deep ? evaluateIterative(f, xs[i]) : f.evaluate(xs[i]);
+        if(std::isnan(results[i]) && currentErrors == EVAL_OK){
+            currentErrors |= EVAL_DOMAIN;
+        }
+        if(errors) (*errors)[i] = currentErrors;
+    }
+    currentErrors = EVAL_OK;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+
+class Function;
+
+/*
+    Error handling for evaluate()
+    By default evaluation never throws: a division by 0 returns the IEEE result (+-inf or NaN)
+    and records an error code for the current thread. Strict mode restores the old behaviour
+    of throwing std::runtime_error on every division by 0.
+*/
+
+// Error codes for a single evaluated point, combined as bit flags
+enum EvaluationError : unsigned char {
+    EVAL_OK = 0,
+    EVAL_DIVIDE_BY_ZERO = 1,    // A denominator was 0 (result is +-inf or NaN)
+    EVAL_DOMAIN = 2             // The result is NaN without a division by 0 (e.g. ln(-1))
+};
+
+// Turns strict (throwing) evaluation on or off for the calling thread. Off by default
+void setStrictEvaluation(bool strict);
+bool isStrictEvaluation();
+
+// Errors recorded on the calling thread since the last clearEvaluationErrors()
+unsigned char evaluationErrors();
+void clearEvaluationErrors();
+
+/**
+ * Called by evaluate() when a denominator is 0
+ *
+ * Precondition: denominator is 0 (or within EPSILON of 0)
+ * Postcondition: throws std::runtime_error in strict mode, otherwise records EVAL_DIVIDE_BY_ZERO
+ *                and returns numerator / 0 with the sign of denominator
+ */
+double divideByZero(double numerator, double denominator);
+
+/**
+ * Evaluates f at every point of xs without throwing
+ *
+ * Precondition: none
+ * Postcondition: results[i] = f(xs[i]), errors[i] = error code of xs[i] if errors is given
+ */
+void evaluateGrid(const Function& f, const std::vector<double>& xs, std::vector<double>& results,
+    std::vector<unsigned char>* errors = nullptr);
@@ -1,4 +1,10 @@
 #include "expressionSplit.h"
+#include "Functions.h"
+#include "parameters.h"
+#include "tracing.h"
+
+#include <cstring>
+#include <stdexcept>
 
 
 std::string trim(const std::string& str) {
@@ -147,3 +153,208 @@ std::vector<std::string> parseExpression(const std::string& expr) {
     return allTerms;
 }
 
+/*
+    Tree builder
+    Splits the expression at its lowest precedence operator outside parentheses and absolute value
+    bars, then builds both sides recursively:
+        + -     left associative, split at the last one
+        * /     left associative, split at the last one
+        -f(x)   unary minus
+        ^       right associative, split at the first one
+        function calls, |f(x)|, numbers, e, pi and variables
+*/
+
+// True if the + or - at position i is a sign rather than a binary operator (e.g. "-x", "2*-x", "1e-5")
+static bool isUnarySign(const std::string& expr, size_t i) {
+    if (i == 0) return true;
+    size_t j = expr.find_last_not_of(' ', i - 1);
+    if (j == std::string::npos) return true;
+    char prev = expr[j];
+    if (std::strchr("+-*/^(", prev)) return true;
+
+    // Exponent of a number written in scientific notation
+    if ((prev == 'e' || prev == 'E') && j > 0 && (std::isdigit(expr[j - 1]) || expr[j - 1] == '.')) {
+        size_t k = j;
+        while (k > 0 && (std::isdigit(expr[k - 1]) || expr[k - 1] == '.')) k--;
+        return k == 0 || !(std::isalnum(expr[k - 1]) || expr[k - 1] == '_');
+    }
+    return false;
+}
+
+// True if the | at position i opens an absolute value rather than closing one
+static bool opensAbsoluteValue(const std::string& expr, size_t i) {
+    if (i == 0) return true;
+    size_t j = expr.find_last_not_of(' ', i - 1);
+    return j == std::string::npos || std::strchr("+-*/^(|", expr[j]);
+}
+
+// Finds the first (or last) operator from ops outside of parentheses and absolute value bars
+static size_t findTopLevel(const std::string& expr, const char* ops, bool last) {
+    int depth = 0;
+    size_t found = std::string::npos;
+    for (size_t i = 0; i < expr.size(); i++) {
+        char c = expr[i];
+        if (c == '(') depth++;
+        else if (c == ')') depth--;
+        else if (c == '|') depth += opensAbsoluteValue(expr, i) ? 1 : -1;
+        else if (depth == 0 && std::strchr(ops, c)) {
+            if ((c == '+' || c == '-') && isUnarySign(expr, i)) continue;
+            if (!last) return i;
+            found = i;
+        }
+    }
+    if (depth != 0) {
+        throw std::runtime_error("Error unbalanced parentheses in \"" + expr + "\"");
+    }
+    return found;
+}
+
+// Position of the bracket closing the one opened at position open
+static size_t matchingClose(const std::string& expr, size_t open) {
+    int depth = 0;
+    for (size_t i = open; i < expr.size(); i++) {
+        if (expr[i] == '(') depth++;
+        else if (expr[i] == ')' && --depth == 0) return i;
+    }
+    return std::string::npos;
+}
+
+static bool isIdentifier(const std::string& str) {
+    if (str.empty() || !(std::isalpha(str[0]) || str[0] == '_')) return false;
+    for (char c : str) {
+        if (!(std::isalnum(c) || c == '_')) return false;
+    }
+    return true;
+}
+
+static std::shared_ptr<Function> build(const std::string& input, const std::shared_ptr<ParameterTable>& parameters);
+
+// Builds name(argument) for an elementary function
+static std::shared_ptr<Function> buildElementary(const std::string& name, std::shared_ptr<Function> arg,
+        const std::shared_ptr<ParameterTable>& parameters) {
+    if (name == "sin") return std::make_shared<Sine>(arg);
+    if (name == "cos") return std::make_shared<Cosine>(arg);
+    if (name == "tan") return std::make_shared<Tangent>(arg);
+    if (name == "sec") return std::make_shared<Secant>(arg);
+    if (name == "csc") return std::make_shared<Cosecant>(arg);
+    if (name == "cot") return std::make_shared<Cotangent>(arg);
+    if (name == "arcsin") return std::make_shared<Arcsin>(arg);
+    if (name == "arccos") return std::make_shared<Arccos>(arg);
+    if (name == "arctan") return std::make_shared<Arctan>(arg);
+    if (name == "arccot") return std::make_shared<Arccot>(arg);
+    if (name == "arcsec") return std::make_shared<Arcsec>(arg);
+    if (name == "arccsc") return std::make_shared<Arccsc>(arg);
+    if (name == "sinh") return std::make_shared<SineH>(arg);
+    if (name == "cosh") return std::make_shared<CosineH>(arg);
+    if (name == "tanh") return std::make_shared<TangentH>(arg);
+    if (name == "sech") return std::make_shared<SecantH>(arg);
+    if (name == "csch") return std::make_shared<CosecantH>(arg);
+    if (name == "coth") return std::make_shared<CotangentH>(arg);
+    if (name == "abs") return std::make_shared<AbsVal>(arg);
+    if (name == "ln") return std::make_shared<Logarithmic>(Constant::e(), arg);
+    if (name == "log") return std::make_shared<Logarithmic>(std::make_shared<Constant>(10.0), arg);
+    if (name == "exp") return std::make_shared<Exponential>(Constant::e(), arg);
+    if (name == "sqrt") return std::make_shared<Polynomial>(arg, 0.5);
+
+    // log_b(f(x)) and root_n(f(x))
+    if (name.rfind("log_", 0) == 0) return std::make_shared<Logarithmic>(build(name.substr(4), parameters), arg);
+    if (name.rfind("root_", 0) == 0) return std::make_shared<Polynomial>(arg, 1.0 / std::stod(name.substr(5)));
+
+    throw std::runtime_error("Error unknown function \"" + name + "\"");
+}
+
+// Builds a number, e, pi, a parameter bound in parameters or a variable
+static std::shared_ptr<Function> buildAtom(const std::string& expr, const std::shared_ptr<ParameterTable>& parameters) {
+    if (expr == "e") return Constant::e();
+    if (expr == "pi") return std::make_shared<Constant>(std::acos(-1.0));
+    if (parameters && parameters->contains(expr)) return std::make_shared<Parameter>(parameters, expr);
+    if (isIdentifier(expr)) return std::make_shared<Variable>(expr);
+
+    size_t used = 0;
+    double value = 0.0;
+    try {
+        value = std::stod(expr, &used);
+    }
+    catch (const std::exception&) {
+        used = 0;
+    }
+    if (used == 0 || used != expr.size()) {
+        throw std::runtime_error("Error cannot parse \"" + expr + "\"");
+    }
+    return std::make_shared<Constant>(value);
+}
+
+static std::shared_ptr<Function> build(const std::string& input, const std::shared_ptr<ParameterTable>& parameters) {
+    std::string expr = trim(input);
+    if (expr.empty()) {
+        throw std::runtime_error("Error empty expression");
+    }
+
+    // Remove parentheses around the whole expression
+    while (expr.front() == '(' && matchingClose(expr, 0) == expr.size() - 1) {
+        expr = trim(expr.substr(1, expr.size() - 2));
+        if (expr.empty()) throw std::runtime_error("Error empty expression");
+    }
+
+    size_t pos = findTopLevel(expr, "+-", true);
+    if (pos != std::string::npos) {
+        auto left = build(expr.substr(0, pos), parameters);
+        auto right = build(expr.substr(pos + 1), parameters);
+        if (expr[pos] == '+') return std::make_shared<Sum>(std::move(left), std::move(right));
+        return std::make_shared<Difference>(std::move(left), std::move(right));
+    }
+
+    pos = findTopLevel(expr, "*/", true);
+    if (pos != std::string::npos) {
+        auto left = build(expr.substr(0, pos), parameters);
+        auto right = build(expr.substr(pos + 1), parameters);
+        if (expr[pos] == '*') return std::make_shared<Product>(std::move(left), std::move(right));
+        return std::make_shared<Quotient>(std::move(left), std::move(right));
+    }
+
+    if (expr[0] == '-' || expr[0] == '+') {
+        auto operand = build(expr.substr(1), parameters);
+        if (expr[0] == '+') return operand;
+        if (auto constant = dynamic_cast<Constant*>(operand.get())) {
+            return std::make_shared<Constant>(-constant->getValue());
+        }
+        return std::make_shared<Product>(Constant::negativeOne(), std::move(operand));
+    }
+
+    pos = findTopLevel(expr, "^", false);
+    if (pos != std::string::npos) {
+        auto base = build(expr.substr(0, pos), parameters);
+        auto exponent = build(expr.substr(pos + 1), parameters);
+        if (auto constant = dynamic_cast<Constant*>(exponent.get())) {
+            return std::make_shared<Polynomial>(std::move(base), constant->getValue());
+        }
+        return std::make_shared<Exponential>(std::move(base), std::move(exponent));
+    }
+
+    // |f(x)|
+    if (expr.size() >= 2 && expr.front() == '|' && expr.back() == '|') {
+        return std::make_shared<AbsVal>(build(expr.substr(1, expr.size() - 2), parameters));
+    }
+
+    // name(f(x))
+    size_t open = expr.find('(');
+    if (open != std::string::npos && expr.back() == ')' && matchingClose(expr, open) == expr.size() - 1) {
+        std::string name = trim(expr.substr(0, open));
+        if (!isElementaryFunction(name)) {
+            throw std::runtime_error("Error unknown function \"" + name + "\"");
+        }
+        return buildElementary(name, build(expr.substr(open + 1, expr.size() - open - 2), parameters), parameters);
+    }
+
+    return buildAtom(expr, parameters);
+}
+
+std::shared_ptr<Function> buildFunction(const std::string& expr) {
+    TraceSpan span("parse");
+    return build(expr, nullptr);
+}
+
+std::shared_ptr<Function> buildFunction(const std::string& expr, const std::shared_ptr<ParameterTable>& parameters) {
+    TraceSpan span("parse");
+    return build(expr, parameters);
+}
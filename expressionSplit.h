@@ -7,13 +7,17 @@
 #include <cctype>
 #include <iostream>
 #include <unordered_set>
+#include <memory>
+
+class Function;
+class ParameterTable;
 
 // Set of supported elementary functions
-std::unordered_set<std::string> elementaryFunctions = {
+static const std::unordered_set<std::string> elementaryFunctions = {
     "sinh", "cosh", "tanh", "csch", "sech", "coth", 
     "sin", "cos", "tan", "sec", "csc", "cot",
-    "arctan", "arcsin", "arccos",
-    "ln", "log", "exp", "sqrt"
+    "arctan", "arcsin", "arccos", "arccot", "arcsec", "arccsc",
+    "ln", "log", "exp", "sqrt", "abs"
 };
 
 // Function to trim leading and trailing spaces
@@ -31,4 +35,11 @@ std::vector<std::string> parseElementaryFunctions(const std::string& term);
 // Function to split expressions by operators while handling parentheses
 std::vector<std::string> splitByOperators(const std::string& expr);
 
-std::vector<std::string> decomposeNestedFunctions(const std::string& func, const std::string& arg);
\ No newline at end of file
+std::vector<std::string> decomposeNestedFunctions(const std::string& func, const std::string& arg);
+
+// Builds a Function tree from an expression such as "sin(x^2) * ln(x) + 3"
+// Throws std::runtime_error if the expression cannot be parsed
+std::shared_ptr<Function> buildFunction(const std::string& expr);
+
+// Same as buildFunction(expr), but names defined in parameters become Parameter nodes
+std::shared_ptr<Function> buildFunction(const std::string& expr, const std::shared_ptr<ParameterTable>& parameters);
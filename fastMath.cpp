@@ -0,0 +1,343 @@
+#include "fastMath.h"
+
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <cstdint>
+#include <atomic>
+
+static thread_local Accuracy accuracy = Accuracy::Full;
+
+// Threads whose tier is not Full. While it is 0, which is the usual case, every function takes the
+// Full path after one plain load, without reading the thread_local tier
+static std::atomic<unsigned> approximateThreads{0};
+
+static inline bool fullTier(){
+    return approximateThreads.load(std::memory_order_relaxed) == 0 || accuracy == Accuracy::Full;
+}
+
+void setEvaluationAccuracy(Accuracy tier){
+    if((accuracy == Accuracy::Full) != (tier == Accuracy::Full)){
+        if(tier == Accuracy::Full) approximateThreads--;
+        else approximateThreads++;
+    }
+    accuracy = tier;
+}
+
+Accuracy evaluationAccuracy(){
+    return accuracy;
+}
+
+const char* accuracyName(Accuracy tier){
+    switch(tier){
+        case Accuracy::Full: return "full";
+        case Accuracy::Ulp: return "ulp";
+        case Accuracy::Fast: return "fast";
+        case Accuracy::Coarse: return "coarse";
+    }
+    return "unknown";
+}
+
+/*
+    Shared helpers
+*/
+
+static const double INV_PIO2 = 6.36619772367581382433e-01;     // 2/pi
+static const double PIO2_1 = 1.57079632673412561417e+00;       // First 33 bits of pi/2
+static const double PIO2_1T = 6.07710050650619224932e-11;      // pi/2 - PIO2_1
+static const double PIO2_2 = 6.07710050630396597660e-11;       // Next 33 bits of pi/2
+static const double PIO2_2T = 2.02226624879595063154e-21;      // pi/2 - (PIO2_1 + PIO2_2)
+static const double INV_LN2 = 1.44269504088896338700e+00;
+static const double LN2_HI = 6.93147180369123816490e-01;
+static const double LN2_LO = 1.90821492927058770002e-10;
+static const double LN2 = 6.93147180559945286227e-01;
+
+// Largest |x| for which k * PIO2_1 is exact (k < 2^20)
+static const double REDUCTION_LIMIT = 1.0e6;
+
+// Round to nearest without a library call, valid for |x| < 2^51
+static double roundToInteger(double x){
+    const double shifter = 6755399441055744.0;     // 1.5 * 2^52
+    return (x + shifter) - shifter;
+}
+
+// 2^k for -1022 <= k <= 1023
+static double powerOfTwo(int k){
+    uint64_t bits = uint64_t(k + 1023) << 52;
+    double result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// Splits a positive normal x into 2^k * m with 1 <= m < 2
+static double splitExponent(double x, int& k){
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    k = int((bits >> 52) & 0x7FF) - 1023;
+    bits = (bits & 0x000FFFFFFFFFFFFFull) | 0x3FF0000000000000ull;
+    double m;
+    std::memcpy(&m, &bits, sizeof(m));
+    return m;
+}
+
+// Both sin and cos from one argument reduction
+struct SinCos {
+    double sin;
+    double cos;
+};
+
+static SinCos fromQuadrant(double s, double c, long quadrant){
+    switch(quadrant & 3){
+        case 0: return {s, c};
+        case 1: return {c, -s};
+        case 2: return {-s, -c};
+        default: return {-c, s};
+    }
+}
+
+/*
+    Ulp tier: fdlibm style range reduction and minimax polynomials
+*/
+
+static SinCos sinCosUlp(double x){
+    double k = roundToInteger(x * INV_PIO2);
+    double r = ((x - k * PIO2_1) - k * PIO2_2) - k * PIO2_2T;
+    double z = r * r;
+
+    double s = r + r * z * (-1.66666666666666324348e-01 + z * (8.33333333332248946124e-03 +
+        z * (-1.98412698298579493134e-04 + z * (2.75573137070700676789e-06 +
+        z * (-2.50507602534068634195e-08 + z * 1.58969099521155010221e-10)))));
+
+    double hz = 0.5 * z;
+    double w = 1.0 - hz;
+    double c = w + (((1.0 - w) - hz) + z * z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03 +
+        z * (2.48015872894767294178e-05 + z * (-2.75573143513906633035e-07 +
+        z * (2.08757232129817482790e-09 + z * -1.13596475577881948265e-11))))));
+    return fromQuadrant(s, c, long(k));
+}
+
+static double expUlp(double x){
+    if(!(std::abs(x) < 708.0)) return std::exp(x);
+    double k = roundToInteger(x * INV_LN2);
+    double hi = x - k * LN2_HI;
+    double lo = k * LN2_LO;
+    double r = hi - lo;
+    double t = r * r;
+    double c = r - t * (1.66666666666666019037e-01 + t * (-2.77777777770155933842e-03 +
+        t * (6.61375632143793436117e-05 + t * (-1.65339022054652515390e-06 + t * 4.13813679705723846039e-08))));
+    double y = 1.0 - ((lo - (r * c) / (2.0 - c)) - hi);
+    return y * powerOfTwo(int(k));
+}
+
+/*
+    Fast tier: two part range reduction and short Taylor polynomials
+*/
+
+static SinCos sinCosFast(double x){
+    double k = roundToInteger(x * INV_PIO2);
+    double r = (x - k * PIO2_1) - k * PIO2_1T;
+    double z = r * r;
+    double s = r * (1.0 + z * (-1.0 / 6 + z * (1.0 / 120 + z * (-1.0 / 5040 + z * (1.0 / 362880)))));
+    double c = 1.0 + z * (-0.5 + z * (1.0 / 24 + z * (-1.0 / 720 + z * (1.0 / 40320))));
+    return fromQuadrant(s, c, long(k));
+}
+
+static double expFast(double x){
+    if(!(std::abs(x) < 708.0)) return std::exp(x);
+    double k = roundToInteger(x * INV_LN2);
+    double r = x - k * LN2;
+    double p = 1.0 + r * (1.0 + r * (0.5 + r * (1.0 / 6 + r * (1.0 / 24 + r * (1.0 / 120 + r * (1.0 / 720 + r * (1.0 / 5040)))))));
+    return p * powerOfTwo(int(k));
+}
+
+/*
+    Coarse tier: lookup tables with linear interpolation
+*/
+
+static const int SIN_TABLE_SIZE = 256;
+static const int EXP_TABLE_SIZE = 64;
+static const int LOG_TABLE_SIZE = 128;
+
+struct Tables {
+    double sine[SIN_TABLE_SIZE + 1];            // sin(2 pi j / SIN_TABLE_SIZE)
+    double exp2[EXP_TABLE_SIZE];                // 2^(j / EXP_TABLE_SIZE)
+    double log[LOG_TABLE_SIZE + 1];             // ln(1 + j / LOG_TABLE_SIZE)
+    double inverse[LOG_TABLE_SIZE + 1];         // 1 / (1 + j / LOG_TABLE_SIZE)
+
+    Tables(){
+        for(int j = 0; j <= SIN_TABLE_SIZE; j++) sine[j] = std::sin(2.0 * M_PI * j / SIN_TABLE_SIZE);
+        for(int j = 0; j < EXP_TABLE_SIZE; j++) exp2[j] = std::exp2(double(j) / EXP_TABLE_SIZE);
+        for(int j = 0; j <= LOG_TABLE_SIZE; j++){
+            log[j] = std::log1p(double(j) / LOG_TABLE_SIZE);
+            inverse[j] = 1.0 / (1.0 + double(j) / LOG_TABLE_SIZE);
+        }
+    }
+};
+
+// Built at load time, so lookups do not test a function-local static guard
+static const Tables TABLES;
+
+// Phase in table steps, shift = SIN_TABLE_SIZE / 4 gives cos
+static double sineTable(double x, int shift){
+    if(!(std::abs(x) < REDUCTION_LIMIT)) return shift ? std::cos(x) : std::sin(x);
+    double t = x * (SIN_TABLE_SIZE / (2.0 * M_PI));
+    double whole = roundToInteger(t);
+    if(whole > t) whole -= 1.0;
+    double fraction = t - whole;
+    int j = int((long long)(whole) + shift) & (SIN_TABLE_SIZE - 1);
+    const double* sine = TABLES.sine;
+    return sine[j] + fraction * (sine[j + 1] - sine[j]);
+}
+
+// x = (64 k + j) ln2 / 64 + r with |r| <= ln2 / 128, then e^x = 2^k 2^(j/64) (1 + r)
+static double expCoarse(double x){
+    if(!(std::abs(x) < 708.0)) return std::exp(x);
+    double n = roundToInteger(x * (EXP_TABLE_SIZE * INV_LN2));
+    double r = x - n * (LN2 / EXP_TABLE_SIZE);
+    int64_t whole = int64_t(n);
+    int j = int(whole & (EXP_TABLE_SIZE - 1));
+    int k = int(whole >> 6);        // Floor of whole / EXP_TABLE_SIZE
+    return powerOfTwo(k) * TABLES.exp2[j] * (1.0 + r);
+}
+
+static double logCoarse(double x){
+    if(!(x >= DBL_MIN) || std::isinf(x)) return std::log(x);
+    int k;
+    double m = splitExponent(x, k);
+    int j = int((m - 1.0) * LOG_TABLE_SIZE);
+    double d = m - (1.0 + double(j) / LOG_TABLE_SIZE);
+    return k * LN2 + TABLES.log[j] + d * TABLES.inverse[j];
+}
+
+/*
+    Dispatch on the tier of the calling thread
+    The Full path comes first and skips the thread_local tier while no thread uses another tier.
+    A tier only gets its own code where it is faster than the C library: log is the C library in the
+    Ulp and Fast tiers (faster than their polynomials), and tan in the Coarse tier is the Fast tier
+    ratio (two table lookups and a division were slower than it).
+*/
+
+static SinCos sinCosOf(double a){
+    if(!(std::abs(a) < REDUCTION_LIMIT) || accuracy == Accuracy::Full){
+        return {std::sin(a), std::cos(a)};
+    }
+    switch(accuracy){
+        case Accuracy::Ulp: return sinCosUlp(a);
+        case Accuracy::Fast: return sinCosFast(a);
+        default: return {sineTable(a, 0), sineTable(a, SIN_TABLE_SIZE / 4)};
+    }
+}
+
+double mathSin(double a){
+    if(fullTier()) return std::sin(a);
+    if(accuracy == Accuracy::Coarse) return sineTable(a, 0);
+    return sinCosOf(a).sin;
+}
+
+double mathCos(double a){
+    if(fullTier()) return std::cos(a);
+    if(accuracy == Accuracy::Coarse) return sineTable(a, SIN_TABLE_SIZE / 4);
+    return sinCosOf(a).cos;
+}
+
+double mathTan(double a){
+    if(fullTier()) return std::tan(a);
+    SinCos values = accuracy == Accuracy::Coarse && std::abs(a) < REDUCTION_LIMIT ? sinCosFast(a) : sinCosOf(a);
+    return values.sin / values.cos;
+}
+
+double mathExp(double a){
+    if(fullTier()) return std::exp(a);
+    switch(accuracy){
+        case Accuracy::Ulp: return expUlp(a);
+        case Accuracy::Fast: return expFast(a);
+        default: return expCoarse(a);
+    }
+}
+
+double mathLog(double a){
+    if(fullTier() || accuracy != Accuracy::Coarse) return std::log(a);
+    return logCoarse(a);
+}
+
+// Integer powers by repeated squaring, used by the approximate tiers
+static double integerPower(double base, long n){
+    double result = 1.0;
+    for(long m = n < 0 ? -n : n; m > 0; m >>= 1){
+        if(m & 1) result *= base;
+        base *= base;
+    }
+    return n < 0 ? 1.0 / result : result;
+}
+
+double mathPow(double base, double exponent){
+    if(fullTier() || accuracy == Accuracy::Ulp) return std::pow(base, exponent);
+    if(exponent == std::trunc(exponent) && std::abs(exponent) <= 16) return integerPower(base, long(exponent));
+    if(base > 0.0 && std::isfinite(base) && std::isfinite(exponent)) return mathExp(exponent * mathLog(base));
+    return std::pow(base, exponent);
+}
+
+double mathSinh(double a){
+    if(fullTier() || accuracy == Accuracy::Ulp) return std::sinh(a);
+    if(std::abs(a) < 0.5){
+        double z = a * a;
+        return a * (1.0 + z * (1.0 / 6 + z * (1.0 / 120 + z * (1.0 / 5040))));
+    }
+    double e = mathExp(a);
+    return 0.5 * (e - 1.0 / e);
+}
+
+double mathCosh(double a){
+    if(fullTier() || accuracy == Accuracy::Ulp) return std::cosh(a);
+    double e = mathExp(a);
+    return 0.5 * (e + 1.0 / e);
+}
+
+double mathTanh(double a){
+    if(fullTier() || accuracy == Accuracy::Ulp) return std::tanh(a);
+    if(std::abs(a) > 20.0) return a > 0 ? 1.0 : -1.0;
+    if(std::abs(a) < 0.5) return mathSinh(a) / mathCosh(a);
+    double e = mathExp(2.0 * a);
+    return (e - 1.0) / (e + 1.0);
+}
+
+void mathSinCos(double a, double& sine, double& cosine){
+    if(fullTier()){
+        sincos(a, &sine, &cosine);
+        return;
+    }
+    switch(accuracy){
+        case Accuracy::Full:
+            sincos(a, &sine, &cosine);
+            return;
+        case Accuracy::Coarse:
+            sine = sineTable(a, 0);
+            cosine = sineTable(a, SIN_TABLE_SIZE / 4);
+            return;
+        default: {
+            SinCos values = sinCosOf(a);
+            sine = values.sin;
+            cosine = values.cos;
+        }
+    }
+}
+
+void mathSinhCosh(double a, double& sineH, double& cosineH){
+    if(!fullTier() && accuracy != Accuracy::Ulp){
+        double e = mathExp(a);
+        sineH = std::abs(a) < 0.5 ? mathSinh(a) : 0.5 * (e - 1.0 / e);
+        cosineH = 0.5 * (e + 1.0 / e);
+        return;
+    }
+    double t = std::abs(a);
+    if(!(t < 709.0)){
+        sineH = std::sinh(a);
+        cosineH = std::cosh(a);
+        return;
+    }
+    // With E = e^|a| - 1: sinh|a| = (E + E / (E + 1)) / 2 and cosh a = (E + 1 + 1 / (E + 1)) / 2, which
+    // stay accurate near 0 where e^a - e^-a cancels
+    double e = std::expm1(t);
+    sineH = std::copysign(0.5 * (e + e / (e + 1.0)), a);
+    cosineH = 0.5 * ((e + 1.0) + 1.0 / (e + 1.0));
+}
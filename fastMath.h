@@ -0,0 +1,52 @@
+#pragma once
+
+/*
+    Accuracy tiers for evaluate()
+    The scalar kernels in evaluate.cpp call the functions below instead of the C math library, so the
+    selected tier applies to every evaluator built on the kernels (evaluate, evaluateGrid, the
+    ParametricEvaluator and the JIT). Like strict mode (see evaluationStatus.h) the tier is set per
+    thread. Inverse trig functions always use the C math library. Code generated by codegen.h is
+    not affected.
+
+    Error bounds, measured by fastMathBenchmark.cpp against long double references:
+        Full    C math library                          sin/cos/tan/exp/log < 1 ulp
+        Ulp     fdlibm style polynomials                exp < 1 ulp, sin/cos < 1.5 ulp, tan < 3 ulp
+        Fast    short polynomials, range reduction      relative error < 1e-7
+        Coarse  interpolated lookup tables              sin/cos absolute error < 8e-5, exp relative
+                                                        error < 2e-5, log absolute error < 4e-5
+    A tier only replaces a function where it is faster than the C library: log is the C library in
+    the Ulp and Fast tiers and tan in the Coarse tier is the one of the Fast tier. Full-tier calls
+    read the thread's tier only while some thread has selected another one.
+    Arguments outside the reduced range (|x| >= 1e6 for sin/cos/tan, |x| >= 708 for exp, 0, negative,
+    subnormal or infinite arguments of log) and NaN always use the C math library.
+    sinh/cosh/tanh and non-integer powers are built from exp and log in the Fast and Coarse tiers
+    (relative error of b^a grows with |a ln b|), integer powers up to 16 use repeated multiplication.
+*/
+
+enum class Accuracy : unsigned char {
+    Full,       // C math library (default)
+    Ulp,        // About 1 ulp
+    Fast,       // About 1e-7 relative
+    Coarse      // About 1e-4
+};
+
+// Selects the accuracy of transcendental functions for the calling thread. Full by default
+void setEvaluationAccuracy(Accuracy tier);
+Accuracy evaluationAccuracy();
+const char* accuracyName(Accuracy tier);
+
+// Transcendental functions at the accuracy of the calling thread
+double mathSin(double a);
+double mathCos(double a);
+double mathTan(double a);
+double mathExp(double a);
+double mathLog(double a);
+double mathPow(double base, double exponent);
+double mathSinh(double a);
+double mathCosh(double a);
+double mathTanh(double a);
+
+// Pairs from one evaluation (see fusion.h): sincos with the same results as mathSin and mathCos,
+// sinh and cosh from one exponential (within 2 ulp of mathSinh and mathCosh in the Full tier)
+void mathSinCos(double a, double& sine, double& cosine);
+void mathSinhCosh(double a, double& sineH, double& cosineH);
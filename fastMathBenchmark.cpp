@@ -0,0 +1,120 @@
+#include "Functions.h"
+#include "fastMath.h"
+#include "expressionSplit.h"
+#include "evaluationStatus.h"
+
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+
+/*
+    Benchmark of the accuracy tiers in fastMath.h
+    For sin, cos, tan, exp and log it reports the throughput and the largest error of every tier
+    against a long double reference, then the throughput of evaluateGrid on a trig heavy derivative.
+*/
+
+static const Accuracy tiers[] = {Accuracy::Full, Accuracy::Ulp, Accuracy::Fast, Accuracy::Coarse};
+
+struct Case {
+    const char* name;
+    double (*approximate)(double);
+    long double (*reference)(long double);
+    double low;
+    double high;
+};
+
+static long double referenceSin(long double x){ return sinl(x); }
+static long double referenceCos(long double x){ return cosl(x); }
+static long double referenceTan(long double x){ return tanl(x); }
+static long double referenceExp(long double x){ return expl(x); }
+static long double referenceLog(long double x){ return logl(x); }
+
+static const Case cases[] = {
+    {"sin", mathSin, referenceSin, -100.0, 100.0},
+    {"cos", mathCos, referenceCos, -100.0, 100.0},
+    {"tan", mathTan, referenceTan, -1.5, 1.5},
+    {"exp", mathExp, referenceExp, -700.0, 700.0},
+    {"log", mathLog, referenceLog, 1e-300, 1e300}
+};
+
+// Distance in units of the last place between an approximation and the reference
+static double ulpError(double value, long double reference){
+    double rounded = double(reference);
+    if(value == rounded) return 0.0;
+    double ulp = std::nextafter(std::abs(rounded), INFINITY) - std::abs(rounded);
+    return double(std::abs((long double)value - reference) / ulp);
+}
+
+static std::vector<double> samples(const Case& c, size_t count){
+    std::mt19937_64 generator(12345);
+    std::vector<double> xs(count);
+    if(std::strcmp(c.name, "log") == 0){
+        // Spread over many binades
+        std::uniform_real_distribution<double> exponent(std::log(c.low), std::log(c.high));
+        for(double& x : xs) x = std::exp(exponent(generator));
+    }
+    else{
+        std::uniform_real_distribution<double> uniform(c.low, c.high);
+        for(double& x : xs) x = uniform(generator);
+    }
+    return xs;
+}
+
+static void benchmarkCase(const Case& c, size_t count){
+    std::vector<double> xs = samples(c, count);
+    std::vector<double> ys(count);
+    for(Accuracy tier : tiers){
+        setEvaluationAccuracy(tier);
+        auto start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < count; i++) ys[i] = c.approximate(xs[i]);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double maxUlp = 0.0, maxRelative = 0.0, maxAbsolute = 0.0;
+        for(size_t i = 0; i < count; i++){
+            long double reference = c.reference(xs[i]);
+            double absolute = double(std::abs((long double)ys[i] - reference));
+            maxUlp = std::max(maxUlp, ulpError(ys[i], reference));
+            maxAbsolute = std::max(maxAbsolute, absolute);
+            if(reference != 0) maxRelative = std::max(maxRelative, double(absolute / std::abs(reference)));
+        }
+        std::printf("%-4s %-7s %9.1f Mcalls/s   max ulp %-10.3g max relative %-10.3g max absolute %.3g\n",
+            c.name, accuracyName(tier), count / seconds / 1e6, maxUlp, maxRelative, maxAbsolute);
+    }
+    setEvaluationAccuracy(Accuracy::Full);
+}
+
+static void benchmarkGrid(const std::string& expr, size_t count){
+    std::shared_ptr<Function> df = buildFunction(expr)->derivative()->simplify();
+    std::vector<double> xs(count);
+    for(size_t i = 0; i < count; i++) xs[i] = 0.1 + 10.0 * i / count;
+
+    std::vector<double> exact, results;
+    evaluateGrid(*df, xs, exact);
+    std::cout << "d/dx " << expr << '\n';
+    for(Accuracy tier : tiers){
+        setEvaluationAccuracy(tier);
+        auto start = std::chrono::steady_clock::now();
+        evaluateGrid(*df, xs, results);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double maxError = 0.0;
+        for(size_t i = 0; i < count; i++){
+            maxError = std::max(maxError, std::abs(results[i] - exact[i]) / std::max(1.0, std::abs(exact[i])));
+        }
+        std::printf("  %-7s %9.2f Mpoints/s   max error %.3g\n", accuracyName(tier), count / seconds / 1e6, maxError);
+    }
+    setEvaluationAccuracy(Accuracy::Full);
+}
+
+int main(int argc, char* argv[]){
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    for(const Case& c : cases) benchmarkCase(c, count);
+    benchmarkGrid("sin(x)*cos(2*x) + e^(sin(x)) - ln(x^2 + 1)*tan(x/3)", count);
+    benchmarkGrid("sinh(x/4)*cos(x) + x^2.5", count);
+    return 0;
+}
@@ -0,0 +1,325 @@
+#include "flatExpression.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+/*
+    Builder
+    Appends nodes in post-order and stores every distinct node and constant once
+*/
+
+namespace {
+
+struct NodeKey {
+    NodeKind kind;
+    uint32_t a, b, payload;
+
+    bool operator==(const NodeKey& other) const{
+        return kind == other.kind && a == other.a && b == other.b && payload == other.payload;
+    }
+};
+
+struct NodeKeyHash {
+    size_t operator()(const NodeKey& key) const{
+        uint64_t hash = static_cast<uint64_t>(key.kind);
+        hash = hash * 0x9E3779B97F4A7C15ull ^ key.a;
+        hash = hash * 0x9E3779B97F4A7C15ull ^ key.b;
+        hash = hash * 0x9E3779B97F4A7C15ull ^ key.payload;
+        return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+};
+
+uint64_t bitsOf(double value){
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+}
+
+class FlatBuilder {
+    FlatExpression& out;
+    std::unordered_map<NodeKey, uint32_t, NodeKeyHash> interned;
+    std::unordered_map<uint64_t, uint32_t> constantIndex;
+    std::unordered_map<const Function*, uint32_t> leafIndex;
+
+    uint32_t poolConstant(double value){
+        auto found = constantIndex.emplace(bitsOf(value), out.constants.size());
+        if(found.second) out.constants.push_back(value);
+        return found.first->second;
+    }
+
+    public:
+    explicit FlatBuilder(FlatExpression& expression) : out(expression) {}
+
+    uint32_t node(NodeKind kind, uint32_t a, uint32_t b, uint32_t payload){
+        auto found = interned.emplace(NodeKey{kind, a, b, payload}, out.kinds.size());
+        if(found.second){
+            out.kinds.push_back(kind);
+            out.first.push_back(a);
+            out.second.push_back(b);
+            out.payloads.push_back(payload);
+        }
+        return found.first->second;
+    }
+
+    uint32_t constant(double value){ return node(NodeKind::Constant, 0, 0, poolConstant(value)); }
+    uint32_t unary(NodeKind kind, uint32_t a){ return node(kind, a, 0, 0); }
+    uint32_t binary(NodeKind kind, uint32_t a, uint32_t b){ return node(kind, a, b, 0); }
+    uint32_t power(uint32_t a, double exponent){ return node(NodeKind::Polynomial, a, 0, poolConstant(exponent)); }
+
+    uint32_t leaf(NodeKind kind, const std::shared_ptr<Function>& f){
+        auto found = leafIndex.emplace(f.get(), out.leaves.size());
+        if(found.second) out.leaves.push_back(f);
+        return node(kind, 0, 0, found.first->second);
+    }
+
+    // Children first, so every child index is smaller than its parent's. Uses an explicit stack so
+    // deep trees fit
+    uint32_t add(const std::shared_ptr<Function>& root){
+        struct Frame {
+            const std::shared_ptr<Function>* node;
+            NodeKind kind;
+            int next;
+        };
+        std::unordered_map<const Function*, uint32_t> visited;
+        std::vector<Frame> frames{{&root, kindOf(*root), 0}};
+        while(!frames.empty()){
+            Frame& frame = frames.back();
+            const std::shared_ptr<Function>& f = *frame.node;
+            int children = childCount(frame.kind);
+            if(frame.next < children){
+                const std::shared_ptr<Function>& child = childOf(*f, frame.next++);
+                if(!visited.count(child.get())) frames.push_back({&child, kindOf(*child), 0});
+                continue;
+            }
+            uint32_t index;
+            if(frame.kind == NodeKind::Variable || frame.kind == NodeKind::Parameter){
+                index = leaf(frame.kind, f);
+            }
+            else{
+                uint32_t a = children > 0 ? visited.at(childOf(*f, 0).get()) : 0;
+                uint32_t b = children > 1 ? visited.at(childOf(*f, 1).get()) : 0;
+                bool pooled = frame.kind == NodeKind::Constant || frame.kind == NodeKind::Polynomial;
+                index = node(frame.kind, a, b, pooled ? poolConstant(payloadOf(*f)) : 0);
+            }
+            visited.emplace(f.get(), index);
+            frames.pop_back();
+        }
+        return visited.at(root.get());
+    }
+
+    // Copies node index of source, whose children are already copied to remap
+    uint32_t copy(const FlatExpression& source, uint32_t index, const std::vector<uint32_t>& remap){
+        NodeKind kind = source.kinds[index];
+        if(kind == NodeKind::Variable || kind == NodeKind::Parameter) return leaf(kind, source.leaves[source.payloads[index]]);
+        if(kind == NodeKind::Constant) return constant(source.constants[source.payloads[index]]);
+        int children = childCount(kind);
+        uint32_t a = children > 0 ? remap[source.first[index]] : 0;
+        uint32_t b = children > 1 ? remap[source.second[index]] : 0;
+        return node(kind, a, b, kind == NodeKind::Polynomial ? poolConstant(source.constants[source.payloads[index]]) : 0);
+    }
+};
+
+FlatExpression::FlatExpression(const std::shared_ptr<Function>& f){
+    FlatBuilder(*this).add(f);
+}
+
+/*
+    Scans
+*/
+
+double FlatExpression::payload(uint32_t index) const{
+    switch(kinds[index]){
+        case NodeKind::Constant:
+        case NodeKind::Polynomial:
+            return constants[payloads[index]];
+        case NodeKind::Parameter:
+            return payloadOf(*leaves[payloads[index]]);
+        default:
+            return 0.0;
+    }
+}
+
+const std::string& FlatExpression::name(uint32_t index) const{
+    if(kinds[index] != NodeKind::Variable && kinds[index] != NodeKind::Parameter){
+        throw std::runtime_error("Error only variables and parameters have a name");
+    }
+    return nameOf(*leaves[payloads[index]]);
+}
+
+size_t FlatExpression::bytes() const{
+    return kinds.capacity() * sizeof(NodeKind) + (first.capacity() + second.capacity() + payloads.capacity()) * sizeof(uint32_t) +
+        constants.capacity() * sizeof(double) + leaves.capacity() * sizeof(std::shared_ptr<Function>);
+}
+
+std::shared_ptr<Function> FlatExpression::toFunction() const{
+    std::vector<std::shared_ptr<Function>> built(kinds.size());
+    for(size_t i = 0; i < kinds.size(); i++){
+        NodeKind kind = kinds[i];
+        if(kind == NodeKind::Variable || kind == NodeKind::Parameter){
+            built[i] = leaves[payloads[i]];
+            continue;
+        }
+        int children = childCount(kind);
+        built[i] = makeNode(kind, children > 0 ? built[first[i]] : nullptr, children > 1 ? built[second[i]] : nullptr, payload(i));
+    }
+    return built.back();
+}
+
+double FlatExpression::evaluate(double x) const{
+    thread_local std::vector<double> values;
+    values.resize(kinds.size());
+    for(size_t i = 0; i < kinds.size(); i++){
+        NodeKind kind = kinds[i];
+        double a = kind == NodeKind::Variable ? x : values[first[i]];
+        double b = values[second[i]];
+        values[i] = evaluateKind(kind, a, b, payload(i));
+    }
+    return values.back();
+}
+
+void FlatExpression::evaluate(const std::vector<double>& xs, std::vector<double>& out) const{
+    out.resize(xs.size());
+    for(size_t i = 0; i < xs.size(); i++) out[i] = evaluate(xs[i]);
+}
+
+uint64_t FlatExpression::hash() const{
+    std::vector<uint64_t> hashes(kinds.size());
+    std::hash<std::string> hashName;
+    for(size_t i = 0; i < kinds.size(); i++){
+        NodeKind kind = kinds[i];
+        uint64_t a = hashes[first[i]];
+        uint64_t b = hashes[second[i]];
+        if((kind == NodeKind::Sum || kind == NodeKind::Product) && b < a) std::swap(a, b);
+        uint64_t value = 0;
+        if(kind == NodeKind::Constant || kind == NodeKind::Polynomial) value = bitsOf(constants[payloads[i]]);
+        else if(kind == NodeKind::Variable || kind == NodeKind::Parameter) value = hashName(name(i));
+
+        uint64_t hash = static_cast<uint64_t>(kind) + 1;
+        int children = childCount(kind);
+        if(children > 0) hash = hash * 0x9E3779B97F4A7C15ull ^ a;
+        if(children > 1) hash = hash * 0x9E3779B97F4A7C15ull ^ b;
+        hash = hash * 0x9E3779B97F4A7C15ull ^ value;
+        hashes[i] = hash ^ (hash >> 29);
+    }
+    return hashes.back();
+}
+
+/*
+    Derivative
+    Every node of f is copied, then one scan builds the derivative of every node from the
+    derivatives of its children, with the rules of derivatives.cpp. A final scan drops the nodes
+    that the derivative of the root does not use.
+*/
+
+FlatExpression FlatExpression::derivative() const{
+    FlatExpression result;
+    FlatBuilder build(result);
+    std::vector<uint32_t> node(kinds.size());
+    for(uint32_t i = 0; i < kinds.size(); i++) node[i] = build.copy(*this, i, node);
+
+    auto constant = [&](double value){ return build.constant(value); };
+    auto unary = [&](NodeKind kind, uint32_t a){ return build.unary(kind, a); };
+    auto power = [&](uint32_t a, double exponent){ return build.power(a, exponent); };
+    auto sum = [&](uint32_t a, uint32_t b){ return build.binary(NodeKind::Sum, a, b); };
+    auto difference = [&](uint32_t a, uint32_t b){ return build.binary(NodeKind::Difference, a, b); };
+    auto product = [&](uint32_t a, uint32_t b){ return build.binary(NodeKind::Product, a, b); };
+    auto quotient = [&](uint32_t a, uint32_t b){ return build.binary(NodeKind::Quotient, a, b); };
+    auto logarithm = [&](uint32_t base, uint32_t argument){ return build.binary(NodeKind::Logarithmic, base, argument); };
+    // (log_g(f))' = (g * f' - g' * f * log_g(f)) / (g * f * ln(g))
+    auto logarithmDerivative = [&](uint32_t g, uint32_t dg, uint32_t f, uint32_t df){
+        uint32_t e = constant(std::exp(1.0));
+        return quotient(difference(product(g, df), product(product(dg, f), logarithm(g, f))),
+            product(product(g, f), logarithm(e, g)));
+    };
+    auto arcsinDerivative = [&](uint32_t a, uint32_t da){
+        return product(power(difference(constant(1.0), power(a, 2.0)), -0.5), da);
+    };
+    auto arctanDerivative = [&](uint32_t a, uint32_t da){
+        return quotient(da, sum(constant(1.0), power(a, 2.0)));
+    };
+    auto arcsecDerivative = [&](uint32_t a, uint32_t da){
+        return quotient(da, product(unary(NodeKind::AbsVal, a), power(difference(power(a, 2.0), constant(1.0)), 0.5)));
+    };
+
+    std::vector<uint32_t> derivative(kinds.size());
+    for(uint32_t i = 0; i < kinds.size(); i++){
+        NodeKind kind = kinds[i];
+        uint32_t a = node[first[i]], b = node[second[i]];
+        uint32_t da = derivative[first[i]], db = derivative[second[i]];
+        uint32_t d;
+        switch(kind){
+            case NodeKind::Constant:
+            case NodeKind::Parameter: d = constant(0.0); break;
+            case NodeKind::Variable: d = constant(1.0); break;
+            case NodeKind::Sum: d = sum(da, db); break;
+            case NodeKind::Difference: d = difference(da, db); break;
+            case NodeKind::Product: d = sum(product(da, b), product(a, db)); break;
+            case NodeKind::Quotient: d = quotient(difference(product(da, b), product(a, db)), power(b, 2.0)); break;
+            case NodeKind::AbsVal: d = quotient(product(a, da), unary(NodeKind::AbsVal, a)); break;
+            case NodeKind::Polynomial: {
+                double exponent = constants[payloads[i]];
+                d = exponent == 0 ? constant(0.0) : product(product(constant(exponent), power(a, exponent - 1)), da);
+                break;
+            }
+            case NodeKind::Logarithmic: d = logarithmDerivative(a, da, b, db); break;
+            case NodeKind::Exponential: {
+                // g^f * (f * ln(g))'
+                uint32_t e = constant(std::exp(1.0));
+                uint32_t lnBase = logarithm(e, a);
+                uint32_t lnBaseDerivative = logarithmDerivative(e, constant(0.0), a, da);
+                d = product(build.binary(NodeKind::Exponential, a, b), sum(product(db, lnBase), product(b, lnBaseDerivative)));
+                break;
+            }
+            case NodeKind::Sine: d = product(unary(NodeKind::Cosine, a), da); break;
+            case NodeKind::Cosine: d = product(constant(-1.0), product(unary(NodeKind::Sine, a), da)); break;
+            case NodeKind::Tangent: d = product(power(unary(NodeKind::Secant, a), 2.0), da); break;
+            case NodeKind::Secant: d = product(product(unary(NodeKind::Secant, a), unary(NodeKind::Tangent, a)), da); break;
+            case NodeKind::Cosecant:
+                d = product(constant(-1.0), product(product(unary(NodeKind::Cosecant, a), unary(NodeKind::Cotangent, a)), da));
+                break;
+            case NodeKind::Cotangent: d = product(constant(-1.0), product(power(unary(NodeKind::Cosecant, a), 2.0), da)); break;
+            case NodeKind::Arcsin: d = arcsinDerivative(a, da); break;
+            case NodeKind::Arccos: d = product(constant(-1.0), arcsinDerivative(a, da)); break;
+            case NodeKind::Arctan: d = arctanDerivative(a, da); break;
+            case NodeKind::Arccot: d = product(constant(-1.0), arctanDerivative(a, da)); break;
+            case NodeKind::Arcsec: d = arcsecDerivative(a, da); break;
+            case NodeKind::Arccsc: d = product(constant(-1.0), arcsecDerivative(a, da)); break;
+            case NodeKind::SineH: d = product(unary(NodeKind::CosineH, a), da); break;
+            case NodeKind::CosineH: d = product(unary(NodeKind::SineH, a), da); break;
+            case NodeKind::TangentH: d = product(power(unary(NodeKind::SecantH, a), 2.0), da); break;
+            case NodeKind::SecantH:
+                d = product(constant(-1.0), product(da, product(unary(NodeKind::SecantH, a), unary(NodeKind::TangentH, a))));
+                break;
+            case NodeKind::CosecantH:
+                d = product(constant(-1.0), product(da, product(unary(NodeKind::CosecantH, a), unary(NodeKind::CotangentH, a))));
+                break;
+            case NodeKind::CotangentH: d = product(constant(-1.0), product(power(unary(NodeKind::CosecantH, a), 2.0), da)); break;
+            default:
+                throw std::runtime_error("Error cannot differentiate node of this kind");
+        }
+        derivative[i] = d;
+    }
+
+    // Keep the nodes reachable from the new root, which is the largest of them and ends up last
+    uint32_t root = derivative.back();
+    std::vector<char> used(root + 1, 0);
+    used[root] = 1;
+    for(uint32_t i = root + 1; i-- > 0;){
+        if(!used[i]) continue;
+        int children = childCount(result.kinds[i]);
+        if(children > 0) used[result.first[i]] = 1;
+        if(children > 1) used[result.second[i]] = 1;
+    }
+    FlatExpression compact;
+    FlatBuilder keep(compact);
+    std::vector<uint32_t> remap(root + 1, 0);
+    for(uint32_t i = 0; i <= root; i++){
+        if(used[i]) remap[i] = keep.copy(result, i, remap);
+    }
+    return compact;
+}
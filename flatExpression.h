@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "nodeKind.h"
+
+/*
+    Flat expressions
+    A whole tree stored as parallel arrays instead of one heap object per node:
+        kinds[i]                    NodeKind, one byte
+        first[i], second[i]         indices of children 0 and 1 (see nodeKind.h), 0 if absent
+        payloads[i]                 index into constants (Constant value, Polynomial exponent) or
+                                    into leaves (Variable, Parameter)
+    Nodes are in post-order: every child has a smaller index than its parent and the root is the
+    last node, so evaluate, derivative and hash are single forward scans without recursion or
+    virtual calls. Equal subtrees are stored once.
+    A node takes 13 bytes plus its share of the pools, against a Function object, its control block
+    and two 16 byte shared_ptr children for every node of a tree.
+    Variables and Parameters are kept as the Function leaves they were built from, so Parameters
+    keep following their binding table.
+*/
+class FlatExpression {
+    std::vector<NodeKind> kinds;
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> second;
+    std::vector<uint32_t> payloads;
+    std::vector<double> constants;
+    std::vector<std::shared_ptr<Function>> leaves;
+
+    friend class FlatBuilder;
+    FlatExpression() = default;
+
+    public:
+    /**
+     * Flattens a Function tree
+     *
+     * Precondition: f is not null
+     * Postcondition: evaluate(x) = f->evaluate(x), toFunction() prints as f
+     */
+    explicit FlatExpression(const std::shared_ptr<Function>& f);
+
+    // Rebuilds the Function tree, keeping shared subtrees shared
+    std::shared_ptr<Function> toFunction() const;
+
+    double evaluate(double x) const;
+
+    // out[i] = evaluate(xs[i])
+    void evaluate(const std::vector<double>& xs, std::vector<double>& out) const;
+
+    /**
+     * Derivative with respect to x, built by the same rules as Function::derivative()
+     *
+     * Precondition: None
+     * Postcondition: toFunction() of the result prints as the materialized f.derivative()
+     */
+    FlatExpression derivative() const;
+
+    /**
+     * Structural hash of the whole expression, in one scan
+     *
+     * Precondition: None
+     * Postcondition: expressions that print the same have the same hash, f + g and g + f as well
+     */
+    uint64_t hash() const;
+
+    // Number of distinct nodes
+    size_t size() const { return kinds.size(); }
+
+    // Bytes held by the arrays and pools (not counting the leaf objects)
+    size_t bytes() const;
+
+    // Accessors for passes over the arrays, index < size()
+    NodeKind kind(uint32_t index) const { return kinds[index]; }
+    uint32_t child(uint32_t index, int i) const { return i == 0 ? first[index] : second[index]; }
+    double payload(uint32_t index) const;
+    const std::string& name(uint32_t index) const;
+    uint32_t root() const { return kinds.size() - 1; }
+};
@@ -3,24 +3,27 @@
 
 #include "Functions.h"
 
+// Checks take borrowed references so testing a subtree never touches its reference count
 
-static bool checkForOne(std::shared_ptr<Function> expr);
+bool checkForOne(const Function& expr);
 
-static bool checkForZero(std::shared_ptr<Function> expr);
+bool checkForZero(const Function& expr);
 
-static bool checkNegativeFunction(const std::shared_ptr<Function>&expr);
+bool checkForNegativeOne(const Function& expr);
 
-static bool negativeArg(std::shared_ptr<Function> argument);
+bool checkNegativeFunction(const Function& expr);
 
-static bool tangentChange(std::shared_ptr<Quotient> trigQuot);
+bool negativeArg(const Function& argument);
 
-static bool cotangentChange(std::shared_ptr<Quotient> trigQuot);
+bool tangentChange(const Function& top, const Function& bottom);
 
-std::shared_ptr<Function> trigonometricQuotient(std::shared_ptr<Function> trigExpr);
+bool cotangentChange(const Function& top, const Function& bottom);
 
-std::shared_ptr<Function> SineCosine(std::shared_ptr<Function> trigSum);
+std::shared_ptr<Function> trigonometricQuotient(const std::shared_ptr<Function>& trigExpr);
 
-std::shared_ptr<Function> TanSec(std::shared_ptr<Function> trigSum);
+std::shared_ptr<Function> SineCosine(const std::shared_ptr<Function>& trigSum);
+
+std::shared_ptr<Function> TanSec(const std::shared_ptr<Function>& trigSum);
 
 
 
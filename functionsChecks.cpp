@@ -1,58 +1,59 @@
 #include "functionChecks.h"
 
-static bool checkForOne(std::shared_ptr<Function> expr){
-    if(auto constant = dynamic_cast<Constant*>(expr.get())){
+bool checkForOne(const Function& expr){
+    if(auto constant = dynamic_cast<const Constant*>(&expr)){
         return constant->getValue() == 1.0;
     }
     return false;
 }
 
-static bool checkForZero(std::shared_ptr<Function> expr){
-    if(auto constant = dynamic_cast<Constant*>(expr.get())){
+bool checkForZero(const Function& expr){
+    if(auto constant = dynamic_cast<const Constant*>(&expr)){
         return constant->getValue() == 0.0;
     }
     return false;
 }
 
-static bool checkNegativeFunction(const std::shared_ptr<Function>&expr){
-    
-    if(auto checkProduct = dynamic_cast<Product*>(expr.get())){
-        auto checkConstL = dynamic_cast<Constant*>(checkProduct->getLeft().get());
-        auto checkConstR = dynamic_cast<Constant*>(checkProduct->getRight().get());
+bool checkForNegativeOne(const Function& expr){
+    if(auto constant = dynamic_cast<const Constant*>(&expr)){
+        return constant->getValue() == -1.0;
+    }
+    return false;
+}
 
-        return (checkConstL && checkConstL->isEqual(std::make_shared<Constant>(-1.0))) ||
-                (checkConstR && checkConstR->isEqual(std::make_shared<Constant>(-1.0)));
+bool checkNegativeFunction(const Function& expr){
+    
+    if(auto checkProduct = dynamic_cast<const Product*>(&expr)){
+        return checkForNegativeOne(checkProduct->getLeftRef()) || checkForNegativeOne(checkProduct->getRightRef());
     }
 
-    if(auto checkQuotient = dynamic_cast<Quotient*>(expr.get())){
-        auto checkTopC = dynamic_cast<Constant*>(checkQuotient->getLeft().get());
-        auto checkBotC = dynamic_cast<Constant*>(checkQuotient->getLeft().get());
-        if(checkBotC && checkBotC->isEqual(std::make_shared<Constant>(-1.0))){
+    if(auto checkQuotient = dynamic_cast<const Quotient*>(&expr)){
+        if(checkForNegativeOne(checkQuotient->getRightRef())){
             return true;
         }
-        if(checkTopC && checkTopC->isEqual(std::make_shared<Constant>(-1.0))){
+        if(checkForNegativeOne(checkQuotient->getLeftRef())){
             return true;
         }
 
-        auto checkTopP = dynamic_cast<Product*>(checkQuotient->getLeft().get());
-        auto checkBotP = dynamic_cast<Product*>(checkQuotient->getRight().get());
+        auto checkTopP = dynamic_cast<const Product*>(&checkQuotient->getLeftRef());
+        auto checkBotP = dynamic_cast<const Product*>(&checkQuotient->getRightRef());
 
-        if(checkTopP) return checkNegativeFunction(checkQuotient->getLeft());
-        if(checkBotP) return checkNegativeFunction(checkQuotient->getRight());
+        if(checkTopP) return checkNegativeFunction(*checkTopP);
+        if(checkBotP) return checkNegativeFunction(*checkBotP);
         
     }
 
     return false;
 }
 
-static bool tangentChange(std::shared_ptr<Quotient> trigQuot){
-    return dynamic_cast<Sine*>(trigQuot->getLeft().get()) && dynamic_cast<Cosine*>(trigQuot->getRight().get());
+bool tangentChange(const Function& top, const Function& bottom){
+    return dynamic_cast<const Sine*>(&top) && dynamic_cast<const Cosine*>(&bottom);
 }
-static bool cotangentChange(std::shared_ptr<Quotient> trigQuot){
-    return dynamic_cast<Cosine*>(trigQuot->getLeft().get()) && dynamic_cast<Sine*>(trigQuot->getRight().get());
+bool cotangentChange(const Function& top, const Function& bottom){
+    return dynamic_cast<const Cosine*>(&top) && dynamic_cast<const Sine*>(&bottom);
 }
 
-std::shared_ptr<Function> trigonometricQuotient(std::shared_ptr<Function> trigExpr){
+std::shared_ptr<Function> trigonometricQuotient(const std::shared_ptr<Function>& trigExpr){
     if(auto sine = dynamic_cast<Sine*>(trigExpr.get())){
         return std::make_shared<Cosecant>(sine->getArgument());
     }
@@ -78,16 +79,16 @@ std::shared_ptr<Function> trigonometricQuotient(std::shared_ptr<Function> trigEx
 
 
 
-std::shared_ptr<Function> TanSec(std::shared_ptr<Function> trigSum) {
+std::shared_ptr<Function> TanSec(const std::shared_ptr<Function>& trigSum) {
     if (auto checkSum = dynamic_cast<Sum*>(trigSum.get())){
-        if(checkForOne(checkSum->getLeft()) || checkForOne(checkSum->getRight())){
+        if(checkForOne(checkSum->getLeftRef()) || checkForOne(checkSum->getRightRef())){
             return std::make_shared<Polynomial>(std::make_shared<Secant>(checkSum->getRight()), 2.0);
         }
     }
     return trigSum;
 }
 
-std::shared_ptr<Function> SineCosine(std::shared_ptr<Function> trigSum) {
+std::shared_ptr<Function> SineCosine(const std::shared_ptr<Function>& trigSum) {
     if(auto checkSum = dynamic_cast<Sum*>(trigSum.get())){
         auto polyCheckL = dynamic_cast<Polynomial*>(checkSum->getLeft().get());
         auto polyCheckR = dynamic_cast<Polynomial*>(checkSum->getRight().get());
@@ -109,16 +110,14 @@ std::shared_ptr<Function> SineCosine(std::shared_ptr<Function> trigSum) {
     return trigSum;
 }
 
-static bool negativeArg(std::shared_ptr<Function> argument){
-    if(auto product = dynamic_cast<Product*>(argument.get())){
-        if(product->getLeft()->isEqual(std::make_shared<Constant>(-1.0)) ||
-            product->getRight()->isEqual(std::make_shared<Constant>(-1.0))){
+bool negativeArg(const Function& argument){
+    if(auto product = dynamic_cast<const Product*>(&argument)){
+        if(checkForNegativeOne(product->getLeftRef()) || checkForNegativeOne(product->getRightRef())){
                 return true;
         }
     }
-    if(auto product = dynamic_cast<Quotient*>(argument.get())){
-        if(product->getLeft()->isEqual(std::make_shared<Constant>(-1.0)) ||
-            product->getRight()->isEqual(std::make_shared<Constant>(-1.0))){
+    if(auto product = dynamic_cast<const Quotient*>(&argument)){
+        if(checkForNegativeOne(product->getLeftRef()) || checkForNegativeOne(product->getRightRef())){
                 return true;
         }
     }
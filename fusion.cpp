@@ -0,0 +1,241 @@
+#include "fusion.h"
+#include "programBlocks.h"
+#include "fastMath.h"
+#include "evaluationStatus.h"
+#include "tracing.h"
+
+#include <cmath>
+#include <bitset>
+
+/*
+    Pass
+*/
+
+static bool isTrigonometric(NodeKind kind){
+    return kind >= NodeKind::Sine && kind <= NodeKind::Cotangent;
+}
+
+static bool isHyperbolic(NodeKind kind){
+    return kind >= NodeKind::SineH && kind <= NodeKind::CotangentH;
+}
+
+FusedProgram fuseTranscendentals(Program program){
+    size_t n = program.instructions.size();
+    // Kinds of trig and hyperbolic functions applied to each instruction, as bit sets
+    std::vector<uint32_t> trigonometric(n, 0), hyperbolic(n, 0);
+    std::vector<uint32_t> logUses(n, 0), powerUses(n, 0);
+    for(const Instruction& instruction : program.instructions){
+        uint32_t bit = 1u << unsigned(instruction.kind);
+        if(isTrigonometric(instruction.kind)) trigonometric[instruction.a] |= bit;
+        if(isHyperbolic(instruction.kind)) hyperbolic[instruction.a] |= bit;
+        if(instruction.kind == NodeKind::Logarithmic){
+            logUses[instruction.a]++;
+            logUses[instruction.b]++;
+        }
+        if(instruction.kind == NodeKind::Exponential) powerUses[instruction.a]++;
+    }
+
+    FusedProgram fused;
+    fused.shared.assign(n, 0);
+    for(size_t i = 0; i < n; i++){
+        size_t trig = std::bitset<32>(trigonometric[i]).count();
+        size_t hyper = std::bitset<32>(hyperbolic[i]).count();
+        if(trig >= 2){
+            fused.shared[i] |= SHARE_SINCOS;
+            fused.savedCalls += trig - 1;
+        }
+        if(hyper >= 2){
+            fused.shared[i] |= SHARE_SINHCOSH;
+            fused.savedCalls += hyper - 1;
+        }
+        // The logarithm of a constant is taken once for all points, any other once per point
+        size_t uses = logUses[i] + powerUses[i];
+        bool constant = program.instructions[i].kind == NodeKind::Constant;
+        if(constant ? uses >= 1 : logUses[i] >= 1 && uses >= 2){
+            fused.shared[i] |= SHARE_LOG;
+            fused.savedCalls += constant ? uses : uses - 1;
+        }
+    }
+    fused.program = std::move(program);
+    return fused;
+}
+
+/*
+    Evaluation
+    Blocks of points run through every instruction in turn, as evaluateProgram() does; the shared
+    values are kept for the instructions that have SHARE_ flags only.
+*/
+
+namespace {
+
+// Values shared from the instructions, for one block of points
+struct FusedScratch {
+    std::vector<double> sine, cosine;
+    std::vector<double> sineH, cosineH;
+    std::vector<double> logs;
+    std::vector<uint32_t> side;     // Per instruction, its row in the shared values
+
+    void prepare(const FusedProgram& fused, size_t block){
+        size_t rows = 0;
+        side.resize(fused.shared.size());
+        for(size_t i = 0; i < fused.shared.size(); i++){
+            side[i] = uint32_t(rows);
+            if(fused.shared[i]) rows++;
+        }
+        for(std::vector<double>* values : {&sine, &cosine, &sineH, &cosineH, &logs}) values->resize(rows * block);
+    }
+};
+
+// Snapping of sin, cos and tan in the kernels
+inline double snapped(double value){
+    if(std::abs(value) <= EPSILON) return 0.0;
+    if(value > 1.0 - EPSILON && value < 1.0 + EPSILON) return 1.0;
+    return value;
+}
+
+// 1 / value with the division by zero handling and snapping of the reciprocal kernels
+inline double snappedReciprocal(double value){
+    if(value > 0.0 - EPSILON && value < 0.0 + EPSILON) return divideByZero(1.0, value);
+    if(value > 1.0 - EPSILON && value < 1.0 + EPSILON) return 1.0;
+    return 1.0 / value;
+}
+
+// tanh from sinh and cosh; it is exactly +-1 in double beyond 20, where they could overflow
+inline double tanhOf(double x, double sineH, double cosineH){
+    return std::abs(x) > 20.0 ? std::copysign(1.0, x) : sineH / cosineH;
+}
+
+/**
+ * Computes one instruction over a block from what its operands share
+ *
+ * Precondition: the operands of the instruction are computed
+ * Postcondition: returns false, with result untouched, if the instruction is computed normally
+ */
+bool fusedBlock(const FusedProgram& fused, const Instruction& instruction, const double* a, const double* b,
+    const FusedScratch& s, size_t block, size_t count, double* result){
+    if(childCount(instruction.kind) == 0) return false;
+    uint8_t flagsA = fused.shared[instruction.a];
+    uint8_t flagsB = childCount(instruction.kind) > 1 ? fused.shared[instruction.b] : 0;
+    if(!(flagsA | flagsB)) return false;
+    const double* sine = &s.sine[s.side[instruction.a] * block];
+    const double* cosine = &s.cosine[s.side[instruction.a] * block];
+    const double* sineH = &s.sineH[s.side[instruction.a] * block];
+    const double* cosineH = &s.cosineH[s.side[instruction.a] * block];
+    const double* logA = &s.logs[s.side[instruction.a] * block];
+    const double* logB = &s.logs[s.side[instruction.b] * block];
+
+    if(flagsA & SHARE_SINCOS){
+        switch(instruction.kind){
+            case NodeKind::Sine:
+                for(size_t j = 0; j < count; j++) result[j] = snapped(sine[j]);
+                return true;
+            case NodeKind::Cosine:
+                for(size_t j = 0; j < count; j++) result[j] = snapped(cosine[j]);
+                return true;
+            case NodeKind::Tangent:
+                for(size_t j = 0; j < count; j++) result[j] = snapped(sine[j] / cosine[j]);
+                return true;
+            case NodeKind::Secant:
+                for(size_t j = 0; j < count; j++) result[j] = snappedReciprocal(cosine[j]);
+                return true;
+            case NodeKind::Cosecant:
+                for(size_t j = 0; j < count; j++) result[j] = snappedReciprocal(sine[j]);
+                return true;
+            case NodeKind::Cotangent:
+                for(size_t j = 0; j < count; j++) result[j] = snappedReciprocal(sine[j] / cosine[j]);
+                return true;
+            default: break;
+        }
+    }
+    if(flagsA & SHARE_SINHCOSH){
+        switch(instruction.kind){
+            case NodeKind::SineH:
+                std::copy(sineH, sineH + count, result);
+                return true;
+            case NodeKind::CosineH:
+                std::copy(cosineH, cosineH + count, result);
+                return true;
+            case NodeKind::TangentH:
+                for(size_t j = 0; j < count; j++) result[j] = tanhOf(a[j], sineH[j], cosineH[j]);
+                return true;
+            case NodeKind::SecantH:
+                for(size_t j = 0; j < count; j++) result[j] = snappedReciprocal(cosineH[j]);
+                return true;
+            case NodeKind::CosecantH:
+                for(size_t j = 0; j < count; j++) result[j] = snappedReciprocal(sineH[j]);
+                return true;
+            case NodeKind::CotangentH:
+                for(size_t j = 0; j < count; j++) result[j] = snappedReciprocal(tanhOf(a[j], sineH[j], cosineH[j]));
+                return true;
+            default: break;
+        }
+    }
+    if(instruction.kind == NodeKind::Logarithmic && ((flagsA | flagsB) & SHARE_LOG)){
+        // log_a(b) = ln(b) / ln(a), as logarithmicKernel
+        for(size_t j = 0; j < count; j++){
+            double top = flagsB & SHARE_LOG ? logB[j] : mathLog(b[j]);
+            double bottom = flagsA & SHARE_LOG ? logA[j] : mathLog(a[j]);
+            result[j] = top / bottom;
+        }
+        return true;
+    }
+    if(instruction.kind == NodeKind::Exponential && (flagsA & SHARE_LOG)){
+        // b^a = exp(a ln b) for a finite positive base and a finite exponent, else the kernel
+        for(size_t j = 0; j < count; j++){
+            bool fusable = a[j] > 0.0 && std::isfinite(a[j]) && std::isfinite(b[j]);
+            result[j] = fusable ? mathExp(b[j] * logA[j]) : evaluateKind(instruction.kind, a[j], b[j], 0.0);
+        }
+        return true;
+    }
+    return false;
+}
+
+// runBlocks() with the shared values computed after the instructions that have SHARE_ flags
+template<class Read>
+void runFused(const FusedProgram& fused, const double* xs, size_t points, Read read){
+    size_t block = blockSize<double>(fused.program.instructions.size());
+    thread_local FusedScratch s;
+    s.prepare(fused, block);
+
+    auto instead = [&](uint32_t, const Instruction& instruction, const double* a, const double* b, size_t start,
+        size_t count, double* result){
+        // Constants, and their shared values, stay from the first block
+        if(instruction.kind == NodeKind::Constant) return start > 0;
+        return fusedBlock(fused, instruction, a, b, s, block, count, result);
+    };
+    auto after = [&](uint32_t i, double* result, size_t start, size_t count){
+        uint8_t flags = fused.shared[i];
+        bool constant = fused.program.instructions[i].kind == NodeKind::Constant;
+        if(!flags || (constant && start > 0)) return;
+        size_t row = s.side[i] * block;
+        // A constant fills the whole block once so that later, larger blocks read it too
+        size_t filled = constant ? block : count;
+        if(constant) std::fill(result, result + block, result[0]);
+        for(size_t j = 0; j < filled; j++){
+            if(flags & SHARE_SINCOS) mathSinCos(result[j], s.sine[row + j], s.cosine[row + j]);
+            if(flags & SHARE_SINHCOSH) mathSinhCosh(result[j], s.sineH[row + j], s.cosineH[row + j]);
+            if(flags & SHARE_LOG) s.logs[row + j] = mathLog(result[j]);
+        }
+    };
+    runBlocks(fused.program, xs, points, instead, after, read);
+}
+
+}
+
+double evaluateFused(const FusedProgram& fused, double x, size_t output){
+    uint32_t root = fused.program.outputs.at(output);
+    double value = 0.0;
+    runFused(fused, &x, 1, [&](const double* slots, size_t block, size_t, size_t){
+        value = slots[root * block];
+    });
+    return value;
+}
+
+void evaluateFused(const FusedProgram& fused, const std::vector<double>& xs, std::vector<double>& out, size_t output){
+    TraceSpan span("evaluateFused", "points", xs.size());
+    uint32_t root = fused.program.outputs.at(output);
+    out.resize(xs.size());
+    runFused(fused, xs.data(), xs.size(), [&](const double* slots, size_t block, size_t start, size_t count){
+        std::copy(slots + root * block, slots + root * block + count, out.begin() + start);
+    });
+}
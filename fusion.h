@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "program.h"
+
+/*
+    Transcendental fusion
+    Derivatives repeat transcendental calls on one argument: sin(u)' brings cos(u), tan(u)' brings
+    sec(u), sec(u)' brings sec(u) and tan(u), and (b^a)' brings ln(b) next to b^a. The fusion pass
+    finds the instructions of a Program whose value feeds several of them and marks what to compute
+    once from that value:
+        SHARE_SINCOS        one sincos for sin, cos, tan = sin / cos, sec = 1 / cos, csc, cot
+        SHARE_SINHCOSH      one expm1 for sinh, cosh, tanh = sinh / cosh, sech, csch, coth
+        SHARE_LOG           one ln for every Logarithmic using the value as base or argument, and
+                            b^a = exp(a ln b) for b > 0
+    The fused values keep the snapping to 0 and 1 and the division by zero handling of the kernels.
+    sin, cos and logarithms are the same bits as evaluate(); tan and cot, as sin / cos, and the
+    hyperbolic functions are within 2 ulp and exp(a ln b) within about |a ln b| ulp of the kernels.
+*/
+
+const uint8_t SHARE_SINCOS = 1;
+const uint8_t SHARE_SINHCOSH = 2;
+const uint8_t SHARE_LOG = 4;
+
+struct FusedProgram {
+    Program program;
+    std::vector<uint8_t> shared;    // Per instruction, the SHARE_ flags computed from its value
+    size_t savedCalls = 0;          // Transcendental calls saved per point (after the first point)
+};
+
+/**
+ * Marks the transcendental calls of the program that share an argument
+ *
+ * Precondition: None
+ * Postcondition: evaluateFused(result, x, j) = evaluateProgram(program, x, j) up to the rounding
+ *                noted above; program is unchanged
+ */
+FusedProgram fuseTranscendentals(Program program);
+
+/**
+ * Evaluates one output of a fused program at x
+ *
+ * Precondition: output < fused.program.outputs.size()
+ * Postcondition: returns the value of output at x
+ */
+double evaluateFused(const FusedProgram& fused, double x, size_t output = 0);
+
+// out[i] = evaluateFused(fused, xs[i], output), constants and their logarithms are computed once
+void evaluateFused(const FusedProgram& fused, const std::vector<double>& xs, std::vector<double>& out,
+    size_t output = 0);
@@ -0,0 +1,229 @@
+#include "guardAnalysis.h"
+#include "programBlocks.h"
+#include "scalarMath.h"
+#include "fastMath.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+/*
+    Analysis
+*/
+
+// Widens an enclosure by d on both sides, for the snapping of values within EPSILON of 0 and 1
+static Interval widenBy(const Interval& a, double d){
+    if(a.isEmpty()) return a;
+    return Interval(a.lo - d, a.hi + d);
+}
+
+// Enclosure of an instruction from the enclosures of its operands, as in evaluateInterval.cpp
+static Interval intervalOfKind(NodeKind kind, const Interval& a, const Interval& b, double payload, const Interval& domain){
+    switch(kind){
+        case NodeKind::Constant:
+        case NodeKind::Parameter: return Interval(payload);
+        case NodeKind::Variable: return domain;
+        case NodeKind::Sum: return intervalAdd(a, b);
+        case NodeKind::Difference: return intervalSub(a, b);
+        case NodeKind::Product: return intervalMul(a, b);
+        case NodeKind::Quotient: return intervalDiv(a, b);
+        case NodeKind::AbsVal: return intervalAbs(a);
+        case NodeKind::Polynomial: return intervalPow(a, payload);
+        case NodeKind::Logarithmic: return intervalLog(a, b);
+        case NodeKind::Exponential: return intervalPow(a, b);
+        case NodeKind::Sine: return widenBy(intervalSin(a), EPSILON);
+        case NodeKind::Cosine: return widenBy(intervalCos(a), EPSILON);
+        case NodeKind::Tangent: return widenBy(intervalTan(a), EPSILON);
+        case NodeKind::Secant: return widenBy(intervalReciprocal(intervalCos(a)), EPSILON);
+        case NodeKind::Cosecant: return widenBy(intervalReciprocal(intervalSin(a)), EPSILON);
+        case NodeKind::Cotangent: return widenBy(intervalReciprocal(intervalTan(a)), EPSILON);
+        case NodeKind::Arcsin: return intervalAsin(a);
+        case NodeKind::Arccos: return intervalAcos(a);
+        case NodeKind::Arctan: return intervalAtan(a);
+        case NodeKind::Arccot: return intervalAtan(intervalReciprocal(a));
+        case NodeKind::Arcsec: return intervalAcos(intervalReciprocal(a));
+        case NodeKind::Arccsc: return intervalAsin(intervalReciprocal(a));
+        case NodeKind::SineH: return intervalSinh(a);
+        case NodeKind::CosineH: return intervalCosh(a);
+        case NodeKind::TangentH: return intervalTanh(a);
+        case NodeKind::SecantH: return widenBy(intervalReciprocal(intervalCosh(a)), EPSILON);
+        case NodeKind::CosecantH: return widenBy(intervalReciprocal(intervalSinh(a)), EPSILON);
+        case NodeKind::CotangentH: return widenBy(intervalReciprocal(intervalTanh(a)), EPSILON);
+        default:
+            throw std::runtime_error("Error cannot bound node of this kind");
+    }
+}
+
+// True if the kernel of kind calls divideByZero() for some values of its operands
+static bool hasGuard(NodeKind kind){
+    switch(kind){
+        case NodeKind::Quotient:
+        case NodeKind::Secant:
+        case NodeKind::Cosecant:
+        case NodeKind::Cotangent:
+        case NodeKind::Arccot:
+        case NodeKind::Arcsec:
+        case NodeKind::Arccsc:
+        case NodeKind::SecantH:
+        case NodeKind::CosecantH:
+        case NodeKind::CotangentH:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// True if no value in the enclosure is within tolerance of 0 (tolerance 0 excludes 0 itself)
+static bool clearOfZero(const Interval& tested, double tolerance){
+    Interval t = widen(tested);
+    if(t.isEmpty()) return false;
+    return tolerance == 0.0 ? t.lo > 0.0 || t.hi < 0.0 : t.lo >= tolerance || t.hi <= -tolerance;
+}
+
+/**
+ * Tests whether the guard of an instruction can fire for operands in a and b
+ *
+ * Precondition: hasGuard(kind)
+ * Postcondition: returns true if the tested value is never 0 (or within EPSILON of 0 for the
+ *                reciprocal functions)
+ */
+static bool guardNeverFires(NodeKind kind, const Interval& a, const Interval& b){
+    switch(kind){
+        case NodeKind::Quotient: return clearOfZero(b, 0.0);
+        case NodeKind::Secant: return clearOfZero(intervalCos(a), EPSILON);
+        case NodeKind::Cosecant: return clearOfZero(intervalSin(a), EPSILON);
+        case NodeKind::Cotangent: return clearOfZero(intervalTan(a), EPSILON);
+        case NodeKind::SecantH: return clearOfZero(intervalCosh(a), EPSILON);
+        case NodeKind::CosecantH: return clearOfZero(intervalSinh(a), EPSILON);
+        case NodeKind::CotangentH: return clearOfZero(intervalTanh(a), EPSILON);
+        case NodeKind::Arccot:
+        case NodeKind::Arcsec:
+        case NodeKind::Arccsc: return clearOfZero(a, 0.0);
+        default: return false;
+    }
+}
+
+UnguardedProgram removeGuards(Program program, const Interval& domain){
+    UnguardedProgram analysed;
+    analysed.domain = domain;
+    size_t n = program.instructions.size();
+    analysed.ranges.reserve(n);
+    analysed.unguarded.assign(n, 0);
+    for(size_t i = 0; i < n; i++){
+        const Instruction& instruction = program.instructions[i];
+        int children = childCount(instruction.kind);
+        Interval a = children > 0 ? analysed.ranges[instruction.a] : Interval::empty();
+        Interval b = children > 1 ? analysed.ranges[instruction.b] : Interval::empty();
+        analysed.ranges.push_back(widen(intervalOfKind(instruction.kind, a, b, instruction.payload, domain)));
+        if(!hasGuard(instruction.kind)) continue;
+        if(guardNeverFires(instruction.kind, a, b)){
+            analysed.unguarded[i] = 1;
+            analysed.removedGuards++;
+        }
+        else{
+            analysed.remainingGuards++;
+        }
+    }
+    analysed.program = std::move(program);
+    return analysed;
+}
+
+/*
+    Evaluation
+*/
+
+namespace {
+
+// 1 / value with the snapping to 1 of the reciprocal kernels, once 0 is ruled out
+inline double reciprocal(double value){
+    return value > 1.0 - EPSILON && value < 1.0 + EPSILON ? 1.0 : 1.0 / value;
+}
+
+/**
+ * Computes an unguarded instruction over a block of points
+ *
+ * Precondition: the guard of the instruction never fires for these operands
+ * Postcondition: result[j] = evaluateKind(kind, a[j], b[j], payload) without the guard
+ */
+void unguardedBlock(NodeKind kind, const double* a, const double* b, size_t count, double* result){
+    typedef ScalarMath<double> M;
+    switch(kind){
+        case NodeKind::Quotient:
+            for(size_t j = 0; j < count; j++) result[j] = a[j] / b[j];
+            break;
+        case NodeKind::Secant:
+            for(size_t j = 0; j < count; j++) result[j] = reciprocal(M::cos(a[j]));
+            break;
+        case NodeKind::Cosecant:
+            for(size_t j = 0; j < count; j++) result[j] = reciprocal(M::sin(a[j]));
+            break;
+        case NodeKind::Cotangent:
+            for(size_t j = 0; j < count; j++) result[j] = reciprocal(M::tan(a[j]));
+            break;
+        case NodeKind::SecantH:
+            for(size_t j = 0; j < count; j++) result[j] = reciprocal(M::cosh(a[j]));
+            break;
+        case NodeKind::CosecantH:
+            for(size_t j = 0; j < count; j++) result[j] = reciprocal(M::sinh(a[j]));
+            break;
+        case NodeKind::CotangentH:
+            for(size_t j = 0; j < count; j++) result[j] = reciprocal(M::tanh(a[j]));
+            break;
+        case NodeKind::Arccot:
+            for(size_t j = 0; j < count; j++) result[j] = M::atan(1.0 / a[j]);
+            break;
+        case NodeKind::Arcsec:
+            for(size_t j = 0; j < count; j++) result[j] = M::acos(1.0 / a[j]);
+            break;
+        case NodeKind::Arccsc:
+            for(size_t j = 0; j < count; j++) result[j] = M::asin(1.0 / a[j]);
+            break;
+        default:
+            throw std::runtime_error("Error instruction has no guard to remove");
+    }
+}
+
+// True if the analysis holds for every point: the Full tier and every x within the domain
+bool analysisHolds(const UnguardedProgram& analysed, const double* xs, size_t points){
+    if(evaluationAccuracy() != Accuracy::Full) return false;
+    bool inside = true;
+    for(size_t i = 0; i < points; i++) inside &= xs[i] >= analysed.domain.lo && xs[i] <= analysed.domain.hi;
+    return inside;
+}
+
+// runBlocks() with the unguarded instructions computed by unguardedBlock()
+template<class Read>
+void runUnguarded(const UnguardedProgram& analysed, const double* xs, size_t points, Read read){
+    auto instead = [&](uint32_t i, const Instruction& instruction, const double* a, const double* b, size_t,
+        size_t count, double* result){
+        if(!analysed.unguarded[i]) return false;
+        unguardedBlock(instruction.kind, a, b, count, result);
+        return true;
+    };
+    runBlocks(analysed.program, xs, points, instead, [](uint32_t, double*, size_t, size_t){}, read);
+}
+
+}
+
+double evaluateUnguarded(const UnguardedProgram& analysed, double x, size_t output){
+    if(!analysisHolds(analysed, &x, 1)) return evaluateProgram(analysed.program, x, output);
+    uint32_t root = analysed.program.outputs.at(output);
+    double value = 0.0;
+    runUnguarded(analysed, &x, 1, [&](const double* slots, size_t block, size_t, size_t){
+        value = slots[root * block];
+    });
+    return value;
+}
+
+void evaluateUnguarded(const UnguardedProgram& analysed, const std::vector<double>& xs, std::vector<double>& out, size_t output){
+    TraceSpan span("evaluateUnguarded", "points", xs.size());
+    if(!analysisHolds(analysed, xs.data(), xs.size())){
+        evaluateProgram(analysed.program, xs, out, output);
+        return;
+    }
+    uint32_t root = analysed.program.outputs.at(output);
+    out.resize(xs.size());
+    runUnguarded(analysed, xs.data(), xs.size(), [&](const double* slots, size_t block, size_t start, size_t count){
+        std::copy(slots + root * block, slots + root * block + count, out.begin() + start);
+    });
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "program.h"
+#include "interval.h"
+
+/*
+    Guard analysis
+    The kernels guard every division: Quotient tests its denominator, sec, csc, cot, sech, csch and
+    coth test whether the value they invert is within EPSILON of 0, and arccot, arcsec and arccsc
+    test their argument for 0. A guard that fires calls divideByZero(), which records an error or
+    throws in strict mode, so no loop containing one can be vectorized.
+    removeGuards() bounds every instruction of a Program with interval arithmetic (interval.h) over
+    an input domain and marks the guards whose tested value provably stays away from 0 there.
+    evaluateUnguarded() runs those instructions as plain divisions, with the snapping to 1 of the
+    reciprocal kernels as a select, and the others through the guarded kernels.
+    The bounds are those of the exact functions widened by one ulp, and by EPSILON after a snapping
+    kernel. They hold for evaluation at the Full accuracy tier (fastMath.h). At any other tier, or at a
+    point outside the domain, evaluateUnguarded() falls back to evaluateProgram().
+*/
+
+struct UnguardedProgram {
+    Program program;
+    Interval domain = Interval::entire();
+    std::vector<Interval> ranges;       // Per instruction, an enclosure of its values over the domain
+    std::vector<uint8_t> unguarded;     // Per instruction, 1 if it has a guard that never fires
+    size_t removedGuards = 0;           // Guards proven never to fire
+    size_t remainingGuards = 0;         // Guards kept because they may fire in the domain
+};
+
+/**
+ * Proves which guards of the program can never fire for x in domain
+ *
+ * Precondition: domain is not empty
+ * Postcondition: evaluateUnguarded(result, x, j) = evaluateProgram(program, x, j) for every x in
+ *                domain; program is unchanged
+ */
+UnguardedProgram removeGuards(Program program, const Interval& domain);
+
+/**
+ * Evaluates one output of the analysed program at x
+ *
+ * Precondition: output < analysed.program.outputs.size()
+ * Postcondition: returns evaluateProgram(analysed.program, x, output)
+ */
+double evaluateUnguarded(const UnguardedProgram& analysed, double x, size_t output = 0);
+
+// out[i] = evaluateUnguarded(analysed, xs[i], output), in blocks of points as evaluateProgram()
+void evaluateUnguarded(const UnguardedProgram& analysed, const std::vector<double>& xs, std::vector<double>& out,
+    size_t output = 0);
@@ -0,0 +1,312 @@
+#include "instrumentation.h"
+#include "printer.h"
+
+#include <mutex>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <unordered_set>
+
+static const char* const operationNames[] = {"evaluate", "derivative", "simplify"};
+static const char* const cacheNames[] = {"lazyDerivative", "derivativeService", "compiledObject", "parametricNode"};
+
+const char* operationName(Operation operation){
+    return operationNames[size_t(operation)];
+}
+
+const char* cacheName(Cache cache){
+    return cacheNames[size_t(cache)];
+}
+
+#ifdef CALC_INSTRUMENTATION
+
+/*
+    Counters
+    Every thread writes only to its own block, with relaxed loads and stores of atomics so that
+    instrumentationStats() can read them from another thread at any time. resetInstrumentation()
+    never writes the counters themselves: it records their current values as baselines, which the
+    stats subtract. Blocks stay registered after their thread exits.
+*/
+
+namespace {
+
+// Only the owner writes value; reset() records a baseline instead, so an add() racing with it is never lost
+class Counter {
+    std::atomic<uint64_t> value{0};
+    std::atomic<uint64_t> base{0};      // Value at the last reset, written under the registry lock
+
+    public:
+    // Single writer: no read-modify-write needed
+    void add(uint64_t n){ value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    uint64_t get() const { return value.load(std::memory_order_relaxed) - base.load(std::memory_order_relaxed); }
+    void reset(){ base.store(value.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+};
+
+struct OperationCounters {
+    Counter calls, nanoseconds, selfNanoseconds, allocations;
+};
+
+struct ThreadCounters {
+    OperationCounters operations[size_t(Operation::Count)][size_t(NodeKind::Count)];
+    Counter hits[size_t(Cache::Count)];
+    Counter misses[size_t(Cache::Count)];
+    Counter simplifyCalls, simplifyNodesIn, simplifyNodesBuilt, simplifyNodesKept;
+};
+
+struct Registry {
+    std::mutex lock;
+    std::vector<std::shared_ptr<ThreadCounters>> threads;
+};
+
+// Never destroyed: nodes can be freed by other static destructors and by threads exiting after main
+Registry& registry(){
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+ThreadCounters& local(){
+    thread_local ThreadCounters* counters = []{
+        auto block = std::make_shared<ThreadCounters>();
+        std::lock_guard<std::mutex> guard(registry().lock);
+        registry().threads.push_back(block);
+        return block.get();
+    }();
+    return *counters;
+}
+
+std::atomic<uint64_t> nodesAllocated{0};
+std::atomic<uint64_t> nodesFreed{0};
+std::atomic<uint64_t> peakLiveNodes{0};
+// nodesFreed at the last reset, taken off both totals so that the live count is kept
+std::atomic<uint64_t> freedBeforeReset{0};
+
+// Per thread, read only by the owner. Trivially destructible, so nodes freed during thread exit are safe
+thread_local uint64_t allocatedHere = 0;
+thread_local uint64_t freedHere = 0;
+thread_local uint64_t childTime = 0;        // Time of the finished probes nested in the current one
+thread_local int simplifyDepth = 0;
+
+uint64_t now(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Distinct nodes reachable from f, shared subtrees are counted once
+uint64_t distinctNodes(const Function& f){
+    std::unordered_set<const Function*> seen;
+    std::vector<const Function*> stack{&f};
+    while(!stack.empty()){
+        const Function* node = stack.back();
+        stack.pop_back();
+        if(!seen.insert(node).second) continue;
+        NodeKind kind = kindOf(*node);
+        for(int i = 0; i < childCount(kind); i++) stack.push_back(childOf(*node, i).get());
+    }
+    return seen.size();
+}
+
+}
+
+Function::Function(){
+    recordNodeAllocated();
+}
+
+Function::Function(const Function&){
+    recordNodeAllocated();
+}
+
+Function::~Function(){
+    recordNodeFreed();
+}
+
+void recordNodeAllocated(){
+    allocatedHere++;
+    uint64_t allocated = nodesAllocated.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint64_t live = allocated - nodesFreed.load(std::memory_order_relaxed);
+    uint64_t peak = peakLiveNodes.load(std::memory_order_relaxed);
+    while(live > peak && !peakLiveNodes.compare_exchange_weak(peak, live, std::memory_order_relaxed)){}
+}
+
+void recordNodeFreed(){
+    freedHere++;
+    nodesFreed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void recordCacheAccess(Cache cache, bool hit){
+    ThreadCounters& counters = local();
+    (hit ? counters.hits : counters.misses)[size_t(cache)].add(1);
+}
+
+NodeProbe::NodeProbe(Operation o, NodeKind k, const Function& node) : operation(o), kind(k), savedChildTime(childTime), outermostSimplify(false){
+    if(operation == Operation::Simplify && simplifyDepth++ == 0){
+        outermostSimplify = true;
+        ThreadCounters& counters = local();
+        counters.simplifyCalls.add(1);
+        // Counting can materialize lazy derivatives, which is not part of this call
+        counters.simplifyNodesIn.add(distinctNodes(node));
+    }
+    childTime = 0;
+    allocationsAtStart = allocatedHere;
+    freedAtStart = freedHere;
+    start = now();
+}
+
+NodeProbe::~NodeProbe(){
+    uint64_t elapsed = now() - start;
+    uint64_t allocated = allocatedHere - allocationsAtStart;
+    ThreadCounters& counters = local();
+    OperationCounters& stats = counters.operations[size_t(operation)][size_t(kind)];
+    stats.calls.add(1);
+    stats.nanoseconds.add(elapsed);
+    stats.selfNanoseconds.add(elapsed > childTime ? elapsed - childTime : 0);
+    stats.allocations.add(allocated);
+    childTime = savedChildTime + elapsed;
+
+    if(operation == Operation::Simplify){
+        simplifyDepth--;
+        if(outermostSimplify){
+            uint64_t freed = freedHere - freedAtStart;
+            counters.simplifyNodesBuilt.add(allocated);
+            counters.simplifyNodesKept.add(allocated > freed ? allocated - freed : 0);
+        }
+    }
+}
+
+/*
+    Stats
+*/
+
+InstrumentationStats instrumentationStats(){
+    InstrumentationStats stats;
+    std::lock_guard<std::mutex> guard(registry().lock);
+    for(const auto& thread : registry().threads){
+        for(size_t o = 0; o < size_t(Operation::Count); o++){
+            for(size_t k = 0; k < size_t(NodeKind::Count); k++){
+                const OperationCounters& from = thread->operations[o][k];
+                OperationStats& to = stats.operations[o][k];
+                to.calls += from.calls.get();
+                to.nanoseconds += from.nanoseconds.get();
+                to.selfNanoseconds += from.selfNanoseconds.get();
+                to.allocations += from.allocations.get();
+            }
+        }
+        for(size_t c = 0; c < size_t(Cache::Count); c++){
+            stats.caches[c].hits += thread->hits[c].get();
+            stats.caches[c].misses += thread->misses[c].get();
+        }
+        stats.simplifyCalls += thread->simplifyCalls.get();
+        stats.simplifyNodesIn += thread->simplifyNodesIn.get();
+        stats.simplifyNodesBuilt += thread->simplifyNodesBuilt.get();
+        stats.simplifyNodesKept += thread->simplifyNodesKept.get();
+    }
+    uint64_t freedBefore = freedBeforeReset.load(std::memory_order_relaxed);
+    stats.nodesFreed = nodesFreed.load(std::memory_order_relaxed) - freedBefore;
+    stats.nodesAllocated = nodesAllocated.load(std::memory_order_relaxed) - freedBefore;
+    stats.peakLiveNodes = std::max(peakLiveNodes.load(std::memory_order_relaxed), stats.liveNodes());
+    return stats;
+}
+
+void resetInstrumentation(){
+    std::lock_guard<std::mutex> guard(registry().lock);
+    for(const auto& thread : registry().threads){
+        for(auto& row : thread->operations){
+            for(OperationCounters& counters : row){
+                counters.calls.reset();
+                counters.nanoseconds.reset();
+                counters.selfNanoseconds.reset();
+                counters.allocations.reset();
+            }
+        }
+        for(size_t c = 0; c < size_t(Cache::Count); c++){
+            thread->hits[c].reset();
+            thread->misses[c].reset();
+        }
+        thread->simplifyCalls.reset();
+        thread->simplifyNodesIn.reset();
+        thread->simplifyNodesBuilt.reset();
+        thread->simplifyNodesKept.reset();
+    }
+    uint64_t freed = nodesFreed.load(std::memory_order_relaxed);
+    freedBeforeReset.store(freed, std::memory_order_relaxed);
+    peakLiveNodes.store(nodesAllocated.load(std::memory_order_relaxed) - freed, std::memory_order_relaxed);
+}
+
+#else
+
+InstrumentationStats instrumentationStats(){
+    return InstrumentationStats();
+}
+
+void resetInstrumentation(){}
+
+#endif
+
+/*
+    JSON
+*/
+
+static void field(std::string& out, const char* name, uint64_t value, bool last = false){
+    out += '"';
+    out += name;
+    out += "\": ";
+    out += std::to_string(value);
+    if(!last) out += ", ";
+}
+
+std::string instrumentationJson(){
+    if(!instrumentationEnabled()) return "{\"enabled\": false}";
+    InstrumentationStats stats = instrumentationStats();
+    std::string out = "{\"enabled\": true, \"operations\": {";
+    for(size_t o = 0; o < size_t(Operation::Count); o++){
+        if(o) out += ", ";
+        out += '"';
+        out += operationName(Operation(o));
+        out += "\": {";
+        bool first = true;
+        for(size_t k = 0; k < size_t(NodeKind::Count); k++){
+            const OperationStats& s = stats.operations[o][k];
+            if(!s.calls) continue;
+            if(!first) out += ", ";
+            first = false;
+            out += '"';
+            out += kindName(NodeKind(k));
+            out += "\": {";
+            field(out, "calls", s.calls);
+            field(out, "nanoseconds", s.nanoseconds);
+            field(out, "selfNanoseconds", s.selfNanoseconds);
+            field(out, "allocations", s.allocations, true);
+            out += '}';
+        }
+        out += '}';
+    }
+    out += "}, \"caches\": {";
+    for(size_t c = 0; c < size_t(Cache::Count); c++){
+        const CacheStats& s = stats.caches[c];
+        if(c) out += ", ";
+        out += '"';
+        out += cacheName(Cache(c));
+        out += "\": {";
+        field(out, "hits", s.hits);
+        field(out, "misses", s.misses);
+        out += "\"hitRate\": ";
+        appendNumber(out, s.hitRate());
+        out += '}';
+    }
+    out += "}, \"nodes\": {";
+    field(out, "allocated", stats.nodesAllocated);
+    field(out, "freed", stats.nodesFreed);
+    field(out, "live", stats.liveNodes());
+    field(out, "peakLive", stats.peakLiveNodes, true);
+    out += "}, \"simplify\": {";
+    field(out, "calls", stats.simplifyCalls);
+    field(out, "nodesIn", stats.simplifyNodesIn);
+    field(out, "nodesBuilt", stats.simplifyNodesBuilt);
+    field(out, "nodesKept", stats.simplifyNodesKept, true);
+    out += "}}";
+    return out;
+}
+
+void writeInstrumentationJson(std::ostream& out){
+    out << instrumentationJson();
+}
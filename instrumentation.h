@@ -0,0 +1,122 @@
+#pragma once
+
+#include <string>
+#include <ostream>
+#include <cstdint>
+#include "nodeKind.h"
+
+/*
+    Instrumentation
+    Compiled in only when every file is built with -DCALC_INSTRUMENTATION. Otherwise the probes below
+    expand to nothing and the stats functions report that instrumentation is disabled.
+
+    When enabled it records, per operation (evaluate, derivative, simplify) and node kind:
+        calls, inclusive time, self time (excluding the children) and Function nodes allocated
+    and globally: nodes allocated, freed, alive and the peak alive, the size of every tree given to a
+    top-level simplify() with the nodes it allocated and kept, and hit/miss counts of the caches.
+    Counters live in per-thread blocks, so recording takes no lock. Time is measured around every
+    probed call, which slows evaluation down noticeably: use it to find out where time goes, not
+    to benchmark.
+*/
+
+enum class Operation : unsigned char {
+    Evaluate,
+    Derivative,
+    Simplify,
+    Count       // Number of operations, not an operation
+};
+
+enum class Cache : unsigned char {
+    LazyDerivative,         // Derivative nodes: built (miss) or reused (hit)
+    DerivativeService,      // Trees cached by the derivative server
+    CompiledObject,         // Shared objects cached on disk by codegen.h
+    ParametricNode,         // Node values kept by ParametricEvaluator after a rebind
+    Count                   // Number of caches, not a cache
+};
+
+struct OperationStats {
+    uint64_t calls = 0;
+    uint64_t nanoseconds = 0;           // Inclusive
+    uint64_t selfNanoseconds = 0;       // Excluding nested probed calls
+    uint64_t allocations = 0;           // Function nodes created during the calls, inclusive
+};
+
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    double hitRate() const { return hits + misses ? double(hits) / double(hits + misses) : 0.0; }
+};
+
+struct InstrumentationStats {
+    OperationStats operations[size_t(Operation::Count)][size_t(NodeKind::Count)];
+    CacheStats caches[size_t(Cache::Count)];
+    uint64_t nodesAllocated = 0;
+    uint64_t nodesFreed = 0;
+    uint64_t peakLiveNodes = 0;
+    uint64_t simplifyCalls = 0;         // Top-level simplify() calls
+    uint64_t simplifyNodesIn = 0;       // Distinct nodes of their inputs
+    uint64_t simplifyNodesBuilt = 0;    // Nodes they allocated, including discarded intermediates
+    uint64_t simplifyNodesKept = 0;     // Of those, nodes still alive on return: the new part of the results
+
+    uint64_t liveNodes() const { return nodesAllocated - nodesFreed; }
+    const OperationStats& of(Operation operation, NodeKind kind) const{
+        return operations[size_t(operation)][size_t(kind)];
+    }
+};
+
+// Whether the library was built with CALC_INSTRUMENTATION
+constexpr bool instrumentationEnabled(){
+#ifdef CALC_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char* operationName(Operation operation);
+const char* cacheName(Cache cache);
+
+// Sum of the counters of every thread (including finished ones). All zero when disabled
+InstrumentationStats instrumentationStats();
+
+// Sets every counter to 0, the number of live nodes is kept. Safe while other threads record: it never
+// writes their counters, so no count they add is lost
+void resetInstrumentation();
+
+// Stats as a JSON object, {"enabled": false} when disabled. Kinds that were never called are left out
+std::string instrumentationJson();
+void writeInstrumentationJson(std::ostream& out);
+
+#ifdef CALC_INSTRUMENTATION
+
+void recordCacheAccess(Cache cache, bool hit);
+void recordNodeAllocated();
+void recordNodeFreed();
+
+// Records one call of an operation on a node kind, from construction to destruction
+class NodeProbe {
+    Operation operation;
+    NodeKind kind;
+    uint64_t start;
+    uint64_t savedChildTime;
+    uint64_t allocationsAtStart;
+    uint64_t freedAtStart;
+    bool outermostSimplify;
+
+    public:
+    NodeProbe(Operation o, NodeKind k, const Function& node);
+    ~NodeProbe();
+    NodeProbe(const NodeProbe&) = delete;
+    NodeProbe& operator=(const NodeProbe&) = delete;
+};
+
+#define CALC_PROBE(operation, kind) NodeProbe calcProbe(Operation::operation, NodeKind::kind, *this)
+#define CALC_CACHE_ACCESS(cache, hit) recordCacheAccess(Cache::cache, hit)
+
+#else
+
+#define CALC_PROBE(operation, kind) ((void)0)
+#define CALC_CACHE_ACCESS(cache, hit) ((void)0)
+
+#endif
@@ -0,0 +1,261 @@
+#include "interval.h"
+
+static const double PI = std::acos(-1.0);
+static const double INF = std::numeric_limits<double>::infinity();
+
+// Beyond this magnitude the argument reduction of sin/cos/tan is too coarse to locate extrema
+static const double PERIODIC_LIMIT = 1e8;
+
+Interval Interval::entire(){
+    return Interval(-INF, INF);
+}
+
+Interval Interval::empty(){
+    return Interval(std::numeric_limits<double>::quiet_NaN());
+}
+
+bool Interval::isEmpty() const{
+    return std::isnan(lo) || std::isnan(hi);
+}
+
+bool Interval::contains(double val) const{
+    return !isEmpty() && lo <= val && val <= hi;
+}
+
+bool Interval::containsZero() const{
+    return contains(0.0);
+}
+
+double Interval::width() const{
+    return hi - lo;
+}
+
+/*
+    Basic helpers
+*/
+
+// Rounds both bounds outward by one ulp to absorb the rounding error of libm calls
+Interval widen(const Interval& a){
+    if(a.isEmpty()) return a;
+    return Interval(std::nextafter(a.lo, -INF), std::nextafter(a.hi, INF));
+}
+
+Interval hull(const Interval& a, const Interval& b){
+    if(a.isEmpty()) return b;
+    if(b.isEmpty()) return a;
+    return Interval(std::min(a.lo, b.lo), std::max(a.hi, b.hi));
+}
+
+// Clamps an enclosure to [low, high], used for functions with a bounded range
+static Interval clamp(const Interval& a, double low, double high){
+    if(a.isEmpty()) return a;
+    return Interval(std::max(a.lo, low), std::min(a.hi, high));
+}
+
+// Returns true if offset + k * period lies in a for some integer k
+static bool containsCritical(const Interval& a, double offset, double period){
+    double first = std::ceil((a.lo - offset) / period - 1e-9);
+    double last = std::floor((a.hi - offset) / period + 1e-9);
+    return first <= last;
+}
+
+// Treats 0 * inf as 0 when multiplying bounds
+static double boundProduct(double a, double b){
+    double val = a * b;
+    return std::isnan(val) ? 0.0 : val;
+}
+
+/*
+    Arithmetic
+*/
+
+Interval intervalAdd(const Interval& a, const Interval& b){
+    if(a.isEmpty() || b.isEmpty()) return Interval::empty();
+    return widen(Interval(a.lo + b.lo, a.hi + b.hi));
+}
+
+Interval intervalSub(const Interval& a, const Interval& b){
+    if(a.isEmpty() || b.isEmpty()) return Interval::empty();
+    return widen(Interval(a.lo - b.hi, a.hi - b.lo));
+}
+
+Interval intervalMul(const Interval& a, const Interval& b){
+    if(a.isEmpty() || b.isEmpty()) return Interval::empty();
+    double p1 = boundProduct(a.lo, b.lo);
+    double p2 = boundProduct(a.lo, b.hi);
+    double p3 = boundProduct(a.hi, b.lo);
+    double p4 = boundProduct(a.hi, b.hi);
+    return widen(Interval(std::min({p1, p2, p3, p4}), std::max({p1, p2, p3, p4})));
+}
+
+// 1 / a
+// A denominator that touches 0 at one end gives a half-infinite enclosure,
+// one that straddles 0 gives the entire real line
+Interval intervalReciprocal(const Interval& a){
+    if(a.isEmpty()) return a;
+    if(a.lo == 0.0 && a.hi == 0.0) return Interval::empty();
+    if(a.lo < 0.0 && a.hi > 0.0) return Interval::entire();
+    if(a.lo == 0.0) return widen(Interval(1.0 / a.hi, INF));
+    if(a.hi == 0.0) return widen(Interval(-INF, 1.0 / a.lo));
+    return widen(Interval(1.0 / a.hi, 1.0 / a.lo));
+}
+
+Interval intervalDiv(const Interval& a, const Interval& b){
+    return intervalMul(a, intervalReciprocal(b));
+}
+
+/*
+    Miscellaneous elementary functions
+*/
+
+// |f(x)| is decreasing for f(x) < 0 and increasing for f(x) > 0
+Interval intervalAbs(const Interval& a){
+    if(a.isEmpty()) return a;
+    if(a.lo >= 0.0) return a;
+    if(a.hi <= 0.0) return Interval(-a.hi, -a.lo);
+    return Interval(0.0, std::max(-a.lo, a.hi));
+}
+
+// f(x)^n for a constant exponent
+Interval intervalPow(const Interval& a, double exponent){
+    if(a.isEmpty()) return a;
+    if(exponent == 0.0) return Interval(1.0);
+
+    if(exponent == std::floor(exponent) && std::abs(exponent) < 9007199254740992.0){
+        if(exponent < 0.0) return intervalReciprocal(intervalPow(a, -exponent));
+
+        // Even powers are symmetric, odd powers are monotone increasing
+        bool even = std::fmod(exponent, 2.0) == 0.0;
+        Interval base = even ? intervalAbs(a) : a;
+        return widen(Interval(std::pow(base.lo, exponent), std::pow(base.hi, exponent)));
+    }
+
+    // Non-integer exponents are only real for f(x) >= 0
+    if(a.hi < 0.0) return Interval::empty();
+    Interval base = Interval(std::max(a.lo, 0.0), a.hi);
+    if(exponent > 0.0){
+        return widen(Interval(std::pow(base.lo, exponent), std::pow(base.hi, exponent)));
+    }
+    return widen(Interval(std::pow(base.hi, exponent), std::pow(base.lo, exponent)));
+}
+
+// g(x)^f(x) = e^(f(x) * ln(g(x))) for g(x) > 0
+Interval intervalPow(const Interval& base, const Interval& exponent){
+    if(base.isEmpty() || exponent.isEmpty()) return Interval::empty();
+    if(exponent.lo == exponent.hi) return intervalPow(base, exponent.lo);
+    if(base.lo > 0.0) return intervalExp(intervalMul(exponent, intervalLog(base)));
+    if(base.lo >= 0.0) return Interval(0.0, INF);
+    return Interval::entire();
+}
+
+// ln(f(x)) is increasing and only defined for f(x) > 0
+Interval intervalLog(const Interval& a){
+    if(a.isEmpty() || a.hi <= 0.0) return Interval::empty();
+    double low = a.lo <= 0.0 ? -INF : std::log(a.lo);
+    return widen(Interval(low, std::log(a.hi)));
+}
+
+// log_b(f(x)) = ln(f(x)) / ln(b)
+Interval intervalLog(const Interval& base, const Interval& argument){
+    return intervalDiv(intervalLog(argument), intervalLog(base));
+}
+
+Interval intervalExp(const Interval& a){
+    if(a.isEmpty()) return a;
+    return widen(Interval(std::exp(a.lo), std::exp(a.hi)));
+}
+
+/*
+    Trigonometric functions
+    Extrema are found by checking whether a critical point of the period lies in the interval
+*/
+
+// sin has maxima at pi/2 + 2k*pi and minima at -pi/2 + 2k*pi
+Interval intervalSin(const Interval& a){
+    if(a.isEmpty()) return a;
+    if(a.width() >= 2.0 * PI || std::max(std::abs(a.lo), std::abs(a.hi)) > PERIODIC_LIMIT){
+        return Interval(-1.0, 1.0);
+    }
+    double s1 = std::sin(a.lo);
+    double s2 = std::sin(a.hi);
+    double low = std::min(s1, s2);
+    double high = std::max(s1, s2);
+    if(containsCritical(a, PI / 2.0, 2.0 * PI)) high = 1.0;
+    if(containsCritical(a, -PI / 2.0, 2.0 * PI)) low = -1.0;
+    return clamp(widen(Interval(low, high)), -1.0, 1.0);
+}
+
+// cos has maxima at 2k*pi and minima at pi + 2k*pi
+Interval intervalCos(const Interval& a){
+    if(a.isEmpty()) return a;
+    if(a.width() >= 2.0 * PI || std::max(std::abs(a.lo), std::abs(a.hi)) > PERIODIC_LIMIT){
+        return Interval(-1.0, 1.0);
+    }
+    double c1 = std::cos(a.lo);
+    double c2 = std::cos(a.hi);
+    double low = std::min(c1, c2);
+    double high = std::max(c1, c2);
+    if(containsCritical(a, 0.0, 2.0 * PI)) high = 1.0;
+    if(containsCritical(a, PI, 2.0 * PI)) low = -1.0;
+    return clamp(widen(Interval(low, high)), -1.0, 1.0);
+}
+
+// tan is increasing between its poles at pi/2 + k*pi
+Interval intervalTan(const Interval& a){
+    if(a.isEmpty()) return a;
+    if(a.width() >= PI || std::max(std::abs(a.lo), std::abs(a.hi)) > PERIODIC_LIMIT){
+        return Interval::entire();
+    }
+    if(containsCritical(a, PI / 2.0, PI)) return Interval::entire();
+    return widen(Interval(std::tan(a.lo), std::tan(a.hi)));
+}
+
+/*
+    Inverse trig functions
+*/
+
+// arcsin is increasing on [-1, 1]
+Interval intervalAsin(const Interval& a){
+    if(a.isEmpty() || a.hi < -1.0 || a.lo > 1.0) return Interval::empty();
+    Interval domain = clamp(a, -1.0, 1.0);
+    return clamp(widen(Interval(std::asin(domain.lo), std::asin(domain.hi))), -PI / 2.0, PI / 2.0);
+}
+
+// arccos is decreasing on [-1, 1]
+Interval intervalAcos(const Interval& a){
+    if(a.isEmpty() || a.hi < -1.0 || a.lo > 1.0) return Interval::empty();
+    Interval domain = clamp(a, -1.0, 1.0);
+    return clamp(widen(Interval(std::acos(domain.hi), std::acos(domain.lo))), 0.0, PI);
+}
+
+// arctan is increasing everywhere
+Interval intervalAtan(const Interval& a){
+    if(a.isEmpty()) return a;
+    return clamp(widen(Interval(std::atan(a.lo), std::atan(a.hi))), -PI / 2.0, PI / 2.0);
+}
+
+/*
+    Hyperbolic functions
+*/
+
+// sinh is increasing everywhere
+Interval intervalSinh(const Interval& a){
+    if(a.isEmpty()) return a;
+    return widen(Interval(std::sinh(a.lo), std::sinh(a.hi)));
+}
+
+// cosh is decreasing for x < 0 and increasing for x > 0 with a minimum of 1 at 0
+Interval intervalCosh(const Interval& a){
+    if(a.isEmpty()) return a;
+    double c1 = std::cosh(a.lo);
+    double c2 = std::cosh(a.hi);
+    double low = a.containsZero() ? 1.0 : std::min(c1, c2);
+    Interval result = widen(Interval(low, std::max(c1, c2)));
+    return Interval(std::max(result.lo, 1.0), result.hi);
+}
+
+// tanh is increasing everywhere with range (-1, 1)
+Interval intervalTanh(const Interval& a){
+    if(a.isEmpty()) return a;
+    return clamp(widen(Interval(std::tanh(a.lo), std::tanh(a.hi))), -1.0, 1.0);
+}
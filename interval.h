@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+/*
+    Closed interval [lo, hi] used for interval-arithmetic evaluation.
+    Every operation rounds its result outward by one ulp so the returned interval is a
+    guaranteed enclosure of the true range of the exact (unsnapped) function over the input
+    interval. Function::evaluateInterval adds the snapping of evaluate() to 0 and 1 on top of them
+    (evaluateInterval.cpp).
+    An empty interval (no valid values, e.g. ln of a negative range) is stored as [NaN, NaN].
+*/
+struct Interval {
+    double lo;
+    double hi;
+
+    Interval(double l, double h) : lo(l), hi(h) {}
+    Interval(double val) : lo(val), hi(val) {}
+
+    static Interval entire();
+    static Interval empty();
+
+    bool isEmpty() const;
+    bool contains(double val) const;
+    bool containsZero() const;
+    double width() const;
+};
+
+// Helper operations used by Function::evaluateInterval
+// Each one takes the enclosure(s) of the argument(s) and returns an enclosure of the result
+
+Interval widen(const Interval& a);
+Interval hull(const Interval& a, const Interval& b);
+
+Interval intervalAdd(const Interval& a, const Interval& b);
+Interval intervalSub(const Interval& a, const Interval& b);
+Interval intervalMul(const Interval& a, const Interval& b);
+Interval intervalDiv(const Interval& a, const Interval& b);
+Interval intervalReciprocal(const Interval& a);
+
+Interval intervalAbs(const Interval& a);
+Interval intervalPow(const Interval& a, double exponent);
+Interval intervalPow(const Interval& base, const Interval& exponent);
+Interval intervalLog(const Interval& a);
+Interval intervalLog(const Interval& base, const Interval& argument);
+Interval intervalExp(const Interval& a);
+
+Interval intervalSin(const Interval& a);
+Interval intervalCos(const Interval& a);
+Interval intervalTan(const Interval& a);
+
+Interval intervalAsin(const Interval& a);
+Interval intervalAcos(const Interval& a);
+Interval intervalAtan(const Interval& a);
+
+Interval intervalSinh(const Interval& a);
+Interval intervalCosh(const Interval& a);
+Interval intervalTanh(const Interval& a);
@@ -0,0 +1,273 @@
+#include "jit.h"
+#include "evaluateKernels.h"
+#include "evaluationStatus.h"
+#include "tracing.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+    Kernels called by the generated code
+*/
+
+typedef double (*UnaryKernel)(double);
+typedef double (*BinaryKernel)(double, double);
+
+static void* kernelOf(NodeKind kind){
+    switch(kind){
+        case NodeKind::Quotient: return reinterpret_cast<void*>(static_cast<BinaryKernel>(quotientKernel));
+        case NodeKind::Polynomial: return reinterpret_cast<void*>(static_cast<BinaryKernel>(polynomialKernel));
+        case NodeKind::Logarithmic: return reinterpret_cast<void*>(static_cast<BinaryKernel>(logarithmicKernel));
+        case NodeKind::Exponential: return reinterpret_cast<void*>(static_cast<BinaryKernel>(exponentialKernel));
+        case NodeKind::Sine: return reinterpret_cast<void*>(static_cast<UnaryKernel>(sineKernel));
+        case NodeKind::Cosine: return reinterpret_cast<void*>(static_cast<UnaryKernel>(cosineKernel));
+        case NodeKind::Tangent: return reinterpret_cast<void*>(static_cast<UnaryKernel>(tangentKernel));
+        case NodeKind::Secant: return reinterpret_cast<void*>(static_cast<UnaryKernel>(secantKernel));
+        case NodeKind::Cosecant: return reinterpret_cast<void*>(static_cast<UnaryKernel>(cosecantKernel));
+        case NodeKind::Cotangent: return reinterpret_cast<void*>(static_cast<UnaryKernel>(cotangentKernel));
+        case NodeKind::Arcsin: return reinterpret_cast<void*>(static_cast<UnaryKernel>(arcsinKernel));
+        case NodeKind::Arccos: return reinterpret_cast<void*>(static_cast<UnaryKernel>(arccosKernel));
+        case NodeKind::Arctan: return reinterpret_cast<void*>(static_cast<UnaryKernel>(arctanKernel));
+        case NodeKind::Arccot: return reinterpret_cast<void*>(static_cast<UnaryKernel>(arccotKernel));
+        case NodeKind::Arcsec: return reinterpret_cast<void*>(static_cast<UnaryKernel>(arcsecKernel));
+        case NodeKind::Arccsc: return reinterpret_cast<void*>(static_cast<UnaryKernel>(arccscKernel));
+        case NodeKind::SineH: return reinterpret_cast<void*>(static_cast<UnaryKernel>(sineHKernel));
+        case NodeKind::CosineH: return reinterpret_cast<void*>(static_cast<UnaryKernel>(cosineHKernel));
+        case NodeKind::TangentH: return reinterpret_cast<void*>(static_cast<UnaryKernel>(tangentHKernel));
+        case NodeKind::SecantH: return reinterpret_cast<void*>(static_cast<UnaryKernel>(secantHKernel));
+        case NodeKind::CosecantH: return reinterpret_cast<void*>(static_cast<UnaryKernel>(cosecantHKernel));
+        case NodeKind::CotangentH: return reinterpret_cast<void*>(static_cast<UnaryKernel>(cotangentHKernel));
+        default: return nullptr;
+    }
+}
+
+#if defined(__x86_64__)
+
+/*
+    x86-64 code emission
+    Only xmm0 and xmm1 are used (no REX prefix needed for them), rax holds immediates and call targets
+*/
+namespace {
+
+class Assembler {
+    std::vector<uint8_t>& code;
+    const Program& program;
+
+    void bytes(std::initializer_list<uint8_t> list){
+        code.insert(code.end(), list);
+    }
+
+    void imm32(uint32_t value){
+        for(int i = 0; i < 4; i++) code.push_back(uint8_t(value >> (8 * i)));
+    }
+
+    void imm64(uint64_t value){
+        for(int i = 0; i < 8; i++) code.push_back(uint8_t(value >> (8 * i)));
+    }
+
+    // op xmm, [rbx + 8 * slot] with a 32-bit displacement
+    void slotOperand(uint8_t prefix, uint8_t opcode, int xmm, uint32_t slot){
+        bytes({prefix, 0x0F, opcode, uint8_t(0x80 | (xmm << 3) | 3)});
+        imm32(slot * 8);
+    }
+
+    public:
+    Assembler(std::vector<uint8_t>& c, const Program& p) : code(c), program(p) {}
+
+    void prologue(){
+        bytes({0x53});                          // push rbx (also aligns the stack for calls)
+        bytes({0x48, 0x89, 0xFB});              // mov rbx, rdi
+    }
+
+    void epilogue(){
+        bytes({0x5B, 0xC3});                    // pop rbx; ret
+    }
+
+    // mov rax, imm64; movq xmm, rax
+    void loadImmediate(int xmm, double value){
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        bytes({0x48, 0xB8});
+        imm64(bits);
+        bytes({0x66, 0x48, 0x0F, 0x6E, uint8_t(0xC0 | (xmm << 3))});
+    }
+
+    // Loads the value of instruction i, constants are immediates
+    void load(int xmm, uint32_t i){
+        const Instruction& instruction = program.instructions[i];
+        if(instruction.kind == NodeKind::Constant) loadImmediate(xmm, instruction.payload);
+        else slotOperand(0xF2, 0x10, xmm, i);   // movsd xmm, [slot]
+    }
+
+    void store(uint32_t i){
+        slotOperand(0xF2, 0x11, 0, i);          // movsd [slot], xmm0
+    }
+
+    // addsd/subsd/mulsd xmm0, operand b
+    void arithmetic(uint8_t opcode, uint32_t b){
+        const Instruction& instruction = program.instructions[b];
+        if(instruction.kind == NodeKind::Constant){
+            loadImmediate(1, instruction.payload);
+            bytes({0xF2, 0x0F, opcode, 0xC1});  // op xmm0, xmm1
+        }
+        else{
+            slotOperand(0xF2, opcode, 0, b);
+        }
+    }
+
+    // Clears the sign bit of xmm0
+    void absolute(){
+        bytes({0x66, 0x48, 0x0F, 0x7E, 0xC0}); // movq rax, xmm0
+        bytes({0x48, 0x0F, 0xBA, 0xF0, 0x3F}); // btr rax, 63
+        bytes({0x66, 0x48, 0x0F, 0x6E, 0xC0}); // movq xmm0, rax
+    }
+
+    void call(void* target){
+        bytes({0x48, 0xB8});                    // mov rax, target
+        imm64(reinterpret_cast<uint64_t>(target));
+        bytes({0xFF, 0xD0});                    // call rax
+    }
+};
+
+}
+
+static void emitProgram(const Program& program, std::vector<uint8_t>& code){
+    Assembler assembler(code, program);
+    assembler.prologue();
+    // x arrives in xmm0, store it before any other instruction overwrites xmm0
+    for(uint32_t i = 0; i < program.instructions.size(); i++){
+        if(program.instructions[i].kind == NodeKind::Variable) assembler.store(i);
+    }
+    for(uint32_t i = 0; i < program.instructions.size(); i++){
+        const Instruction& instruction = program.instructions[i];
+        switch(instruction.kind){
+            case NodeKind::Constant:
+                continue;
+            case NodeKind::Variable:
+                continue;
+            case NodeKind::Sum:
+                assembler.load(0, instruction.a);
+                assembler.arithmetic(0x58, instruction.b);
+                break;
+            case NodeKind::Difference:
+                assembler.load(0, instruction.a);
+                assembler.arithmetic(0x5C, instruction.b);
+                break;
+            case NodeKind::Product:
+                assembler.load(0, instruction.a);
+                assembler.arithmetic(0x59, instruction.b);
+                break;
+            case NodeKind::AbsVal:
+                assembler.load(0, instruction.a);
+                assembler.absolute();
+                break;
+            case NodeKind::Polynomial:
+                assembler.load(0, instruction.a);
+                assembler.loadImmediate(1, instruction.payload);
+                assembler.call(kernelOf(instruction.kind));
+                break;
+            default:
+                if(!kernelOf(instruction.kind)){
+                    throw std::runtime_error(std::string("Error cannot compile ") + kindName(instruction.kind));
+                }
+                assembler.load(0, instruction.a);
+                if(childCount(instruction.kind) > 1) assembler.load(1, instruction.b);
+                assembler.call(kernelOf(instruction.kind));
+                break;
+        }
+        assembler.store(i);
+    }
+    // The result is returned in xmm0
+    assembler.load(0, program.outputs[0]);
+    assembler.epilogue();
+}
+
+#endif
+
+/*
+    Compiled functions
+*/
+
+JitFunction::JitFunction(Program p, bool allowNative) : program(std::move(p)){
+    if(program.outputs.size() != 1) throw std::runtime_error("Error the JIT needs exactly one root");
+    for(const Instruction& instruction : program.instructions){
+        if(instruction.kind == NodeKind::Parameter){
+            throw std::runtime_error("Error cannot compile a parameter, replace it with a constant first");
+        }
+    }
+
+#if defined(__x86_64__)
+    if(!allowNative) return;
+    std::vector<uint8_t> bytes;
+    emitProgram(program, bytes);
+
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t size = (bytes.size() + page - 1) / page * page;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED) return;
+    std::memcpy(memory, bytes.data(), bytes.size());
+    // Never writable and executable at the same time
+    if(mprotect(memory, size, PROT_READ | PROT_EXEC) != 0){
+        munmap(memory, size);
+        return;
+    }
+    code = memory;
+    codeSize = size;
+    native = reinterpret_cast<double (*)(double, double*)>(memory);
+#endif
+}
+
+JitFunction::~JitFunction(){
+    if(code) munmap(code, codeSize);
+}
+
+double JitFunction::interpret(double x, double* slots) const{
+    for(uint32_t i = 0; i < program.instructions.size(); i++){
+        const Instruction& instruction = program.instructions[i];
+        int children = childCount(instruction.kind);
+        double a = instruction.kind == NodeKind::Variable ? x : children > 0 ? slots[instruction.a] : 0.0;
+        double b = children > 1 ? slots[instruction.b] : 0.0;
+        slots[i] = evaluateKind(instruction.kind, a, b, instruction.payload);
+    }
+    return slots[program.outputs[0]];
+}
+
+// Scratch slots of the calling thread, so a compiled function can be shared between threads
+static double* scratch(size_t size){
+    thread_local std::vector<double> slots;
+    if(slots.size() < size) slots.resize(size);
+    return slots.data();
+}
+
+// The generated code has no unwind information, so an exception thrown by a kernel it calls would
+// terminate the process: in strict mode, where divideByZero() throws, the interpreter runs instead
+bool JitFunction::runsNative() const{
+    return native && !isStrictEvaluation();
+}
+
+double JitFunction::operator()(double x) const{
+    double* slots = scratch(program.instructions.size());
+    return runsNative() ? native(x, slots) : interpret(x, slots);
+}
+
+void JitFunction::evaluate(const double* xs, double* out, size_t n) const{
+    double* slots = scratch(program.instructions.size());
+    if(runsNative()){
+        for(size_t i = 0; i < n; i++) out[i] = native(xs[i], slots);
+    }
+    else{
+        for(size_t i = 0; i < n; i++) out[i] = interpret(xs[i], slots);
+    }
+}
+
+void JitFunction::evaluate(const std::vector<double>& xs, std::vector<double>& out) const{
+    TraceSpan span("evaluateJit", "points", xs.size());
+    out.resize(xs.size());
+    evaluate(xs.data(), out.data(), xs.size());
+}
+
+std::shared_ptr<JitFunction> jitCompile(const Function& f, bool allowNative){
+    return std::make_shared<JitFunction>(buildProgram(f), allowNative);
+}
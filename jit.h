@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "program.h"
+
+/*
+    In-process JIT (x86-64)
+    Compiles the program of a Function tree (see program.h) straight to SSE2 machine code in an
+    executable mapping, in microseconds and without an external compiler (compare codegen.h).
+    Sums, differences, products and absolute values are emitted inline; every other node calls its
+    scalar kernel from evaluateKernels.h, so results and evaluation errors match evaluate() exactly.
+    When executable memory cannot be mapped, or on other architectures, the program is run by an
+    interpreter instead. So is every call made in strict mode (evaluationStatus.h): an exception
+    cannot unwind through the generated code, which has no unwind information.
+
+    Generated code: double run(double x, double* slots)
+        rbx holds slots, slot i keeps the value of instruction i, constants are immediates
+*/
+class JitFunction {
+    Program program;
+    double (*native)(double, double*) = nullptr;
+    void* code = nullptr;
+    size_t codeSize = 0;
+
+    double interpret(double x, double* slots) const;
+    bool runsNative() const;
+
+    public:
+    JitFunction(Program p, bool allowNative);
+    ~JitFunction();
+    JitFunction(const JitFunction&) = delete;
+    JitFunction& operator=(const JitFunction&) = delete;
+
+    double operator()(double x) const;
+
+    // out[i] = f(xs[i]) for every i < n
+    void evaluate(const double* xs, double* out, size_t n) const;
+    void evaluate(const std::vector<double>& xs, std::vector<double>& out) const;
+
+    // Whether machine code was generated (false: the interpreter is used)
+    bool isNative() const { return native != nullptr; }
+    size_t machineCodeSize() const { return codeSize; }
+};
+
+/**
+ * Compiles f for fast repeated evaluation
+ *
+ * Precondition: f contains no Parameter nodes
+ * Postcondition: (*jitCompile(f))(x) = f.evaluate(x), the interpreter is used if allowNative is false
+ *                or machine code cannot be generated
+ */
+std::shared_ptr<JitFunction> jitCompile(const Function& f, bool allowNative = true);
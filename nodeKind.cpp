@@ -0,0 +1,207 @@
+#include "nodeKind.h"
+#include "evaluateKernels.h"
+#include "parameters.h"
+#include "scalarMath.h"
+
+#include <typeindex>
+#include <unordered_map>
+#include <stdexcept>
+
+// Lazy derivatives have no kind of their own, passes see the derivative they build
+static const Function& resolved(const Function& f){
+    const Function* node = &f;
+    while(typeid(*node) == typeid(Derivative)){
+        node = static_cast<const Derivative*>(node)->materialize().get();
+    }
+    return *node;
+}
+
+NodeKind kindOf(const Function& function){
+    const Function& f = resolved(function);
+    static const std::pair<const std::type_info*, NodeKind> entries[] = {
+        {&typeid(Constant), NodeKind::Constant}, {&typeid(Variable), NodeKind::Variable},
+        {&typeid(Sum), NodeKind::Sum}, {&typeid(Difference), NodeKind::Difference},
+        {&typeid(Product), NodeKind::Product}, {&typeid(Quotient), NodeKind::Quotient},
+        {&typeid(AbsVal), NodeKind::AbsVal}, {&typeid(Polynomial), NodeKind::Polynomial},
+        {&typeid(Logarithmic), NodeKind::Logarithmic}, {&typeid(Exponential), NodeKind::Exponential},
+        {&typeid(Sine), NodeKind::Sine}, {&typeid(Cosine), NodeKind::Cosine},
+        {&typeid(Tangent), NodeKind::Tangent}, {&typeid(Secant), NodeKind::Secant},
+        {&typeid(Cosecant), NodeKind::Cosecant}, {&typeid(Cotangent), NodeKind::Cotangent},
+        {&typeid(Arcsin), NodeKind::Arcsin}, {&typeid(Arccos), NodeKind::Arccos},
+        {&typeid(Arctan), NodeKind::Arctan}, {&typeid(Arccot), NodeKind::Arccot},
+        {&typeid(Arcsec), NodeKind::Arcsec}, {&typeid(Arccsc), NodeKind::Arccsc},
+        {&typeid(SineH), NodeKind::SineH}, {&typeid(CosineH), NodeKind::CosineH},
+        {&typeid(TangentH), NodeKind::TangentH}, {&typeid(SecantH), NodeKind::SecantH},
+        {&typeid(CosecantH), NodeKind::CosecantH}, {&typeid(CotangentH), NodeKind::CotangentH},
+        {&typeid(Parameter), NodeKind::Parameter}
+    };
+    // Looked up by address first: hashing a type_index hashes the mangled name of the type
+    static const auto tables = [](){
+        std::pair<std::unordered_map<const std::type_info*, NodeKind>, std::unordered_map<std::type_index, NodeKind>> t;
+        for(const auto& entry : entries){
+            t.first.emplace(entry.first, entry.second);
+            t.second.emplace(*entry.first, entry.second);
+        }
+        return t;
+    }();
+    auto fast = tables.first.find(&typeid(f));
+    if(fast != tables.first.end()) return fast->second;
+    auto kind = tables.second.find(typeid(f));
+    if(kind == tables.second.end()){
+        throw std::runtime_error("Error unsupported function type");
+    }
+    return kind->second;
+}
+
+const char* kindName(NodeKind kind){
+    static const char* names[] = {
+        "Constant", "Variable",
+        "Sum", "Difference", "Product", "Quotient",
+        "AbsVal", "Polynomial", "Logarithmic", "Exponential",
+        "Sine", "Cosine", "Tangent", "Secant", "Cosecant", "Cotangent",
+        "Arcsin", "Arccos", "Arctan", "Arccot", "Arcsec", "Arccsc",
+        "SineH", "CosineH", "TangentH", "SecantH", "CosecantH", "CotangentH",
+        "Parameter"
+    };
+    return kind < NodeKind::Count ? names[static_cast<int>(kind)] : "Unknown";
+}
+
+int childCount(NodeKind kind){
+    switch(kind){
+        case NodeKind::Constant:
+        case NodeKind::Variable:
+        case NodeKind::Parameter:
+            return 0;
+        case NodeKind::Sum:
+        case NodeKind::Difference:
+        case NodeKind::Product:
+        case NodeKind::Quotient:
+        case NodeKind::Logarithmic:
+        case NodeKind::Exponential:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+const std::shared_ptr<Function>& childOf(const Function& function, int i){
+    const Function& f = resolved(function);
+    switch(kindOf(f)){
+        case NodeKind::Sum:
+            return i == 0 ? static_cast<const Sum&>(f).getLeft() : static_cast<const Sum&>(f).getRight();
+        case NodeKind::Difference:
+            return i == 0 ? static_cast<const Difference&>(f).getLeft() : static_cast<const Difference&>(f).getRight();
+        case NodeKind::Product:
+            return i == 0 ? static_cast<const Product&>(f).getLeft() : static_cast<const Product&>(f).getRight();
+        case NodeKind::Quotient:
+            return i == 0 ? static_cast<const Quotient&>(f).getLeft() : static_cast<const Quotient&>(f).getRight();
+        case NodeKind::Logarithmic:
+            return i == 0 ? static_cast<const Logarithmic&>(f).getBase() : static_cast<const Logarithmic&>(f).getArgument();
+        case NodeKind::Exponential:
+            return i == 0 ? static_cast<const Exponential&>(f).getBase() : static_cast<const Exponential&>(f).getArgument();
+        case NodeKind::AbsVal:
+            return static_cast<const AbsVal&>(f).getArgument();
+        case NodeKind::Polynomial:
+            return static_cast<const Polynomial&>(f).getCoefficient();
+        case NodeKind::Constant:
+        case NodeKind::Variable:
+        case NodeKind::Parameter:
+            throw std::runtime_error("Error function has no children");
+        default:
+            return static_cast<const Trigonometric&>(f).getArgument();
+    }
+}
+
+double payloadOf(const Function& function){
+    const Function& f = resolved(function);
+    switch(kindOf(f)){
+        case NodeKind::Constant: return static_cast<const Constant&>(f).getValue();
+        case NodeKind::Polynomial: return static_cast<const Polynomial&>(f).getExponent();
+        case NodeKind::Parameter: return static_cast<const Parameter&>(f).getValue();
+        default: return 0.0;
+    }
+}
+
+const std::string& nameOf(const Function& function){
+    const Function& f = resolved(function);
+    switch(kindOf(f)){
+        case NodeKind::Variable: return static_cast<const Variable&>(f).getName();
+        case NodeKind::Parameter: return static_cast<const Parameter&>(f).getName();
+        default: throw std::runtime_error("Error function has no name");
+    }
+}
+
+std::shared_ptr<Function> makeNode(NodeKind kind, std::shared_ptr<Function> a, std::shared_ptr<Function> b, double payload){
+    switch(kind){
+        case NodeKind::Constant: return std::make_shared<Constant>(payload);
+        case NodeKind::Sum: return std::make_shared<Sum>(std::move(a), std::move(b));
+        case NodeKind::Difference: return std::make_shared<Difference>(std::move(a), std::move(b));
+        case NodeKind::Product: return std::make_shared<Product>(std::move(a), std::move(b));
+        case NodeKind::Quotient: return std::make_shared<Quotient>(std::move(a), std::move(b));
+        case NodeKind::AbsVal: return std::make_shared<AbsVal>(std::move(a));
+        case NodeKind::Polynomial: return std::make_shared<Polynomial>(std::move(a), payload);
+        case NodeKind::Logarithmic: return std::make_shared<Logarithmic>(std::move(a), std::move(b));
+        case NodeKind::Exponential: return std::make_shared<Exponential>(std::move(a), std::move(b));
+        case NodeKind::Sine: return std::make_shared<Sine>(std::move(a));
+        case NodeKind::Cosine: return std::make_shared<Cosine>(std::move(a));
+        case NodeKind::Tangent: return std::make_shared<Tangent>(std::move(a));
+        case NodeKind::Secant: return std::make_shared<Secant>(std::move(a));
+        case NodeKind::Cosecant: return std::make_shared<Cosecant>(std::move(a));
+        case NodeKind::Cotangent: return std::make_shared<Cotangent>(std::move(a));
+        case NodeKind::Arcsin: return std::make_shared<Arcsin>(std::move(a));
+        case NodeKind::Arccos: return std::make_shared<Arccos>(std::move(a));
+        case NodeKind::Arctan: return std::make_shared<Arctan>(std::move(a));
+        case NodeKind::Arccot: return std::make_shared<Arccot>(std::move(a));
+        case NodeKind::Arcsec: return std::make_shared<Arcsec>(std::move(a));
+        case NodeKind::Arccsc: return std::make_shared<Arccsc>(std::move(a));
+        case NodeKind::SineH: return std::make_shared<SineH>(std::move(a));
+        case NodeKind::CosineH: return std::make_shared<CosineH>(std::move(a));
+        case NodeKind::TangentH: return std::make_shared<TangentH>(std::move(a));
+        case NodeKind::SecantH: return std::make_shared<SecantH>(std::move(a));
+        case NodeKind::CosecantH: return std::make_shared<CosecantH>(std::move(a));
+        case NodeKind::CotangentH: return std::make_shared<CotangentH>(std::move(a));
+        default:
+            throw std::runtime_error("Error cannot build node of this kind");
+    }
+}
+
+template<class T>
+T evaluateKind(NodeKind kind, T a, T b, T payload){
+    switch(kind){
+        case NodeKind::Constant: return payload;
+        case NodeKind::Parameter: return payload;
+        case NodeKind::Variable: return a;
+        case NodeKind::Sum: return a + b;
+        case NodeKind::Difference: return a - b;
+        case NodeKind::Product: return a * b;
+        case NodeKind::Quotient: return quotientKernel(a, b);
+        case NodeKind::AbsVal: return absKernel(a);
+        case NodeKind::Polynomial: return polynomialKernel(a, payload);
+        case NodeKind::Logarithmic: return logarithmicKernel(a, b);
+        case NodeKind::Exponential: return exponentialKernel(a, b);
+        case NodeKind::Sine: return sineKernel(a);
+        case NodeKind::Cosine: return cosineKernel(a);
+        case NodeKind::Tangent: return tangentKernel(a);
+        case NodeKind::Secant: return secantKernel(a);
+        case NodeKind::Cosecant: return cosecantKernel(a);
+        case NodeKind::Cotangent: return cotangentKernel(a);
+        case NodeKind::Arcsin: return arcsinKernel(a);
+        case NodeKind::Arccos: return arccosKernel(a);
+        case NodeKind::Arctan: return arctanKernel(a);
+        case NodeKind::Arccot: return arccotKernel(a);
+        case NodeKind::Arcsec: return arcsecKernel(a);
+        case NodeKind::Arccsc: return arccscKernel(a);
+        case NodeKind::SineH: return sineHKernel(a);
+        case NodeKind::CosineH: return cosineHKernel(a);
+        case NodeKind::TangentH: return tangentHKernel(a);
+        case NodeKind::SecantH: return secantHKernel(a);
+        case NodeKind::CosecantH: return cosecantHKernel(a);
+        case NodeKind::CotangentH: return cotangentHKernel(a);
+        default:
+            throw std::runtime_error("Error cannot evaluate node of this kind");
+    }
+}
+
+#define CALC_INSTANTIATE_EVALUATE_KIND(T) template T evaluateKind<T>(NodeKind, T, T, T);
+CALC_FOR_EACH_SCALAR(CALC_INSTANTIATE_EVALUATE_KIND)
+CALC_INSTANTIATE_EVALUATE_KIND(std::complex<double>)
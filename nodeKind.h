@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "Functions.h"
+
+/*
+    Node kinds
+    A tag for every concrete Function class, used by passes that handle whole trees without
+    virtual calls (serialization, flat storage, code generation).
+    Children are numbered in the order the class stores them:
+        Sum, Difference, Product, Quotient: 0 = left, 1 = right
+        Logarithmic, Exponential:           0 = base, 1 = argument
+        Polynomial:                         0 = coefficient (the exponent is the payload)
+        AbsVal, Trigonometric:              0 = argument
+    Constant stores its value as the payload, Parameter its currently bound value.
+    Lazy Derivative nodes are looked through: they report the kind, children and payload of the
+    derivative they build.
+*/
+enum class NodeKind : uint8_t {
+    Constant, Variable,
+    Sum, Difference, Product, Quotient,
+    AbsVal, Polynomial, Logarithmic, Exponential,
+    Sine, Cosine, Tangent, Secant, Cosecant, Cotangent,
+    Arcsin, Arccos, Arctan, Arccot, Arcsec, Arccsc,
+    SineH, CosineH, TangentH, SecantH, CosecantH, CotangentH,
+    Parameter,
+    Count   // Number of node kinds, not a node
+};
+
+// Returns the kind of f
+NodeKind kindOf(const Function& f);
+
+// Returns the display name of a kind (e.g. "Sine")
+const char* kindName(NodeKind kind);
+
+// Number of children of a kind (0, 1 or 2)
+int childCount(NodeKind kind);
+
+// Borrowed child i of f, see the numbering above
+const std::shared_ptr<Function>& childOf(const Function& f, int i);
+
+// Constant value, Parameter value or Polynomial exponent, 0 for every other kind
+double payloadOf(const Function& f);
+
+// Name of a Variable or Parameter, throws std::runtime_error for every other kind
+const std::string& nameOf(const Function& f);
+
+/**
+ * Builds a node of the given kind from its children
+ *
+ * Precondition: kind is not Variable or Parameter, the number of non-null children matches childCount(kind)
+ * Postcondition: makeNode(kindOf(f), childOf(f, 0), childOf(f, 1), payloadOf(f)) is equal to f
+ */
+std::shared_ptr<Function> makeNode(NodeKind kind, std::shared_ptr<Function> a, std::shared_ptr<Function> b, double payload);
+
+/**
+ * Applies the evaluation kernel of a kind to already evaluated children, in any scalar type of
+ * scalarMath.h
+ *
+ * Precondition: a and b are the values of children 0 and 1 (a = x for Variable)
+ * Postcondition: returns the same value as evaluate() on a node of that kind (for T = double)
+ */
+template<class T> T evaluateKind(NodeKind kind, T a, T b, T payload);
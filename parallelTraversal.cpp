@@ -0,0 +1,283 @@
+#include "parallelTraversal.h"
+#include "traversal.h"
+
+#include <cstring>
+#include <typeinfo>
+#include <exception>
+
+/*
+    Work-stealing pool
+*/
+
+namespace {
+
+// The pool and queue of the current thread, if it is a worker
+struct WorkerSlot {
+    const void* pool = nullptr;
+    size_t index = 0;
+};
+
+thread_local WorkerSlot currentWorker;
+
+}
+
+TaskPool::TaskPool(unsigned threads){
+    for(unsigned i = 0; i <= threads; i++) queues.push_back(std::make_unique<Queue>());
+    for(unsigned i = 0; i < threads; i++) workers.emplace_back(&TaskPool::work, this, i);
+}
+
+TaskPool::~TaskPool(){
+    {
+        std::lock_guard<std::mutex> guard(idleLock);
+        stopping = true;
+    }
+    idle.notify_all();
+    for(std::thread& worker : workers) worker.join();
+}
+
+TaskPool::Queue& TaskPool::ownQueue(){
+    return currentWorker.pool == this ? *queues[currentWorker.index] : *queues.back();
+}
+
+void TaskPool::push(std::function<void()> task){
+    Queue& queue = ownQueue();
+    {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.tasks.push_back(std::move(task));
+    }
+    queued++;
+    {
+        // Taken so a worker between checking queued and sleeping does not miss the notification
+        std::lock_guard<std::mutex> guard(idleLock);
+    }
+    idle.notify_one();
+}
+
+// Runs the newest task of this thread's queue, or else the oldest task of another queue
+bool TaskPool::runOne(){
+    std::function<void()> task;
+    Queue& own = ownQueue();
+    {
+        std::lock_guard<std::mutex> guard(own.lock);
+        if(!own.tasks.empty()){
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+    // Victims are tried starting after this thread's own queue, so thieves spread out
+    size_t start = currentWorker.pool == this ? currentWorker.index + 1 : 0;
+    for(size_t i = 0; !task && i < queues.size(); i++){
+        Queue& victim = *queues[(start + i) % queues.size()];
+        if(&victim == &own) continue;
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if(!victim.tasks.empty()){
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+    if(!task) return false;
+    queued--;
+    task();
+    return true;
+}
+
+void TaskPool::work(size_t index){
+    currentWorker = {this, index};
+    while(true){
+        if(runOne()) continue;
+        std::unique_lock<std::mutex> guard(idleLock);
+        idle.wait(guard, [this]{ return stopping || queued > 0; });
+        if(stopping) return;
+    }
+}
+
+void TaskPool::forkJoin(const std::function<void()>& first, std::function<void()> second){
+    struct Join {
+        std::atomic<bool> done{false};
+        std::exception_ptr error;
+    } join;
+    push([&join, task = std::move(second)]{
+        try{
+            task();
+        }
+        catch(...){
+            join.error = std::current_exception();
+        }
+        join.done.store(true, std::memory_order_release);
+    });
+
+    std::exception_ptr firstError;
+    try{
+        first();
+    }
+    catch(...){
+        firstError = std::current_exception();
+    }
+    // second is usually still at the back of this thread's queue and runs here; if it was stolen,
+    // other work is done while waiting
+    while(!join.done.load(std::memory_order_acquire)){
+        if(!runOne()) std::this_thread::yield();
+    }
+    if(firstError) std::rethrow_exception(firstError);
+    if(join.error) std::rethrow_exception(join.error);
+}
+
+/*
+    Interning
+*/
+
+static uint64_t bitsOf(double value){
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+size_t InternTable::KeyHash::operator()(const Key& key) const{
+    uint64_t hash = static_cast<uint64_t>(key.kind);
+    hash = hash * 0x9E3779B97F4A7C15ull ^ reinterpret_cast<uintptr_t>(key.a);
+    hash = hash * 0x9E3779B97F4A7C15ull ^ reinterpret_cast<uintptr_t>(key.b);
+    hash = hash * 0x9E3779B97F4A7C15ull ^ key.payload;
+    return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+std::shared_ptr<Function> InternTable::intern(const std::shared_ptr<Function>& f){
+    NodeKind kind = kindOf(*f);
+    int children = childCount(kind);
+    return intern(f, kind, children > 0 ? childOf(*f, 0) : nullptr, children > 1 ? childOf(*f, 1) : nullptr);
+}
+
+std::shared_ptr<Function> InternTable::intern(const std::shared_ptr<Function>& f, NodeKind kind,
+    const std::shared_ptr<Function>& a, const std::shared_ptr<Function>& b){
+    Key key{kind, a.get(), b.get(), 0};
+    if(kind == NodeKind::Variable || kind == NodeKind::Parameter){
+        key.a = f.get();
+    }
+    else if(kind == NodeKind::Constant || kind == NodeKind::Polynomial){
+        key.payload = bitsOf(payloadOf(*f));
+    }
+
+    Shard& shard = shards[KeyHash()(key) % SHARDS];
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto found = shard.nodes.find(key);
+        if(found != shard.nodes.end()) return found->second;
+    }
+    int children = childCount(kind);
+    bool same = children == 0 || (childOf(*f, 0) == a && (children < 2 || childOf(*f, 1) == b));
+    std::shared_ptr<Function> node = same ? f : makeNode(kind, a, b, payloadOf(*f));
+    // Another task may have added the same node meanwhile, the first one wins
+    std::lock_guard<std::mutex> guard(shard.lock);
+    return shard.nodes.emplace(key, std::move(node)).first->second;
+}
+
+size_t InternTable::size(){
+    size_t total = 0;
+    for(Shard& shard : shards){
+        std::lock_guard<std::mutex> guard(shard.lock);
+        total += shard.nodes.size();
+    }
+    return total;
+}
+
+/*
+    Walks
+    Post-order over the tree, the result of a node made by finish() from those of its children.
+    Above the grain the second child is forked; below it, or once the forks nest deeper than the
+    call stack allows, the subtree is walked in one task with an explicit stack.
+*/
+
+namespace {
+
+// The node a lazy Derivative builds, or f itself
+const std::shared_ptr<Function>& resolved(const std::shared_ptr<Function>& f){
+    const std::shared_ptr<Function>* node = &f;
+    while(typeid(**node) == typeid(Derivative)) node = &static_cast<const Derivative&>(**node).materialize();
+    return *node;
+}
+
+using Finish = std::function<std::shared_ptr<Function>(const std::shared_ptr<Function>& node, NodeKind kind,
+    std::shared_ptr<Function> a, std::shared_ptr<Function> b)>;
+
+class ParallelWalk {
+    TaskPool& pool;
+    size_t grain;
+    Finish finish;
+
+    // Results of the forked nodes, so a subtree reached twice above the grain is walked once
+    std::mutex resultsLock;
+    std::unordered_map<const Function*, std::shared_ptr<Function>> results;
+
+    std::shared_ptr<Function> runSequential(const std::shared_ptr<Function>& root){
+        struct Frame {
+            const std::shared_ptr<Function>* node;
+            NodeKind kind;
+            int next;
+        };
+        std::unordered_map<const Function*, std::shared_ptr<Function>> done;
+        std::vector<Frame> frames{{&root, kindOf(*root), 0}};
+        while(!frames.empty()){
+            Frame& frame = frames.back();
+            int children = childCount(frame.kind);
+            if(frame.next < children){
+                const std::shared_ptr<Function>& child = childOf(**frame.node, frame.next++);
+                if(!done.count(child.get())) frames.push_back({&child, kindOf(*child), 0});
+                continue;
+            }
+            std::shared_ptr<Function> a = children > 0 ? done.at(childOf(**frame.node, 0).get()) : nullptr;
+            std::shared_ptr<Function> b = children > 1 ? done.at(childOf(**frame.node, 1).get()) : nullptr;
+            done.emplace(frame.node->get(), finish(*frame.node, frame.kind, std::move(a), std::move(b)));
+            frames.pop_back();
+        }
+        return done.at(root.get());
+    }
+
+    public:
+    ParallelWalk(TaskPool& taskPool, size_t grainSize, Finish finishNode)
+        : pool(taskPool), grain(grainSize), finish(std::move(finishNode)) {}
+
+    std::shared_ptr<Function> run(const std::shared_ptr<Function>& node, uint32_t level){
+        {
+            std::lock_guard<std::mutex> guard(resultsLock);
+            auto found = results.find(node.get());
+            if(found != results.end()) return found->second;
+        }
+        NodeKind kind = kindOf(*node);
+        int children = childCount(kind);
+        if(children == 0 || node->complexity().nodes < grain || level >= DEEP_TREE_DEPTH) return runSequential(node);
+
+        std::shared_ptr<Function> a, b;
+        if(children == 2){
+            pool.forkJoin([&]{ a = run(childOf(*node, 0), level + 1); }, [&]{ b = run(childOf(*node, 1), level + 1); });
+        }
+        else{
+            a = run(childOf(*node, 0), level + 1);
+        }
+        std::shared_ptr<Function> result = finish(node, kind, std::move(a), std::move(b));
+        std::lock_guard<std::mutex> guard(resultsLock);
+        return results.emplace(node.get(), std::move(result)).first->second;
+    }
+};
+
+}
+
+std::shared_ptr<Function> parallelDerivative(const std::shared_ptr<Function>& f, TaskPool& pool, size_t grain, InternTable* table){
+    InternTable local;
+    InternTable& interned = table ? *table : local;
+    // Looking through a lazy node builds it, so the walk is where the derivative is built
+    ParallelWalk walk(pool, grain, [&interned](const std::shared_ptr<Function>& node, NodeKind kind,
+        std::shared_ptr<Function> a, std::shared_ptr<Function> b){
+        return interned.intern(resolved(node), kind, a, b);
+    });
+    return walk.run(f->derivative(), 0);
+}
+
+std::shared_ptr<Function> parallelSimplify(const std::shared_ptr<Function>& f, TaskPool& pool, size_t grain, InternTable* table){
+    InternTable local;
+    InternTable& interned = table ? *table : local;
+    ParallelWalk walk(pool, grain, [&interned](const std::shared_ptr<Function>& node, NodeKind kind,
+        std::shared_ptr<Function> a, std::shared_ptr<Function> b){
+        std::shared_ptr<Function> result = childCount(kind) == 0 ? node->simplify() : node->simplifyNode(std::move(a), std::move(b));
+        return interned.intern(result);
+    });
+    return walk.run(f, 0);
+}
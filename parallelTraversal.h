@@ -0,0 +1,142 @@
+#pragma once
+
+#include <mutex>
+#include <algorithm>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+#include "nodeKind.h"
+
+/*
+    Task-parallel traversals
+    derivative() and simplify() handle the two children of a node one after the other, so one giant
+    expression keeps a single core busy. parallelDerivative() and parallelSimplify() walk the tree
+    post-order and fork the second child of every node whose tree has at least `grain` nodes onto a
+    work-stealing TaskPool; smaller subtrees are done in one task without forking.
+    Every result goes through an InternTable, so a subtree reached from several places is built
+    once and equal nodes built by different tasks end up as one shared node.
+*/
+
+// Subtrees smaller than this (Complexity::nodes) are not split into tasks
+const size_t PARALLEL_GRAIN = 4096;
+
+/*
+    Work-stealing pool
+    Every worker owns a deque of tasks: it pushes and pops its own work at the back and, when that
+    is empty, steals the oldest (largest) task from the front of another deque. Threads outside the
+    pool share one extra deque. A thread waiting in forkJoin() runs queued tasks instead of
+    blocking, so nested forks never deadlock.
+*/
+class TaskPool {
+    struct Queue {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;     // One per worker, the last one for outside threads
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued{0};
+    std::atomic<bool> stopping{false};
+    std::mutex idleLock;
+    std::condition_variable idle;
+
+    Queue& ownQueue();
+    void push(std::function<void()> task);
+    bool runOne();
+    void work(size_t index);
+
+    public:
+    explicit TaskPool(unsigned threads = std::max(1u, std::thread::hardware_concurrency()));
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    unsigned size() const { return workers.size(); }
+
+    /**
+     * Runs first on this thread and second on any thread of the pool, and returns once both are done
+     *
+     * Precondition: None
+     * Postcondition: both have run; if either threw, the exception is rethrown here (that of
+     *                first if both threw)
+     */
+    void forkJoin(const std::function<void()>& first, std::function<void()> second);
+};
+
+/*
+    Concurrent interning table
+    Maps (kind, children, payload) to the one node with that shape, so structurally equal subtrees
+    built from interned children are the same pointer. Variables and Parameters are interned by
+    identity, Constants by value. The table is split into shards with a lock each.
+*/
+class InternTable {
+    struct Key {
+        NodeKind kind;
+        const Function* a;
+        const Function* b;
+        uint64_t payload;
+
+        bool operator==(const Key& other) const{
+            return kind == other.kind && a == other.a && b == other.b && payload == other.payload;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Shard {
+        std::mutex lock;
+        std::unordered_map<Key, std::shared_ptr<Function>, KeyHash> nodes;
+    };
+
+    static const size_t SHARDS = 64;
+    Shard shards[SHARDS];
+
+    public:
+    /**
+     * Returns the interned node with the kind, children and payload of f (f itself the first time)
+     *
+     * Precondition: f is not null
+     * Postcondition: calls with equal nodes whose children are interned return the same pointer,
+     *                on any thread
+     */
+    std::shared_ptr<Function> intern(const std::shared_ptr<Function>& f);
+
+    /**
+     * Interned node of the given kind built from interned children, f when those are its children
+     *
+     * Precondition: f is of that kind; a and b are interned (null where the kind has no such child)
+     * Postcondition: as intern(makeNode(kind, a, b, payloadOf(f))), without building when possible
+     */
+    std::shared_ptr<Function> intern(const std::shared_ptr<Function>& f, NodeKind kind,
+        const std::shared_ptr<Function>& a, const std::shared_ptr<Function>& b);
+
+    // Number of distinct nodes
+    size_t size();
+};
+
+/**
+ * Builds the derivative of f completely, splitting large subtrees over the pool
+ *
+ * Precondition: f is not null
+ * Postcondition: prints and evaluates as f->derivative(), contains no lazy nodes and equal
+ *                subtrees are shared. Uses a table of its own unless one is given
+ */
+std::shared_ptr<Function> parallelDerivative(const std::shared_ptr<Function>& f, TaskPool& pool,
+    size_t grain = PARALLEL_GRAIN, InternTable* table = nullptr);
+
+/**
+ * Simplifies f with the rules of every class (Function::simplifyNode), splitting large subtrees
+ * over the pool
+ *
+ * Precondition: f is not null
+ * Postcondition: prints as f->simplify(), equal subtrees of the result are shared
+ */
+std::shared_ptr<Function> parallelSimplify(const std::shared_ptr<Function>& f, TaskPool& pool,
+    size_t grain = PARALLEL_GRAIN, InternTable* table = nullptr);
@@ -0,0 +1,183 @@
+#include "parameters.h"
+#include "printer.h"
+#include "instrumentation.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// Parameter table
+
+size_t ParameterTable::define(const std::string& name, double value){
+    auto found = slots.find(name);
+    if(found != slots.end()){
+        set(found->second, value);
+        return found->second;
+    }
+    size_t slot = values.size();
+    names.push_back(name);
+    values.push_back(value);
+    versions.push_back(0);
+    slots.emplace(name, slot);
+    return slot;
+}
+
+bool ParameterTable::contains(const std::string& name) const{
+    return slots.count(name) > 0;
+}
+
+size_t ParameterTable::slotOf(const std::string& name) const{
+    auto found = slots.find(name);
+    if(found == slots.end()){
+        throw std::runtime_error("Error parameter \"" + name + "\" is not defined");
+    }
+    return found->second;
+}
+
+void ParameterTable::set(size_t slot, double value){
+    if(slot >= values.size()) throw std::out_of_range("Error parameter slot out of range");
+    if(values[slot] == value) return;
+    values[slot] = value;
+    versions[slot]++;
+}
+
+void ParameterTable::set(const std::string& name, double value){
+    set(slotOf(name), value);
+}
+
+// Parameter
+
+const std::shared_ptr<ParameterTable>& Parameter::getTable() const{
+    return table;
+}
+
+size_t Parameter::getSlot() const{
+    return slot;
+}
+
+const std::string& Parameter::getName() const{
+    return table->name(slot);
+}
+
+double Parameter::getValue() const{
+    return table->value(slot);
+}
+
+double Parameter::evaluate(double) const{
+    CALC_PROBE(Evaluate, Parameter);
+    return table->value(slot);
+}
+
+Interval Parameter::evaluateInterval(const Interval&) const{
+    return Interval{table->value(slot), table->value(slot)};
+}
+
+std::shared_ptr<Function> Parameter::derivative() const{
+    CALC_PROBE(Derivative, Parameter);
+    return Constant::zero();
+}
+
+std::shared_ptr<Function> Parameter::simplify() const{
+    CALC_PROBE(Simplify, Parameter);
+    return std::make_shared<Parameter>(table, getName());
+}
+
+bool Parameter::isEqual(const std::shared_ptr<Function>& other) const{
+    auto otherParameter = dynamic_cast<Parameter*>(other.get());
+    if(!otherParameter) return false;
+    return table == otherParameter->table && slot == otherParameter->slot;
+}
+
+std::string Parameter::display() const{
+    return toString(*this);
+}
+
+/*
+    Incremental evaluator
+*/
+
+ParametricEvaluator::ParametricEvaluator(const Function& f, std::shared_ptr<ParameterTable> parameters, std::vector<double> xs)
+    : table(std::move(parameters)), points(std::move(xs)){
+    std::unordered_map<const Function*, uint32_t> added;
+    addNode(f, added);
+}
+
+// Adds the children of f first, so children always come before their parents
+uint32_t ParametricEvaluator::addNode(const Function& f, std::unordered_map<const Function*, uint32_t>& added){
+    auto found = added.find(&f);
+    if(found != added.end()) return found->second;
+
+    Node node;
+    node.kind = kindOf(f);
+    node.child[0] = node.child[1] = 0;
+    node.payload = payloadOf(f);
+    node.slot = 0;
+    node.dependsOnX = node.kind == NodeKind::Variable;
+
+    if(node.kind == NodeKind::Parameter){
+        // kindOf looks through lazy derivatives, a parameter is always the node itself
+        const Parameter& parameter = static_cast<const Parameter&>(f);
+        if(parameter.getTable() != table){
+            throw std::runtime_error("Error parameter \"" + parameter.getName() + "\" belongs to another table");
+        }
+        node.slot = parameter.getSlot();
+        node.parameters.push_back(node.slot);
+    }
+    for(int i = 0; i < childCount(node.kind); i++){
+        node.child[i] = addNode(*childOf(f, i), added);
+        const Node& child = nodes[node.child[i]];
+        node.dependsOnX = node.dependsOnX || child.dependsOnX;
+
+        std::vector<size_t> merged;
+        std::set_union(node.parameters.begin(), node.parameters.end(),
+            child.parameters.begin(), child.parameters.end(), std::back_inserter(merged));
+        node.parameters = std::move(merged);
+    }
+
+    uint32_t index = nodes.size();
+    nodes.push_back(std::move(node));
+    added.emplace(&f, index);
+    return index;
+}
+
+const std::vector<double>& ParametricEvaluator::evaluate(){
+    TraceSpan span("evaluateParametric", "points", points.size());
+    std::vector<bool> dirty(table->size());
+    seen.resize(table->size(), 0);
+    for(size_t slot = 0; slot < table->size(); slot++){
+        dirty[slot] = table->version(slot) != seen[slot];
+        seen[slot] = table->version(slot);
+    }
+
+    recomputed = 0;
+    for(Node& node : nodes){
+        if(node.valid && std::none_of(node.parameters.begin(), node.parameters.end(),
+                [&](size_t slot){ return dirty[slot]; })){
+            CALC_CACHE_ACCESS(ParametricNode, true);
+            continue;
+        }
+
+        const std::vector<double>* a = childCount(node.kind) > 0 ? &nodes[node.child[0]].values : nullptr;
+        const std::vector<double>* b = childCount(node.kind) > 1 ? &nodes[node.child[1]].values : nullptr;
+        double payload = node.kind == NodeKind::Parameter ? table->value(node.slot) : node.payload;
+
+        size_t count = node.dependsOnX ? points.size() : 1;
+        node.values.resize(count);
+        for(size_t i = 0; i < count; i++){
+            // Children that do not depend on x have a single value
+            double left = node.kind == NodeKind::Variable ? points[i] : a ? (*a)[a->size() > 1 ? i : 0] : 0.0;
+            double right = b ? (*b)[b->size() > 1 ? i : 0] : 0.0;
+            node.values[i] = evaluateKind(node.kind, left, right, payload);
+        }
+        node.valid = true;
+        recomputed++;
+        CALC_CACHE_ACCESS(ParametricNode, false);
+    }
+
+    const std::vector<double>& root = nodes.back().values;
+    results.resize(points.size());
+    for(size_t i = 0; i < points.size(); i++){
+        results[i] = root[root.size() > 1 ? i : 0];
+    }
+    return results;
+}
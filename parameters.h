@@ -0,0 +1,133 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include "nodeKind.h"
+
+/*
+    Named parameters
+    A Parameter is a leaf like Constant, but its value lives in a ParameterTable and can be changed
+    after the tree is built. Its derivative with respect to x is 0, so f'(x) is built once and stays
+    symbolic in every parameter: sweeping a parameter only rebinds it, nothing is rebuilt.
+    Tables are not thread safe, share one between threads only while nobody rebinds it.
+*/
+
+// Binding table: one value and one version counter per parameter name
+class ParameterTable {
+    std::vector<std::string> names;
+    std::vector<double> values;
+    std::vector<uint64_t> versions;     // Bumped every time the value changes
+    std::unordered_map<std::string, size_t> slots;
+
+    public:
+    /**
+     * Adds a parameter, or rebinds it if the name is already defined
+     *
+     * Precondition: None
+     * Postcondition: value(slotOf(name)) = value, returns slotOf(name)
+     */
+    size_t define(const std::string& name, double value = 0.0);
+
+    bool contains(const std::string& name) const;
+
+    // Slot of a defined name, throws std::runtime_error if the name is not defined
+    size_t slotOf(const std::string& name) const;
+
+    /**
+     * Rebinds a parameter. Setting the value it already has changes nothing
+     *
+     * Precondition: slot < size() (or name is defined)
+     * Postcondition: value(slot) = value, version(slot) is bumped if the value changed
+     */
+    void set(size_t slot, double value);
+    void set(const std::string& name, double value);
+
+    double value(size_t slot) const { return values[slot]; }
+    uint64_t version(size_t slot) const { return versions[slot]; }
+    const std::string& name(size_t slot) const { return names[slot]; }
+    size_t size() const { return values.size(); }
+};
+
+// Class for parameters f(x) = a, where a is looked up in a binding table
+class Parameter : public Function {
+    std::shared_ptr<ParameterTable> table;
+    size_t slot;
+    public:
+    // Throws std::runtime_error if name is not defined in the table
+    Parameter(std::shared_ptr<ParameterTable> parameters, const std::string& name)
+        : table(std::move(parameters)), slot(table->slotOf(name)) {}
+
+    const std::shared_ptr<ParameterTable>& getTable() const;
+    size_t getSlot() const;
+    const std::string& getName() const;
+    double getValue() const;
+
+    double evaluate(double x) const override;
+
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
+    // (a)' = 0, parameters do not depend on x
+    std::shared_ptr<Function> derivative() const override;
+
+    std::shared_ptr<Function> simplify() const override;
+
+    bool isEqual(const std::shared_ptr<Function>& other) const override;
+
+    std::string display() const override;
+};
+
+/*
+    Incremental evaluation over a fixed grid of x values
+    The tree is flattened once (shared subtrees are kept shared). Every node keeps its values at
+    every grid point, along with the set of parameters it depends on. After some parameters are
+    rebound, evaluate() recomputes only the nodes that depend on them and reuses the rest.
+    Nodes that do not depend on x keep a single value instead of one per grid point.
+*/
+class ParametricEvaluator {
+    struct Node {
+        NodeKind kind;
+        uint32_t child[2];
+        double payload;                     // Constant value or Polynomial exponent
+        size_t slot;                        // Parameter slot
+        bool dependsOnX;
+        bool valid = false;
+        std::vector<size_t> parameters;     // Sorted slots of every parameter below this node
+        std::vector<double> values;         // One per grid point, or one if !dependsOnX
+    };
+
+    std::shared_ptr<ParameterTable> table;
+    std::vector<double> points;
+    std::vector<Node> nodes;                // Children before parents, the root is last
+    std::vector<uint64_t> seen;             // Version of every slot at the last evaluate()
+    std::vector<double> results;
+    size_t recomputed = 0;
+
+    uint32_t addNode(const Function& f, std::unordered_map<const Function*, uint32_t>& added);
+
+    public:
+    /**
+     * Flattens f for evaluation at every point of xs
+     *
+     * Precondition: every Parameter in f is bound in parameters
+     * Postcondition: nothing is evaluated until evaluate() is called
+     */
+    ParametricEvaluator(const Function& f, std::shared_ptr<ParameterTable> parameters, std::vector<double> xs);
+
+    /**
+     * Evaluates f at every grid point with the current parameter values
+     *
+     * Precondition: None
+     * Postcondition: returns f(xs[i]) for every i, only nodes depending on a parameter rebound
+     *                since the last call are recomputed (every node on the first call)
+     */
+    const std::vector<double>& evaluate();
+
+    // Number of nodes recomputed by the last evaluate()
+    size_t lastRecomputed() const { return recomputed; }
+    size_t nodeCount() const { return nodes.size(); }
+    const std::vector<double>& getPoints() const { return points; }
+};
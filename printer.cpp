@@ -0,0 +1,397 @@
+#include "printer.h"
+#include "flatExpression.h"
+
+#include <cmath>
+#include <vector>
+#include <charconv>
+#include <initializer_list>
+
+void appendNumber(std::string& buffer, double value){
+    char text[32];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    buffer.append(text, result.ptr);
+}
+
+/*
+    Operator precedence, a child is parenthesized when it binds looser than its position allows
+*/
+
+enum Precedence {
+    SUM = 1,            // + -
+    PRODUCT = 2,        // * /
+    NEGATIVE = 3,       // A negative number, the parser reads its sign as a unary minus
+    POWER = 4,          // ^ (right associative)
+    FRACTION = 5,       // \frac{}{} in LaTeX
+    ATOM = 6            // Numbers, names, function calls
+};
+
+static const double E = std::exp(1.0);
+static const double PI = std::acos(-1.0);
+
+// Names of the trigonometric and hyperbolic kinds, from Sine to CotangentH
+static const char* const functionNames[] = {
+    "sin", "cos", "tan", "sec", "csc", "cot",
+    "arcsin", "arccos", "arctan", "arccot", "arcsec", "arccsc",
+    "sinh", "cosh", "tanh", "sech", "csch", "coth"
+};
+
+static const char* const latexNames[] = {
+    "\\sin", "\\cos", "\\tan", "\\sec", "\\csc", "\\cot",
+    "\\arcsin", "\\arccos", "\\arctan", "\\operatorname{arccot}", "\\operatorname{arcsec}", "\\operatorname{arccsc}",
+    "\\sinh", "\\cosh", "\\tanh", "\\operatorname{sech}", "\\operatorname{csch}", "\\coth"
+};
+
+static const char* functionName(NodeKind kind, PrintFormat format){
+    size_t index = size_t(kind) - size_t(NodeKind::Sine);
+    return format == PrintFormat::Latex ? latexNames[index] : functionNames[index];
+}
+
+namespace {
+
+// Node access of a Function tree, lazy derivatives are looked through
+struct FunctionTree {
+    using Node = const Function*;
+    NodeKind kind(Node f) const { return kindOf(*f); }
+    Node child(Node f, int i) const { return childOf(*f, i).get(); }
+    double payload(Node f) const { return payloadOf(*f); }
+    const std::string& name(Node f) const { return nameOf(*f); }
+};
+
+// Node access of a flat expression, nodes are indices
+struct FlatTree {
+    using Node = uint32_t;
+    const FlatExpression& expression;
+    NodeKind kind(Node f) const { return expression.kind(f); }
+    Node child(Node f, int i) const { return expression.child(f, i); }
+    double payload(Node f) const { return expression.payload(f); }
+    const std::string& name(Node f) const { return expression.name(f); }
+};
+
+// Tree provides the Node handle type and kind, child, payload and name of a node
+// The tree is walked with an explicit stack of steps, so its depth is not limited by the call stack
+template <typename Tree>
+class Printer {
+    using Node = typename Tree::Node;
+
+    struct Step {
+        enum Action : unsigned char {
+            Write,          // Writes node
+            Operand,        // Writes node, in parentheses if it binds looser than required
+            Text,           // Appends text
+            Number,         // Appends value
+            CloseAbs        // Closes the |...| opened at start
+        };
+        Action action;
+        Node node;
+        int required;
+        const char* text;
+        double value;
+        size_t start;
+    };
+
+    const Tree& tree;
+    std::string& out;
+    PrintFormat format;
+    std::vector<Step>& steps;
+
+    static Step write(Node f){ return {Step::Write, f, 0, nullptr, 0.0, 0}; }
+    static Step operand(Node f, int required){ return {Step::Operand, f, required, nullptr, 0.0, 0}; }
+    static Step text(const char* t){ return {Step::Text, Node(), 0, t, 0.0, 0}; }
+    static Step number(double value){ return {Step::Number, Node(), 0, nullptr, value, 0}; }
+    static Step closeAbs(size_t start){ return {Step::CloseAbs, Node(), 0, nullptr, 0.0, start}; }
+
+    // Runs the given steps next, in order
+    void then(std::initializer_list<Step> next){
+        for(auto step = next.end(); step != next.begin();) steps.push_back(*--step);
+    }
+
+    bool isConstant(Node f, double value) const{
+        return tree.kind(f) == NodeKind::Constant && tree.payload(f) == value;
+    }
+
+    int precedence(Node f, NodeKind kind) const{
+        switch(kind){
+            case NodeKind::Sum:
+            case NodeKind::Difference:
+                return SUM;
+            case NodeKind::Product:
+                return PRODUCT;
+            case NodeKind::Quotient:
+                return format == PrintFormat::Latex ? FRACTION : PRODUCT;
+            case NodeKind::Polynomial:
+                return tree.payload(f) == 0.5 ? ATOM : POWER;
+            case NodeKind::Exponential:
+                return POWER;
+            case NodeKind::Constant:
+                return std::signbit(tree.payload(f)) ? NEGATIVE : ATOM;
+            default:
+                return ATOM;
+        }
+    }
+
+    void constant(double value){
+        if(value == E){
+            out += 'e';
+        }
+        else if(value == PI){
+            out += format == PrintFormat::Latex ? "\\pi" : "pi";
+        }
+        else if(format == PrintFormat::Latex){
+            // 1e-05 as 1 \cdot 10^{-5}
+            size_t start = out.size();
+            appendNumber(out, value);
+            size_t exponent = out.find('e', start);
+            if(exponent == std::string::npos) return;
+            std::string power = out.substr(exponent + 1);
+            out.resize(exponent);
+            out += " \\cdot 10^{";
+            size_t digits = power[0] == '+' || power[0] == '-' ? 1 : 0;
+            if(power[0] == '-') out += '-';
+            while(digits + 1 < power.size() && power[digits] == '0') digits++;
+            out.append(power, digits, std::string::npos);
+            out += '}';
+        }
+        else{
+            appendNumber(out, value);
+        }
+    }
+
+    const char* open() const{
+        return format == PrintFormat::Latex ? "\\left(" : "(";
+    }
+
+    const char* close() const{
+        return format == PrintFormat::Latex ? "\\right)" : ")";
+    }
+
+    void binary(Node f, NodeKind kind, const char* symbol){
+        int p = precedence(f, kind);
+        // + - * / are left associative, so a right operand of the same precedence needs parentheses
+        then({operand(tree.child(f, 0), p), text(symbol), operand(tree.child(f, 1), p + 1)});
+    }
+
+    void infix(Node f, NodeKind kind){
+        switch(kind){
+            case NodeKind::Constant:
+                constant(tree.payload(f));
+                return;
+            case NodeKind::Variable:
+            case NodeKind::Parameter:
+                out += tree.name(f);
+                return;
+            case NodeKind::Sum: binary(f, kind, " + "); return;
+            case NodeKind::Difference: binary(f, kind, " - "); return;
+            case NodeKind::Product: binary(f, kind, " * "); return;
+            case NodeKind::Quotient: binary(f, kind, " / "); return;
+            case NodeKind::AbsVal:
+                // |...| unless the argument ends with a bar, which the parser would read as an opening one
+                then({write(tree.child(f, 0)), closeAbs(out.size())});
+                out += '|';
+                return;
+            case NodeKind::Polynomial: {
+                Node base = tree.child(f, 0);
+                double exponent = tree.payload(f);
+                if(exponent == 0.5){
+                    out += "sqrt(";
+                    then({write(base), text(")")});
+                    return;
+                }
+                then({operand(base, ATOM), text("^"), number(exponent)});
+                return;
+            }
+            case NodeKind::Exponential:
+                then({operand(tree.child(f, 0), ATOM), text("^"), operand(tree.child(f, 1), NEGATIVE)});
+                return;
+            case NodeKind::Logarithmic: {
+                Node base = tree.child(f, 0);
+                Node argument = tree.child(f, 1);
+                if(isConstant(base, E)){
+                    out += "ln(";
+                }
+                else if(isConstant(base, 10.0)){
+                    out += "log(";
+                }
+                else{
+                    out += "log_";
+                    NodeKind baseKind = tree.kind(base);
+                    bool named = baseKind == NodeKind::Constant || baseKind == NodeKind::Variable || baseKind == NodeKind::Parameter;
+                    if(named) then({write(base), text("("), write(argument), text(")")});
+                    else then({text(open()), write(base), text(close()), text("("), write(argument), text(")")});
+                    return;
+                }
+                then({write(argument), text(")")});
+                return;
+            }
+            default:
+                out += functionName(kind, format);
+                out += '(';
+                then({write(tree.child(f, 0)), text(")")});
+                return;
+        }
+    }
+
+    void latex(Node f, NodeKind kind){
+        switch(kind){
+            case NodeKind::Constant:
+                constant(tree.payload(f));
+                return;
+            case NodeKind::Variable:
+            case NodeKind::Parameter:
+                out += tree.name(f);
+                return;
+            case NodeKind::Sum: binary(f, kind, " + "); return;
+            case NodeKind::Difference: binary(f, kind, " - "); return;
+            case NodeKind::Product: binary(f, kind, " \\cdot "); return;
+            case NodeKind::Quotient:
+                out += "\\frac{";
+                then({write(tree.child(f, 0)), text("}{"), write(tree.child(f, 1)), text("}")});
+                return;
+            case NodeKind::AbsVal:
+                out += "\\left|";
+                then({write(tree.child(f, 0)), text("\\right|")});
+                return;
+            case NodeKind::Polynomial: {
+                Node base = tree.child(f, 0);
+                double exponent = tree.payload(f);
+                if(exponent == 0.5){
+                    out += "\\sqrt{";
+                    then({write(base), text("}")});
+                    return;
+                }
+                then({operand(base, ATOM), text("^{"), number(exponent), text("}")});
+                return;
+            }
+            case NodeKind::Exponential:
+                then({operand(tree.child(f, 0), ATOM), text("^{"), write(tree.child(f, 1)), text("}")});
+                return;
+            case NodeKind::Logarithmic: {
+                Node base = tree.child(f, 0);
+                if(isConstant(base, E)){
+                    out += "\\ln";
+                    then({text(open()), write(tree.child(f, 1)), text(close())});
+                }
+                else{
+                    out += "\\log_{";
+                    then({write(base), text("}"), text(open()), write(tree.child(f, 1)), text(close())});
+                }
+                return;
+            }
+            default:
+                out += functionName(kind, format);
+                then({text(open()), write(tree.child(f, 0)), text(close())});
+                return;
+        }
+    }
+
+    void sExpression(Node f, NodeKind kind){
+        const char* symbol = nullptr;
+        switch(kind){
+            case NodeKind::Constant:
+                appendNumber(out, tree.payload(f));
+                return;
+            case NodeKind::Variable:
+            case NodeKind::Parameter:
+                out += tree.name(f);
+                return;
+            case NodeKind::Polynomial:
+                out += "(^ ";
+                then({write(tree.child(f, 0)), text(" "), number(tree.payload(f)), text(")")});
+                return;
+            case NodeKind::Sum: symbol = "+"; break;
+            case NodeKind::Difference: symbol = "-"; break;
+            case NodeKind::Product: symbol = "*"; break;
+            case NodeKind::Quotient: symbol = "/"; break;
+            case NodeKind::Exponential: symbol = "^"; break;
+            case NodeKind::Logarithmic: symbol = "log"; break;
+            case NodeKind::AbsVal: symbol = "abs"; break;
+            default: symbol = functionName(kind, format); break;
+        }
+        out += '(';
+        out += symbol;
+        if(childCount(kind) == 2) then({text(" "), write(tree.child(f, 0)), text(" "), write(tree.child(f, 1)), text(")")});
+        else then({text(" "), write(tree.child(f, 0)), text(")")});
+    }
+
+    void writeNode(Node f, NodeKind kind){
+        switch(format){
+            case PrintFormat::Infix: infix(f, kind); return;
+            case PrintFormat::Latex: latex(f, kind); return;
+            case PrintFormat::SExpression: sExpression(f, kind); return;
+        }
+    }
+
+    public:
+    Printer(const Tree& t, std::string& buffer, PrintFormat f, std::vector<Step>& stack)
+        : tree(t), out(buffer), format(f), steps(stack) {}
+
+    // Steps are kept per thread and per tree type, printing never recurses into another print
+    static std::vector<Step>& stepBuffer(){
+        thread_local std::vector<Step> buffer;
+        buffer.clear();
+        return buffer;
+    }
+
+    void run(Node root){
+        steps.push_back(write(root));
+        while(!steps.empty()){
+            Step step = steps.back();
+            steps.pop_back();
+            switch(step.action){
+                case Step::Write:
+                    writeNode(step.node, tree.kind(step.node));
+                    break;
+                case Step::Operand: {
+                    NodeKind kind = tree.kind(step.node);
+                    if(precedence(step.node, kind) < step.required){
+                        out += open();
+                        then({write(step.node), text(close())});
+                    }
+                    else{
+                        writeNode(step.node, kind);
+                    }
+                    break;
+                }
+                case Step::Text:
+                    out += step.text;
+                    break;
+                case Step::Number:
+                    appendNumber(out, step.value);
+                    break;
+                case Step::CloseAbs:
+                    if(out.back() == '|'){
+                        out.replace(step.start, 1, "abs(");
+                        out += ')';
+                    }
+                    else{
+                        out += '|';
+                    }
+                    break;
+            }
+        }
+    }
+};
+
+}
+
+void print(const Function& f, std::string& buffer, PrintFormat format){
+    FunctionTree tree;
+    Printer<FunctionTree>(tree, buffer, format, Printer<FunctionTree>::stepBuffer()).run(&f);
+}
+
+void print(const Function& f, std::ostream& out, PrintFormat format){
+    thread_local std::string buffer;
+    buffer.clear();
+    print(f, buffer, format);
+    out.write(buffer.data(), buffer.size());
+}
+
+std::string toString(const Function& f, PrintFormat format){
+    std::string text;
+    print(f, text, format);
+    return text;
+}
+
+void print(const FlatExpression& f, std::string& buffer, PrintFormat format){
+    FlatTree tree{f};
+    Printer<FlatTree>(tree, buffer, format, Printer<FlatTree>::stepBuffer()).run(f.root());
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <ostream>
+#include "nodeKind.h"
+
+class FlatExpression;
+
+/*
+    Expression printer
+    Writes a whole tree in one pass into a single buffer, without building a string per node.
+    display() of every Function class uses the infix format.
+    Formats:
+        Infix        sin(x) * x^2 - 3 / (x + 1)     parentheses only where the parser (expressionSplit.h)
+                                                    needs them to rebuild the same tree
+        Latex        \sin\left(x\right) \cdot x^{2} - \frac{3}{x + 1}
+        SExpression  (- (* (sin x) (^ x 2)) (/ 3 (+ x 1)))
+    Numbers are written with the fewest digits that read back as the same double.
+    Logarithms whose base is not a number, e or a name print as log_(base)(argument), which the parser
+    does not accept.
+*/
+
+enum class PrintFormat : unsigned char {
+    Infix,
+    Latex,
+    SExpression
+};
+
+/**
+ * Appends f to buffer
+ *
+ * Precondition: None
+ * Postcondition: buffer = old buffer + text of f, allocates only when buffer has to grow
+ */
+void print(const Function& f, std::string& buffer, PrintFormat format = PrintFormat::Infix);
+
+// Appends a flat expression (flatExpression.h), in the same text as its Function tree
+void print(const FlatExpression& f, std::string& buffer, PrintFormat format = PrintFormat::Infix);
+
+// Writes f to out with a single write, reusing a per-thread buffer
+void print(const Function& f, std::ostream& out, PrintFormat format = PrintFormat::Infix);
+
+// Text of f in a new string
+std::string toString(const Function& f, PrintFormat format = PrintFormat::Infix);
+
+// Appends the shortest text that reads back as value (std::stod gives value again)
+void appendNumber(std::string& buffer, double value);
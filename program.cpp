@@ -0,0 +1,180 @@
+#include "program.h"
+#include "programBlocks.h"
+#include "parameters.h"
+#include "scalarMath.h"
+#include "tracing.h"
+
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <unordered_map>
+
+namespace {
+
+// Structural key of an instruction, equal keys compute equal values. A Parameter is keyed by the
+// table and slot it reads rather than by its current value, so distinct parameters are never merged
+struct InstructionKey {
+    NodeKind kind;
+    uint32_t a, b;
+    uint64_t payloadBits;
+    const ParameterTable* table;
+    size_t slot;
+
+    bool operator==(const InstructionKey& other) const{
+        return kind == other.kind && a == other.a && b == other.b && payloadBits == other.payloadBits
+            && table == other.table && slot == other.slot;
+    }
+};
+
+struct InstructionKeyHash {
+    size_t operator()(const InstructionKey& key) const{
+        uint64_t hash = static_cast<uint64_t>(key.kind);
+        hash = hash * 0x9E3779B97F4A7C15ull ^ key.a;
+        hash = hash * 0x9E3779B97F4A7C15ull ^ key.b;
+        hash = hash * 0x9E3779B97F4A7C15ull ^ key.payloadBits;
+        hash = hash * 0x9E3779B97F4A7C15ull ^ reinterpret_cast<uintptr_t>(key.table);
+        hash = hash * 0x9E3779B97F4A7C15ull ^ key.slot;
+        return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+};
+
+class ProgramBuilder {
+    Program& program;
+    std::unordered_map<InstructionKey, uint32_t, InstructionKeyHash> interned;
+    std::unordered_map<const Function*, uint32_t> visited;      // Shared subtrees are walked once
+
+    public:
+    explicit ProgramBuilder(Program& p) : program(p) {}
+
+    // Children are added before their parent, with an explicit stack so deep trees fit
+    uint32_t add(const Function& root){
+        struct Frame {
+            const Function* node;
+            NodeKind kind;
+            int next;
+        };
+        std::vector<Frame> frames;
+        if(!visited.count(&root)) frames.push_back({&root, kindOf(root), 0});
+        while(!frames.empty()){
+            Frame& frame = frames.back();
+            int children = childCount(frame.kind);
+            if(frame.next < children){
+                const Function* child = childOf(*frame.node, frame.next++).get();
+                if(!visited.count(child)) frames.push_back({child, kindOf(*child), 0});
+                continue;
+            }
+            visited.emplace(frame.node, intern(*frame.node, frame.kind));
+            frames.pop_back();
+        }
+        return visited.at(&root);
+    }
+
+    private:
+    // Instruction of f, whose children are already visited
+    uint32_t intern(const Function& f, NodeKind kind){
+        Instruction instruction = {kind, 0, 0, payloadOf(f)};
+        int children = childCount(instruction.kind);
+        if(children > 0) instruction.a = visited.at(childOf(f, 0).get());
+        if(children > 1) instruction.b = visited.at(childOf(f, 1).get());
+        if((instruction.kind == NodeKind::Sum || instruction.kind == NodeKind::Product) && instruction.b < instruction.a){
+            std::swap(instruction.a, instruction.b);
+        }
+
+        InstructionKey key = {instruction.kind, instruction.a, instruction.b, 0, nullptr, 0};
+        if(kind == NodeKind::Parameter){
+            const Parameter& parameter = static_cast<const Parameter&>(f);
+            key.table = parameter.getTable().get();
+            key.slot = parameter.getSlot();
+        }
+        else{
+            std::memcpy(&key.payloadBits, &instruction.payload, sizeof(double));
+        }
+        auto existing = interned.find(key);
+        if(existing != interned.end()) return existing->second;
+        uint32_t index = program.instructions.size();
+        program.instructions.push_back(instruction);
+        interned.emplace(key, index);
+        return index;
+    }
+};
+
+}
+
+std::vector<uint32_t> Program::useCounts() const{
+    std::vector<uint32_t> uses(instructions.size(), 0);
+    for(const Instruction& instruction : instructions){
+        int children = childCount(instruction.kind);
+        if(children > 0) uses[instruction.a]++;
+        if(children > 1) uses[instruction.b]++;
+    }
+    for(uint32_t output : outputs) uses[output]++;
+    return uses;
+}
+
+Program buildProgram(const std::vector<std::shared_ptr<Function>>& roots){
+    Program program;
+    ProgramBuilder builder(program);
+    for(const std::shared_ptr<Function>& root : roots){
+        program.outputs.push_back(builder.add(*root));
+    }
+    return program;
+}
+
+Program buildProgram(const Function& root){
+    Program program;
+    ProgramBuilder builder(program);
+    program.outputs.push_back(builder.add(root));
+    return program;
+}
+
+/*
+    Evaluation in any scalar type
+*/
+
+template<class T>
+T evaluateProgram(const Program& program, T x, size_t output){
+    thread_local std::vector<T> slots;
+    slots.resize(program.instructions.size());
+    for(uint32_t i = 0; i < program.instructions.size(); i++){
+        const Instruction& instruction = program.instructions[i];
+        int children = childCount(instruction.kind);
+        T a = instruction.kind == NodeKind::Variable ? x : children > 0 ? slots[instruction.a] : T(0);
+        T b = children > 1 ? slots[instruction.b] : T(0);
+        slots[i] = evaluateKind<T>(instruction.kind, a, b, T(instruction.payload));
+    }
+    return slots[program.outputs.at(output)];
+}
+
+template<class T>
+void evaluateProgram(const Program& program, const std::vector<T>& xs, std::vector<T>& out, size_t output){
+    uint32_t root = program.outputs.at(output);
+    out.resize(xs.size());
+    runBlocks(program, xs.data(), xs.size(), [&](const T* slots, size_t block, size_t start, size_t count){
+        std::copy(slots + root * block, slots + root * block + count, out.begin() + start);
+    });
+}
+
+template<class T>
+void evaluateOutputs(const Program& program, const std::vector<T>& xs, std::vector<T>& out){
+    size_t points = xs.size();
+    out.resize(program.outputs.size() * points);
+    runBlocks(program, xs.data(), xs.size(), [&](const T* slots, size_t block, size_t start, size_t count){
+        for(size_t j = 0; j < program.outputs.size(); j++){
+            const T* column = slots + program.outputs[j] * block;
+            std::copy(column, column + count, out.begin() + j * points + start);
+        }
+    });
+}
+
+void evaluateBatch(const std::vector<std::shared_ptr<Function>>& roots, const std::vector<double>& xs, std::vector<double>& values){
+    TraceSpan span("evaluateBatch", "points", xs.size());
+    evaluateOutputs(buildProgram(roots), xs, values);
+}
+
+#define CALC_INSTANTIATE_EVALUATE_PROGRAM(T) \
+    template T evaluateProgram<T>(const Program&, T, size_t); \
+    template void evaluateProgram<T>(const Program&, const std::vector<T>&, std::vector<T>&, size_t); \
+    template void evaluateOutputs<T>(const Program&, const std::vector<T>&, std::vector<T>&);
+
+CALC_FOR_EACH_SCALAR(CALC_INSTANTIATE_EVALUATE_PROGRAM)
+CALC_INSTANTIATE_EVALUATE_PROGRAM(std::complex<double>)
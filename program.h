@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "nodeKind.h"
+
+/*
+    Straight-line programs
+    One or more Function trees flattened into a single list of instructions in which every distinct
+    subexpression appears once (common subexpression elimination). An instruction only refers to
+    earlier instructions, so running the list in order evaluates every root.
+    Sum and Product operands are put in a canonical order so f + g and g + f share one instruction.
+    Parameters are merged only when they read the same slot of the same table. Every Variable is x,
+    as in evaluate().
+*/
+
+struct Instruction {
+    NodeKind kind;
+    uint32_t a;             // Instruction computing child 0
+    uint32_t b;             // Instruction computing child 1
+    double payload;         // Constant value, Parameter value or Polynomial exponent (see payloadOf)
+};
+
+struct Program {
+    std::vector<Instruction> instructions;
+    std::vector<uint32_t> outputs;          // Instruction computing each root, in the order given
+
+    // Number of instructions that use each instruction as an operand (outputs count as a use)
+    std::vector<uint32_t> useCounts() const;
+};
+
+/**
+ * Flattens the trees into one program, sharing every repeated subexpression
+ *
+ * Precondition: no root is null
+ * Postcondition: evaluating outputs[i] gives roots[i]->evaluate(x)
+ */
+Program buildProgram(const std::vector<std::shared_ptr<Function>>& roots);
+Program buildProgram(const Function& root);
+
+/**
+ * Evaluates one output of the program at x in the scalar type T (float, double, long double or
+ * __float128, see scalarMath.h, or std::complex<double> as evaluateComplex()), so one program is
+ * evaluated in any precision without rebuilding
+ *
+ * Precondition: output < program.outputs.size()
+ * Postcondition: for T = double, returns roots[output]->evaluate(x); Constants, bound Parameter
+ *                values and exponents are converted from double
+ */
+template<class T> T evaluateProgram(const Program& program, T x, size_t output = 0);
+
+// out[i] = evaluateProgram(program, xs[i], output). Points are run in blocks, one instruction over a
+// whole block at a time, so sums, differences and products vectorize (twice the lanes in float)
+template<class T> void evaluateProgram(const Program& program, const std::vector<T>& xs, std::vector<T>& out,
+    size_t output = 0);
+
+/**
+ * Evaluates every output of the program at every point of xs in one pass: each block of points
+ * runs the instruction list once, so subexpressions shared by several outputs are computed once
+ *
+ * Precondition: None
+ * Postcondition: out is column-major, out[j * xs.size() + i] = evaluateProgram(program, xs[i], j)
+ */
+template<class T> void evaluateOutputs(const Program& program, const std::vector<T>& xs, std::vector<T>& out);
+
+/**
+ * Evaluates several expressions (e.g. f and its derivatives, or a family of models) at the same
+ * points, compiled into one program with subexpressions shared across expressions
+ *
+ * Precondition: no root is null
+ * Postcondition: values is column-major, values[j * xs.size() + i] = roots[j]->evaluate(xs[i])
+ */
+void evaluateBatch(const std::vector<std::shared_ptr<Function>>& roots, const std::vector<double>& xs,
+    std::vector<double>& values);
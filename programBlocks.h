@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include "program.h"
+
+/*
+    Block evaluation of programs
+    The loop shared by evaluateProgram() and the evaluators built on a Program (fusion.h,
+    guardAnalysis.h): points are run in blocks, one instruction over a whole block at a time, with
+    slot i * block + j holding instruction i at point j of the block. Sums, differences and products
+    are plain loops so they vectorize; other instructions go through evaluateKind() unless the caller
+    computes them.
+*/
+
+// Points per block for a program of n instructions in T: up to 256, with the slots kept around 1 MB
+template<class T>
+size_t blockSize(size_t n){
+    return std::max<size_t>(1, std::min<size_t>(256, (size_t(1) << 20) / (sizeof(T) * std::max<size_t>(n, 1))));
+}
+
+/**
+ * Runs the program over xs[0, points) block by block
+ *
+ * Precondition: instead(i, instruction, a, b, start, count, result) either computes result[0, count)
+ *               from the operand slots a and b and returns true, or returns false to have it computed
+ *               normally; after(i, result, start, count) is called once instruction i is computed
+ * Postcondition: read(slots, block, start, count) is called with the slots of every block
+ */
+template<class T, class Instead, class After, class Read>
+void runBlocks(const Program& program, const T* xs, size_t points, Instead instead, After after, Read read){
+    size_t n = program.instructions.size();
+    size_t block = blockSize<T>(n);
+    thread_local std::vector<T> slots;
+    slots.resize(n * block);
+
+    for(size_t start = 0; start < points; start += block){
+        size_t count = std::min(block, points - start);
+        for(uint32_t i = 0; i < n; i++){
+            const Instruction& instruction = program.instructions[i];
+            T* result = &slots[i * block];
+            const T* a = &slots[instruction.a * block];
+            const T* b = &slots[instruction.b * block];
+            if(!instead(i, instruction, a, b, start, count, result)){
+                switch(instruction.kind){
+                    case NodeKind::Variable:
+                        std::copy(xs + start, xs + start + count, result);
+                        break;
+                    case NodeKind::Sum:
+                        for(size_t j = 0; j < count; j++) result[j] = a[j] + b[j];
+                        break;
+                    case NodeKind::Difference:
+                        for(size_t j = 0; j < count; j++) result[j] = a[j] - b[j];
+                        break;
+                    case NodeKind::Product:
+                        for(size_t j = 0; j < count; j++) result[j] = a[j] * b[j];
+                        break;
+                    default: {
+                        int children = childCount(instruction.kind);
+                        T payload = T(instruction.payload);
+                        for(size_t j = 0; j < count; j++){
+                            result[j] = evaluateKind<T>(instruction.kind, children > 0 ? a[j] : T(0), children > 1 ? b[j] : T(0), payload);
+                        }
+                    }
+                }
+            }
+            after(i, result, start, count);
+        }
+        read(slots.data(), block, start, count);
+    }
+}
+
+// runBlocks() computing every instruction normally
+template<class T, class Read>
+void runBlocks(const Program& program, const T* xs, size_t points, Read read){
+    runBlocks(program, xs, points,
+        [](uint32_t, const Instruction&, const T*, const T*, size_t, size_t, T*){ return false; },
+        [](uint32_t, T*, size_t, size_t){},
+        read);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include "Functions.h"
+#include "fastMath.h"
+
+#ifdef CALC_FLOAT128
+#if !defined(__SIZEOF_FLOAT128__)
+#error "CALC_FLOAT128 needs a compiler with __float128"
+#endif
+#include <quadmath.h>
+#endif
+
+/*
+    Scalar types
+    The kernels in evaluateKernels.h are templates over the scalar type and get their elementary
+    functions from ScalarMath<T>:
+        float           C math library, single precision (twice as many lanes per vector)
+        double          the accuracy tier of the calling thread (fastMath.h), as evaluate()
+        long double     C math library, extended precision
+        __float128      libquadmath, only when built with -DCALC_FLOAT128 (link with -lquadmath)
+    Values within epsilonOf<T>() of 0 and 1 are snapped as in evaluate(). EPSILON is the upper limit:
+    the tolerance scales down with the machine epsilon for types wider than double, so long double
+    and __float128 keep their extra digits near 0 and 1. It does not scale up for float, where it
+    would reach 5e-4 and wipe out values such as sin(1e-4).
+*/
+
+template<class T>
+struct ScalarMath {
+    static T abs(T a){ return std::abs(a); }
+    static T sin(T a){ return std::sin(a); }
+    static T cos(T a){ return std::cos(a); }
+    static T tan(T a){ return std::tan(a); }
+    static T exp(T a){ return std::exp(a); }
+    static T log(T a){ return std::log(a); }
+    static T pow(T base, T exponent){ return std::pow(base, exponent); }
+    static T sinh(T a){ return std::sinh(a); }
+    static T cosh(T a){ return std::cosh(a); }
+    static T tanh(T a){ return std::tanh(a); }
+    static T asin(T a){ return std::asin(a); }
+    static T acos(T a){ return std::acos(a); }
+    static T atan(T a){ return std::atan(a); }
+};
+
+template<>
+struct ScalarMath<double> {
+    static double abs(double a){ return std::abs(a); }
+    static double sin(double a){ return mathSin(a); }
+    static double cos(double a){ return mathCos(a); }
+    static double tan(double a){ return mathTan(a); }
+    static double exp(double a){ return mathExp(a); }
+    static double log(double a){ return mathLog(a); }
+    static double pow(double base, double exponent){ return mathPow(base, exponent); }
+    static double sinh(double a){ return mathSinh(a); }
+    static double cosh(double a){ return mathCosh(a); }
+    static double tanh(double a){ return mathTanh(a); }
+    static double asin(double a){ return std::asin(a); }
+    static double acos(double a){ return std::acos(a); }
+    static double atan(double a){ return std::atan(a); }
+};
+
+#ifdef CALC_FLOAT128
+template<>
+struct ScalarMath<__float128> {
+    static __float128 abs(__float128 a){ return fabsq(a); }
+    static __float128 sin(__float128 a){ return sinq(a); }
+    static __float128 cos(__float128 a){ return cosq(a); }
+    static __float128 tan(__float128 a){ return tanq(a); }
+    static __float128 exp(__float128 a){ return expq(a); }
+    static __float128 log(__float128 a){ return logq(a); }
+    static __float128 pow(__float128 base, __float128 exponent){ return powq(base, exponent); }
+    static __float128 sinh(__float128 a){ return sinhq(a); }
+    static __float128 cosh(__float128 a){ return coshq(a); }
+    static __float128 tanh(__float128 a){ return tanhq(a); }
+    static __float128 asin(__float128 a){ return asinq(a); }
+    static __float128 acos(__float128 a){ return acosq(a); }
+    static __float128 atan(__float128 a){ return atanq(a); }
+};
+#endif
+
+// Machine epsilon of T
+template<class T>
+T machineEpsilon(){
+    return std::numeric_limits<T>::epsilon();
+}
+
+#ifdef CALC_FLOAT128
+template<>
+inline __float128 machineEpsilon<__float128>(){
+    return FLT128_EPSILON;
+}
+#endif
+
+// Snapping tolerance of T: EPSILON scaled by the machine epsilon of T relative to double, at most EPSILON
+template<class T>
+T epsilonOf(){
+    T scaled = T(EPSILON) * (machineEpsilon<T>() / T(std::numeric_limits<double>::epsilon()));
+    return scaled < T(EPSILON) ? scaled : T(EPSILON);
+}
+
+// Expands f(T) for every scalar type the evaluators are instantiated for (explicit instantiations)
+#ifdef CALC_FLOAT128
+#define CALC_FOR_EACH_SCALAR(f) f(float) f(double) f(long double) f(__float128)
+#else
+#define CALC_FOR_EACH_SCALAR(f) f(float) f(double) f(long double)
+#endif
@@ -0,0 +1,317 @@
+#include "serialize.h"
+#include "parameters.h"
+
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char MAGIC[4] = {'C', 'C', 'X', 'B'};
+
+// Header of version 1 files, before byteOrder was added
+static const size_t VERSION_1_HEADER = 24;
+
+// The file is mapped as it is, so its little-endian integers and doubles need a little-endian host
+static bool littleEndianHost(){
+    uint32_t one = 1;
+    unsigned char first;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+static uint16_t swapped(uint16_t value){
+    return uint16_t((value >> 8) | (value << 8));
+}
+
+// Size of the roots section including its padding
+static size_t paddedRoots(uint32_t rootCount){
+    return (rootCount * sizeof(uint32_t) + 7) / 8 * 8;
+}
+
+/*
+    Writer
+*/
+
+uint32_t ExpressionWriter::addConstant(double value){
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    auto found = constantIndex.find(bits);
+    if(found != constantIndex.end()) return found->second;
+
+    uint32_t index = constants.size();
+    constants.push_back(value);
+    constantIndex.emplace(bits, index);
+    return index;
+}
+
+uint32_t ExpressionWriter::addName(const std::string& name){
+    auto found = nameIndex.find(name);
+    if(found != nameIndex.end()) return found->second;
+
+    uint32_t offset = names.size();
+    names += name;
+    names += '\0';
+    nameIndex.emplace(name, offset);
+    return offset;
+}
+
+// Writes the children of f first so every child index is smaller than its parent's, with an explicit
+// stack so deep trees do not overflow the call stack
+uint32_t ExpressionWriter::addNode(const Function& f){
+    struct Pending {
+        const Function* node;
+        int next;
+    };
+    std::vector<Pending> pending{{&f, 0}};
+    while(!pending.empty()){
+        Pending& top = pending.back();
+        if(written.count(top.node)){
+            pending.pop_back();
+            continue;
+        }
+        NodeKind kind = kindOf(*top.node);
+        if(kind == NodeKind::Parameter){
+            throw std::runtime_error("Error cannot serialize parameter \"" + static_cast<const Parameter&>(*top.node).getName() +
+                "\", replace it with a constant first");
+        }
+        if(top.next < childCount(kind)){
+            const Function* child = childOf(*top.node, top.next++).get();
+            if(!written.count(child)) pending.push_back({child, 0});
+            continue;
+        }
+
+        const Function& node = *top.node;
+        SerializedNode serialized = {};
+        serialized.kind = static_cast<uint8_t>(kind);
+        for(int i = 0; i < childCount(kind); i++){
+            serialized.child[i] = written.at(childOf(node, i).get());
+        }
+        if(kind == NodeKind::Variable){
+            serialized.payload = addName(static_cast<const Variable&>(node).getName());
+        }
+        else if(kind == NodeKind::Constant || kind == NodeKind::Polynomial){
+            serialized.payload = addConstant(payloadOf(node));
+        }
+        written.emplace(&node, uint32_t(nodes.size()));
+        nodes.push_back(serialized);
+        pending.pop_back();
+    }
+    return written.at(&f);
+}
+
+size_t ExpressionWriter::add(const Function& f){
+    roots.push_back(addNode(f));
+    return roots.size() - 1;
+}
+
+void ExpressionWriter::write(std::ostream& out) const{
+    if(!littleEndianHost()) throw std::runtime_error("Error expression files can only be written on a little-endian host");
+    SerializedHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = SERIALIZED_VERSION;
+    header.nodeSize = sizeof(SerializedNode);
+    header.nodeCount = nodes.size();
+    header.rootCount = roots.size();
+    header.constantCount = constants.size();
+    header.nameBytes = names.size();
+    header.byteOrder = SERIALIZED_BYTE_ORDER;
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(SerializedNode));
+    out.write(reinterpret_cast<const char*>(roots.data()), roots.size() * sizeof(uint32_t));
+
+    static const char padding[8] = {};
+    out.write(padding, paddedRoots(header.rootCount) - roots.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(constants.data()), constants.size() * sizeof(double));
+    out.write(names.data(), names.size());
+}
+
+void ExpressionWriter::writeFile(const std::string& path) const{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if(!out){
+        throw std::runtime_error("Error cannot open " + path + " for writing");
+    }
+    write(out);
+    if(!out){
+        throw std::runtime_error("Error writing " + path);
+    }
+}
+
+/*
+    Memory mapped reader
+*/
+
+MappedExpressions::MappedExpressions(const std::string& path) : data(nullptr), length(0){
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        throw std::runtime_error("Error cannot open " + path);
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(VERSION_1_HEADER)){
+        close(fd);
+        throw std::runtime_error("Error " + path + " is not an expression file");
+    }
+    length = info.st_size;
+    data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED){
+        data = nullptr;
+        throw std::runtime_error("Error cannot map " + path);
+    }
+
+    const char* bytes = static_cast<const char*>(data);
+    header = reinterpret_cast<const SerializedHeader*>(bytes);
+    size_t headerSize = header->version == 1 ? VERSION_1_HEADER : sizeof(SerializedHeader);
+    nodes = reinterpret_cast<const SerializedNode*>(bytes + headerSize);
+    roots = reinterpret_cast<const uint32_t*>(nodes + header->nodeCount);
+    constants = reinterpret_cast<const double*>(reinterpret_cast<const char*>(roots) + paddedRoots(header->rootCount));
+    names = reinterpret_cast<const char*>(constants + header->constantCount);
+
+    try{
+        validate(headerSize);
+    }
+    catch(...){
+        munmap(data, length);
+        throw;
+    }
+}
+
+MappedExpressions::~MappedExpressions(){
+    if(data) munmap(data, length);
+}
+
+// Checks the format and every index once so evaluation never has to
+void MappedExpressions::validate(size_t headerSize) const{
+    if(!littleEndianHost()) throw std::runtime_error("Error expression files can only be read on a little-endian host");
+    if(std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0){
+        throw std::runtime_error("Error not an expression file");
+    }
+    if(header->version == swapped(1) || header->version == swapped(SERIALIZED_VERSION)){
+        throw std::runtime_error("Error expression file was written with the other byte order");
+    }
+    if((header->version != 1 && header->version != SERIALIZED_VERSION) || header->nodeSize != sizeof(SerializedNode)){
+        throw std::runtime_error("Error unsupported expression file version");
+    }
+    if(length < headerSize){
+        throw std::runtime_error("Error truncated expression file");
+    }
+    if(header->version >= 2 && header->byteOrder != SERIALIZED_BYTE_ORDER){
+        throw std::runtime_error("Error expression file was written with the other byte order");
+    }
+    size_t expected = headerSize + size_t(header->nodeCount) * sizeof(SerializedNode) +
+        paddedRoots(header->rootCount) + size_t(header->constantCount) * sizeof(double) + header->nameBytes;
+    if(length < expected || (header->nameBytes > 0 && names[header->nameBytes - 1] != '\0')){
+        throw std::runtime_error("Error truncated expression file");
+    }
+
+    for(uint32_t i = 0; i < header->nodeCount; i++){
+        const SerializedNode& node = nodes[i];
+        if(node.kind >= static_cast<uint8_t>(NodeKind::Count) || node.kind == static_cast<uint8_t>(NodeKind::Parameter)){
+            throw std::runtime_error("Error unknown node kind in expression file");
+        }
+        NodeKind kind = static_cast<NodeKind>(node.kind);
+        for(int c = 0; c < childCount(kind); c++){
+            if(node.child[c] >= i) throw std::runtime_error("Error invalid child index in expression file");
+        }
+        if(kind == NodeKind::Variable && node.payload >= header->nameBytes){
+            throw std::runtime_error("Error invalid variable name in expression file");
+        }
+        if((kind == NodeKind::Constant || kind == NodeKind::Polynomial) && node.payload >= header->constantCount){
+            throw std::runtime_error("Error invalid constant in expression file");
+        }
+    }
+    for(uint32_t i = 0; i < header->rootCount; i++){
+        if(roots[i] >= header->nodeCount) throw std::runtime_error("Error invalid root in expression file");
+    }
+}
+
+size_t MappedExpressions::size() const{
+    return header->rootCount;
+}
+
+// Marks the nodes below rootNode without recursion; a child index is always below its parent's,
+// so sorting them gives an evaluation order
+std::shared_ptr<const std::vector<uint32_t>> MappedExpressions::evaluationOrder(uint32_t rootNode) const{
+    {
+        std::lock_guard<std::mutex> guard(orderLock);
+        auto known = orders.find(rootNode);
+        if(known != orders.end()) return known->second;
+    }
+
+    // Marks of the calling thread, stamped so that they are never cleared between roots
+    thread_local std::vector<uint32_t> mark;
+    thread_local uint32_t stamp = 0;
+    if(mark.size() < header->nodeCount) mark.resize(header->nodeCount, 0);
+    if(++stamp == 0){
+        std::fill(mark.begin(), mark.end(), 0);
+        stamp = 1;
+    }
+    auto order = std::make_shared<std::vector<uint32_t>>();
+    std::vector<uint32_t> pending{rootNode};
+    while(!pending.empty()){
+        uint32_t index = pending.back();
+        pending.pop_back();
+        if(mark[index] == stamp) continue;
+        mark[index] = stamp;
+        order->push_back(index);
+        const SerializedNode& node = nodes[index];
+        for(int c = 0; c < childCount(static_cast<NodeKind>(node.kind)); c++) pending.push_back(node.child[c]);
+    }
+    std::sort(order->begin(), order->end());
+
+    // Another thread may have built it meanwhile, keep the first one
+    std::lock_guard<std::mutex> guard(orderLock);
+    return orders.emplace(rootNode, std::move(order)).first->second;
+}
+
+// One pass over the nodes below root, children first, into a buffer of values
+double MappedExpressions::evaluate(size_t root, double x) const{
+    if(root >= size()) throw std::out_of_range("Error expression index out of range");
+    std::shared_ptr<const std::vector<uint32_t>> order = evaluationOrder(roots[root]);
+    thread_local std::vector<double> values;
+    if(values.size() < header->nodeCount) values.resize(header->nodeCount);
+    for(uint32_t index : *order){
+        const SerializedNode& node = nodes[index];
+        NodeKind kind = static_cast<NodeKind>(node.kind);
+        int children = childCount(kind);
+        double a = kind == NodeKind::Variable ? x : children > 0 ? values[node.child[0]] : 0.0;
+        double b = children > 1 ? values[node.child[1]] : 0.0;
+        double payload = (kind == NodeKind::Constant || kind == NodeKind::Polynomial) ? constants[node.payload] : 0.0;
+        values[index] = evaluateKind(kind, a, b, payload);
+    }
+    return values[roots[root]];
+}
+
+std::shared_ptr<Function> MappedExpressions::load(size_t root) const{
+    if(root >= size()) throw std::out_of_range("Error expression index out of range");
+    std::shared_ptr<const std::vector<uint32_t>> order = evaluationOrder(roots[root]);
+    std::lock_guard<std::mutex> guard(loadLock);
+    if(loaded.empty()) loaded.resize(header->nodeCount);
+    // Keeps every node of this load alive until its parents hold it
+    std::vector<std::shared_ptr<Function>> held;
+    held.reserve(order->size());
+    for(uint32_t index : *order){
+        std::shared_ptr<Function> result = loaded[index].lock();
+        if(!result){
+            const SerializedNode& node = nodes[index];
+            NodeKind kind = static_cast<NodeKind>(node.kind);
+            if(kind == NodeKind::Variable){
+                result = std::make_shared<Variable>(std::string(names + node.payload));
+            }
+            else{
+                std::shared_ptr<Function> a, b;
+                if(childCount(kind) > 0) a = loaded[node.child[0]].lock();
+                if(childCount(kind) > 1) b = loaded[node.child[1]].lock();
+                double payload = (kind == NodeKind::Constant || kind == NodeKind::Polynomial) ? constants[node.payload] : 0.0;
+                result = makeNode(kind, std::move(a), std::move(b), payload);
+            }
+            loaded[index] = result;
+        }
+        held.push_back(std::move(result));
+    }
+    return loaded[roots[root]].lock();
+}
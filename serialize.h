@@ -0,0 +1,119 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+#include "nodeKind.h"
+
+/*
+    Compact binary format for expression trees (version 2, little-endian)
+        SerializedHeader
+        SerializedNode nodes[nodeCount]      a child always has a smaller index than its parent
+        uint32_t roots[rootCount]            padded with 0 to a multiple of 8 bytes
+        double constants[constantCount]      constant pool: Constant values and Polynomial exponents
+        char names[nameBytes]                Variable names, each terminated by '\0'
+    Subtrees shared between expressions (the same shared_ptr) are written once, so a library of
+    expressions and their derivatives is stored as a single DAG.
+    The file is mapped as it is, so it is only read and written on little-endian hosts. Version 2 adds
+    byteOrder to tell a file from a big-endian writer apart; version 1 files (a 24 byte header
+    without it) are still read.
+*/
+
+const uint16_t SERIALIZED_VERSION = 2;
+const uint32_t SERIALIZED_BYTE_ORDER = 0x01020304;
+
+struct SerializedHeader {
+    char magic[4];              // "CCXB"
+    uint16_t version;
+    uint16_t nodeSize;          // sizeof(SerializedNode), checked on load
+    uint32_t nodeCount;
+    uint32_t rootCount;
+    uint32_t constantCount;
+    uint32_t nameBytes;
+    uint32_t byteOrder;         // SERIALIZED_BYTE_ORDER as written by the host
+    uint32_t reserved;          // 0, keeps the nodes 8 byte aligned
+};
+
+struct SerializedNode {
+    uint8_t kind;               // NodeKind
+    uint8_t reserved[3];
+    uint32_t payload;           // Index into the constant pool, or byte offset of a Variable name
+    uint32_t child[2];          // Indices of children 0 and 1 (see nodeKind.h)
+};
+
+static_assert(sizeof(SerializedHeader) == 32, "SerializedHeader must be 32 bytes");
+static_assert(sizeof(SerializedNode) == 16, "SerializedNode must be 16 bytes");
+
+// Collects any number of Function trees and writes them as one file
+class ExpressionWriter {
+    std::vector<SerializedNode> nodes;
+    std::vector<uint32_t> roots;
+    std::vector<double> constants;
+    std::string names;
+
+    std::unordered_map<const Function*, uint32_t> written;
+    std::unordered_map<uint64_t, uint32_t> constantIndex;
+    std::unordered_map<std::string, uint32_t> nameIndex;
+
+    uint32_t addNode(const Function& f);
+    uint32_t addConstant(double value);
+    uint32_t addName(const std::string& name);
+
+    public:
+    /**
+     * Adds an expression to the file
+     *
+     * Precondition: f and every tree added before it stay alive until the writer is destroyed
+     * Postcondition: returns the root index of f in the file
+     */
+    size_t add(const Function& f);
+
+    void write(std::ostream& out) const;
+    void writeFile(const std::string& path) const;
+};
+
+// A serialized file mapped read-only into memory
+// Expressions are evaluated directly from the mapped nodes; load() rebuilds a Function tree
+class MappedExpressions {
+    void* data;
+    size_t length;
+    const SerializedHeader* header;
+    const SerializedNode* nodes;
+    const uint32_t* roots;
+    const double* constants;
+    const char* names;
+
+    // Per root node, the indices of the nodes it reaches in increasing order, so children come first.
+    // Built on the first evaluate() or load() of the root, opening the file only validates it
+    mutable std::mutex orderLock;
+    mutable std::unordered_map<uint32_t, std::shared_ptr<const std::vector<uint32_t>>> orders;
+
+    // Trees built by load(), so later loads share the nodes of trees still alive
+    mutable std::mutex loadLock;
+    mutable std::vector<std::weak_ptr<Function>> loaded;
+
+    void validate(size_t headerSize) const;
+    std::shared_ptr<const std::vector<uint32_t>> evaluationOrder(uint32_t rootNode) const;
+
+    public:
+    // Maps the file and validates it, throws std::runtime_error if it is not a valid expression file
+    explicit MappedExpressions(const std::string& path);
+    ~MappedExpressions();
+
+    MappedExpressions(const MappedExpressions&) = delete;
+    MappedExpressions& operator=(const MappedExpressions&) = delete;
+
+    // Number of expressions in the file
+    size_t size() const;
+
+    // Evaluates expression root at x without building a tree
+    double evaluate(size_t root, double x) const;
+
+    // Rebuilds expression root as a Function tree, keeping shared subtrees shared, also with the trees
+    // of earlier load() calls that are still alive
+    std::shared_ptr<Function> load(size_t root) const;
+};
@@ -0,0 +1,130 @@
+#include "socketIO.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+static std::runtime_error socketError(const std::string& what){
+    return std::runtime_error("Error " + what + ": " + std::strerror(errno));
+}
+
+static sockaddr_un unixAddress(const std::string& path){
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(address.sun_path)){
+        throw std::runtime_error("Error socket path too long: " + path);
+    }
+    std::strcpy(address.sun_path, path.c_str());
+    return address;
+}
+
+static sockaddr_in loopbackAddress(int port){
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+}
+
+int listenUnix(const std::string& path){
+    sockaddr_un address = unixAddress(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0) throw socketError("creating socket");
+
+    // Only a stale socket is replaced, never a file that happens to have the path
+    struct stat info;
+    if(lstat(path.c_str(), &info) == 0){
+        if(!S_ISSOCK(info.st_mode)){
+            close(fd);
+            throw std::runtime_error("Error " + path + " exists and is not a socket");
+        }
+        unlink(path.c_str());
+    }
+    if(bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0){
+        close(fd);
+        throw socketError("listening on " + path);
+    }
+    return fd;
+}
+
+int listenLoopback(int port){
+    sockaddr_in address = loopbackAddress(port);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0) throw socketError("creating socket");
+
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if(bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0){
+        close(fd);
+        throw socketError("listening on port " + std::to_string(port));
+    }
+    return fd;
+}
+
+int connectUnix(const std::string& path){
+    sockaddr_un address = unixAddress(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0) throw socketError("creating socket");
+    if(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0){
+        close(fd);
+        throw socketError("connecting to " + path);
+    }
+    return fd;
+}
+
+int connectLoopback(int port){
+    sockaddr_in address = loopbackAddress(port);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0) throw socketError("creating socket");
+    if(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0){
+        close(fd);
+        throw socketError("connecting to port " + std::to_string(port));
+    }
+    // Requests are single short lines, send them right away
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    return fd;
+}
+
+bool writeAll(int fd, const std::string& data){
+    size_t sent = 0;
+    while(sent < data.size()){
+        ssize_t count = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if(count < 0 && errno == EINTR) continue;
+        if(count <= 0) return false;
+        sent += count;
+    }
+    return true;
+}
+
+bool LineReader::readLine(std::string& line){
+    while(true){
+        size_t end = buffer.find('\n', start);
+        if(end != std::string::npos){
+            line.assign(buffer, start, end - start);
+            if(!line.empty() && line.back() == '\r') line.pop_back();
+            start = end + 1;
+            return true;
+        }
+
+        // Drop consumed lines before reading more
+        buffer.erase(0, start);
+        start = 0;
+        if(buffer.size() > maxLength){
+            throw std::runtime_error("Error line longer than " + std::to_string(maxLength) + " bytes");
+        }
+
+        char chunk[4096];
+        ssize_t count = recv(fd, chunk, sizeof(chunk), 0);
+        if(count < 0 && errno == EINTR) continue;
+        if(count <= 0) return false;
+        buffer.append(chunk, count);
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+/*
+    Small POSIX socket helpers for the derivative server and its load generator
+    A local endpoint is either a Unix domain socket path or a TCP port on 127.0.0.1.
+    Every function throws std::runtime_error if the socket cannot be set up.
+*/
+
+// Replaces a stale socket at path; throws if path exists and is not a socket
+int listenUnix(const std::string& path);
+int listenLoopback(int port);
+int connectUnix(const std::string& path);
+int connectLoopback(int port);
+
+// Writes all of data, returns false if the connection was closed
+bool writeAll(int fd, const std::string& data);
+
+// Longest line a LineReader buffers by default, newline excluded
+const size_t LINE_LIMIT = size_t(1) << 20;
+
+// Buffered reader that splits a socket stream into lines
+class LineReader {
+    int fd;
+    size_t maxLength;
+    std::string buffer;
+    size_t start = 0;
+
+    public:
+    explicit LineReader(int socket, size_t maximumLength = LINE_LIMIT) : fd(socket), maxLength(maximumLength) {}
+
+    // Reads the next line without its newline, returns false once the connection is closed. Throws
+    // std::runtime_error once a line grows past maxLength bytes, without buffering the rest of it
+    bool readLine(std::string& line);
+};
@@ -0,0 +1,562 @@
+#pragma once
+
+#include <cmath>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include "Functions.h"
+
+/*
+    Compile-time expressions (header only)
+    Expressions known when the program is compiled can be written with the types below instead of
+    a Function tree:
+        using namespace ct;
+        auto f = sin(x) * pow<3>(x) + log(x);
+        auto df = derivative(f);        // the derivative is a type, built and simplified at compile time
+        double y = df(0.5);             // inlined evaluation, no heap and no virtual calls
+    Every node mirrors a Function class (Sum, Polynomial, Sine, ...). toFunction() converts an
+    expression to a Function tree, and Runtime wraps a Function tree so it can be used inside one.
+
+    Simplification rules applied while building: 0 + f = f, 0 * f = 0, 1 * f = f, f / 1 = f,
+    f^0 = 1, f^1 = f, and arithmetic on integer constants (Int<N>) is folded.
+    Evaluation uses the C math library directly: results near 0 are not snapped to 0 and
+    division by 0 returns the IEEE result without recording an evaluation error.
+*/
+namespace ct {
+
+// Marks every node type, so the operators below only apply to expressions
+template<class T, class = void>
+struct IsExpression : std::false_type {};
+template<class T>
+struct IsExpression<T, std::void_t<decltype(T::isExpression)>> : std::true_type {};
+
+template<class T>
+constexpr bool isExpression = IsExpression<std::decay_t<T>>::value;
+
+template<class... T>
+using EnableIfExpression = std::enable_if_t<(isExpression<T> && ...), int>;
+
+// Integer power without std::pow, unrolled by the compiler for a constant n
+constexpr double integerPower(double base, int n){
+    double result = 1.0;
+    for(int i = 0; i < (n < 0 ? -n : n); i++) result *= base;
+    return n < 0 ? 1.0 / result : result;
+}
+
+/*
+    Leaves
+*/
+
+// f(x) = x
+struct X {
+    static constexpr bool isExpression = true;
+    constexpr double operator()(double x) const { return x; }
+};
+
+// f(x) = N, known at compile time
+template<int N>
+struct Int {
+    static constexpr bool isExpression = true;
+    static constexpr int value = N;
+    constexpr double operator()(double) const { return N; }
+};
+
+using Zero = Int<0>;
+using One = Int<1>;
+
+// f(x) = C, a constant stored in the expression
+struct Const {
+    static constexpr bool isExpression = true;
+    double value;
+    constexpr double operator()(double) const { return value; }
+};
+
+// A Function tree used inside a compile-time expression (evaluated with a virtual call)
+struct Runtime {
+    static constexpr bool isExpression = true;
+    std::shared_ptr<Function> function;
+    double operator()(double x) const { return function->evaluate(x); }
+};
+
+constexpr X x{};
+
+template<int N>
+constexpr Int<N> c{};
+
+template<class T>
+constexpr bool isInt = false;
+template<int N>
+constexpr bool isInt<Int<N>> = true;
+
+/*
+    Arithmetic operations
+*/
+
+template<class L, class R>
+struct Add {
+    static constexpr bool isExpression = true;
+    L left; R right;
+    constexpr double operator()(double x) const { return left(x) + right(x); }
+};
+
+template<class L, class R>
+struct Sub {
+    static constexpr bool isExpression = true;
+    L left; R right;
+    constexpr double operator()(double x) const { return left(x) - right(x); }
+};
+
+template<class L, class R>
+struct Mul {
+    static constexpr bool isExpression = true;
+    L left; R right;
+    constexpr double operator()(double x) const { return left(x) * right(x); }
+};
+
+template<class L, class R>
+struct Div {
+    static constexpr bool isExpression = true;
+    L left; R right;
+    constexpr double operator()(double x) const { return left(x) / right(x); }
+};
+
+// f(x)^(N/D), mirrors Polynomial
+template<class A, int N, int D = 1>
+struct Pow {
+    static_assert(D > 0, "the denominator of the exponent must be positive");
+    static constexpr bool isExpression = true;
+    A argument;
+    double operator()(double x) const {
+        if constexpr(D == 1) return integerPower(argument(x), N);
+        else if constexpr(N == 1 && D == 2) return std::sqrt(argument(x));
+        else return std::pow(argument(x), double(N) / D);
+    }
+};
+
+/*
+    Builders, these apply the simplification rules
+*/
+
+template<class L, class R>
+constexpr auto add(L l, R r){
+    if constexpr(std::is_same_v<L, Zero>) return r;
+    else if constexpr(std::is_same_v<R, Zero>) return l;
+    else if constexpr(isInt<L> && isInt<R>) return Int<L::value + R::value>{};
+    else return Add<L, R>{l, r};
+}
+
+template<class L, class R>
+constexpr auto mul(L l, R r){
+    if constexpr(std::is_same_v<L, Zero> || std::is_same_v<R, Zero>) return Zero{};
+    else if constexpr(std::is_same_v<L, One>) return r;
+    else if constexpr(std::is_same_v<R, One>) return l;
+    else if constexpr(isInt<L> && isInt<R>) return Int<L::value * R::value>{};
+    else return Mul<L, R>{l, r};
+}
+
+template<class A>
+constexpr auto negate(A a){
+    return mul(Int<-1>{}, a);
+}
+
+template<class L, class R>
+constexpr auto sub(L l, R r){
+    if constexpr(std::is_same_v<R, Zero>) return l;
+    else if constexpr(std::is_same_v<L, Zero>) return negate(r);
+    else if constexpr(isInt<L> && isInt<R>) return Int<L::value - R::value>{};
+    else return Sub<L, R>{l, r};
+}
+
+template<class L, class R>
+constexpr auto div(L l, R r){
+    if constexpr(std::is_same_v<L, Zero>) return Zero{};
+    else if constexpr(std::is_same_v<R, One>) return l;
+    else return Div<L, R>{l, r};
+}
+
+template<int N, int D = 1, class A>
+constexpr auto power(A a){
+    if constexpr(N == 0) return One{};
+    else if constexpr(N == D) return a;
+    else return Pow<A, N, D>{a};
+}
+
+/*
+    Elementary, trigonometric, inverse trig and hyperbolic functions
+*/
+
+// Unary function node, Op::apply evaluates the function itself
+template<class Op, class A>
+struct Apply {
+    static constexpr bool isExpression = true;
+    A argument;
+    double operator()(double x) const { return Op::apply(argument(x)); }
+};
+
+struct AbsOp { static double apply(double v){ return std::abs(v); } };
+struct LogOp { static double apply(double v){ return std::log(v); } };
+struct ExpOp { static double apply(double v){ return std::exp(v); } };
+struct SinOp { static double apply(double v){ return std::sin(v); } };
+struct CosOp { static double apply(double v){ return std::cos(v); } };
+struct TanOp { static double apply(double v){ return std::tan(v); } };
+struct SecOp { static double apply(double v){ return 1.0 / std::cos(v); } };
+struct CscOp { static double apply(double v){ return 1.0 / std::sin(v); } };
+struct CotOp { static double apply(double v){ return 1.0 / std::tan(v); } };
+struct AsinOp { static double apply(double v){ return std::asin(v); } };
+struct AcosOp { static double apply(double v){ return std::acos(v); } };
+struct AtanOp { static double apply(double v){ return std::atan(v); } };
+struct AcotOp { static double apply(double v){ return std::atan(1.0 / v); } };
+struct AsecOp { static double apply(double v){ return std::acos(1.0 / v); } };
+struct AcscOp { static double apply(double v){ return std::asin(1.0 / v); } };
+struct SinhOp { static double apply(double v){ return std::sinh(v); } };
+struct CoshOp { static double apply(double v){ return std::cosh(v); } };
+struct TanhOp { static double apply(double v){ return std::tanh(v); } };
+struct SechOp { static double apply(double v){ return 1.0 / std::cosh(v); } };
+struct CschOp { static double apply(double v){ return 1.0 / std::sinh(v); } };
+struct CothOp { static double apply(double v){ return 1.0 / std::tanh(v); } };
+
+template<class A> using Abs = Apply<AbsOp, A>;
+template<class A> using Log = Apply<LogOp, A>;     // Natural logarithm, Logarithmic(e, f)
+template<class A> using Exp = Apply<ExpOp, A>;     // e^f, Exponential(e, f)
+template<class A> using Sin = Apply<SinOp, A>;
+template<class A> using Cos = Apply<CosOp, A>;
+template<class A> using Tan = Apply<TanOp, A>;
+template<class A> using Sec = Apply<SecOp, A>;
+template<class A> using Csc = Apply<CscOp, A>;
+template<class A> using Cot = Apply<CotOp, A>;
+template<class A> using Asin = Apply<AsinOp, A>;
+template<class A> using Acos = Apply<AcosOp, A>;
+template<class A> using Atan = Apply<AtanOp, A>;
+template<class A> using Acot = Apply<AcotOp, A>;
+template<class A> using Asec = Apply<AsecOp, A>;
+template<class A> using Acsc = Apply<AcscOp, A>;
+template<class A> using Sinh = Apply<SinhOp, A>;
+template<class A> using Cosh = Apply<CoshOp, A>;
+template<class A> using Tanh = Apply<TanhOp, A>;
+template<class A> using Sech = Apply<SechOp, A>;
+template<class A> using Csch = Apply<CschOp, A>;
+template<class A> using Coth = Apply<CothOp, A>;
+
+template<class Op, class A>
+constexpr Apply<Op, A> apply(A a){
+    return {a};
+}
+
+template<class A, EnableIfExpression<A> = 0> constexpr auto abs(A a){ return apply<AbsOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto log(A a){ return apply<LogOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto exp(A a){ return apply<ExpOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto sin(A a){ return apply<SinOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto cos(A a){ return apply<CosOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto tan(A a){ return apply<TanOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto sec(A a){ return apply<SecOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto csc(A a){ return apply<CscOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto cot(A a){ return apply<CotOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto arcsin(A a){ return apply<AsinOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto arccos(A a){ return apply<AcosOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto arctan(A a){ return apply<AtanOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto arccot(A a){ return apply<AcotOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto arcsec(A a){ return apply<AsecOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto arccsc(A a){ return apply<AcscOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto sinh(A a){ return apply<SinhOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto cosh(A a){ return apply<CoshOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto tanh(A a){ return apply<TanhOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto sech(A a){ return apply<SechOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto csch(A a){ return apply<CschOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto coth(A a){ return apply<CothOp>(a); }
+template<class A, EnableIfExpression<A> = 0> constexpr auto sqrt(A a){ return power<1, 2>(a); }
+
+// pow<N>(f) = f^N, pow<N, D>(f) = f^(N/D)
+template<int N, int D = 1, class A, EnableIfExpression<A> = 0>
+constexpr auto pow(A a){
+    return power<N, D>(a);
+}
+
+/*
+    Operators, a double operand becomes a Const
+*/
+
+template<class T>
+constexpr auto lift(T t){
+    if constexpr(isExpression<T>) return t;
+    else return Const{double(t)};
+}
+
+template<class L, class R>
+using EnableIfOperands = std::enable_if_t<(isExpression<L> || isExpression<R>) &&
+    (isExpression<L> || std::is_arithmetic_v<L>) && (isExpression<R> || std::is_arithmetic_v<R>), int>;
+
+template<class L, class R, EnableIfOperands<L, R> = 0>
+constexpr auto operator+(L l, R r){ return add(lift(l), lift(r)); }
+
+template<class L, class R, EnableIfOperands<L, R> = 0>
+constexpr auto operator-(L l, R r){ return sub(lift(l), lift(r)); }
+
+template<class L, class R, EnableIfOperands<L, R> = 0>
+constexpr auto operator*(L l, R r){ return mul(lift(l), lift(r)); }
+
+template<class L, class R, EnableIfOperands<L, R> = 0>
+constexpr auto operator/(L l, R r){ return div(lift(l), lift(r)); }
+
+template<class A, EnableIfExpression<A> = 0>
+constexpr auto operator-(A a){ return negate(a); }
+
+/*
+    Derivatives, the same rules as derivatives.cpp
+    The result type is the derivative, simplified by the builders above
+*/
+
+constexpr One derivative(X){ return {}; }
+
+template<int N>
+constexpr Zero derivative(Int<N>){ return {}; }
+
+constexpr Zero derivative(Const){ return {}; }
+
+inline Runtime derivative(const Runtime& f){ return {f.function->derivative()}; }
+
+// (f(x) + g(x))' = f'(x) + g'(x)
+template<class L, class R>
+constexpr auto derivative(const Add<L, R>& f){
+    return add(derivative(f.left), derivative(f.right));
+}
+
+// (f(x) - g(x))' = f'(x) - g'(x)
+template<class L, class R>
+constexpr auto derivative(const Sub<L, R>& f){
+    return sub(derivative(f.left), derivative(f.right));
+}
+
+// (f(x)*g(x))' = f'(x)*g(x) + f(x)*g'(x)
+template<class L, class R>
+constexpr auto derivative(const Mul<L, R>& f){
+    return add(mul(derivative(f.left), f.right), mul(f.left, derivative(f.right)));
+}
+
+// (f(x) / g(x))' = (f'(x) * g(x) - f(x) * g'(x)) / g(x)^2
+template<class L, class R>
+constexpr auto derivative(const Div<L, R>& f){
+    return div(sub(mul(derivative(f.left), f.right), mul(f.left, derivative(f.right))), power<2>(f.right));
+}
+
+// (f(x)^(N/D))' = N/D * f(x)^(N/D - 1) * f'(x)
+template<class A, int N, int D>
+constexpr auto derivative(const Pow<A, N, D>& f){
+    if constexpr(D == 1) return mul(mul(Int<N>{}, power<N - 1>(f.argument)), derivative(f.argument));
+    else return mul(mul(Const{double(N) / D}, power<N - D, D>(f.argument)), derivative(f.argument));
+}
+
+// (|f(x)|)' = (f(x) * f'(x)) / |f(x)|
+template<class A>
+constexpr auto derivative(const Abs<A>& f){
+    return div(mul(f.argument, derivative(f.argument)), f);
+}
+
+// ln(f(x))' = f'(x) / f(x)
+template<class A>
+constexpr auto derivative(const Log<A>& f){
+    return div(derivative(f.argument), f.argument);
+}
+
+// (e^f(x))' = e^f(x) * f'(x)
+template<class A>
+constexpr auto derivative(const Exp<A>& f){
+    return mul(f, derivative(f.argument));
+}
+
+// sin(f(x))' = cos(f(x)) * f'(x)
+template<class A>
+constexpr auto derivative(const Sin<A>& f){
+    return mul(cos(f.argument), derivative(f.argument));
+}
+
+// cos(f(x))' = -sin(f(x)) * f'(x)
+template<class A>
+constexpr auto derivative(const Cos<A>& f){
+    return negate(mul(sin(f.argument), derivative(f.argument)));
+}
+
+// tan(f(x))' = sec^2(f(x)) * f'(x)
+template<class A>
+constexpr auto derivative(const Tan<A>& f){
+    return mul(power<2>(sec(f.argument)), derivative(f.argument));
+}
+
+// sec(f(x))' = sec(f(x)) * tan(f(x)) * f'(x)
+template<class A>
+constexpr auto derivative(const Sec<A>& f){
+    return mul(mul(f, tan(f.argument)), derivative(f.argument));
+}
+
+// csc(f(x))' = -csc(f(x)) * cot(f(x)) * f'(x)
+template<class A>
+constexpr auto derivative(const Csc<A>& f){
+    return negate(mul(mul(f, cot(f.argument)), derivative(f.argument)));
+}
+
+// cot(f(x))' = -csc(f(x))^2 * f'(x)
+template<class A>
+constexpr auto derivative(const Cot<A>& f){
+    return negate(mul(power<2>(csc(f.argument)), derivative(f.argument)));
+}
+
+// arcsin(f(x))' = f'(x) * (1 - f(x)^2)^(-1/2)
+template<class A>
+constexpr auto derivative(const Asin<A>& f){
+    return mul(power<-1, 2>(sub(One{}, power<2>(f.argument))), derivative(f.argument));
+}
+
+// arccos(f(x))' = -arcsin(f(x))'
+template<class A>
+constexpr auto derivative(const Acos<A>& f){
+    return negate(derivative(arcsin(f.argument)));
+}
+
+// arctan(f(x))' = f'(x) / (1 + f(x)^2)
+template<class A>
+constexpr auto derivative(const Atan<A>& f){
+    return div(derivative(f.argument), add(One{}, power<2>(f.argument)));
+}
+
+// arccot(f(x))' = -arctan(f(x))'
+template<class A>
+constexpr auto derivative(const Acot<A>& f){
+    return negate(derivative(arctan(f.argument)));
+}
+
+// arcsec(f(x))' = f'(x) / (|f(x)| * sqrt(f(x)^2 - 1))
+template<class A>
+constexpr auto derivative(const Asec<A>& f){
+    return div(derivative(f.argument), mul(abs(f.argument), power<1, 2>(sub(power<2>(f.argument), One{}))));
+}
+
+// arccsc(f(x))' = -arcsec(f(x))'
+template<class A>
+constexpr auto derivative(const Acsc<A>& f){
+    return negate(derivative(arcsec(f.argument)));
+}
+
+// sinh(f(x))' = cosh(f(x)) * f'(x)
+template<class A>
+constexpr auto derivative(const Sinh<A>& f){
+    return mul(cosh(f.argument), derivative(f.argument));
+}
+
+// cosh(f(x))' = sinh(f(x)) * f'(x)
+template<class A>
+constexpr auto derivative(const Cosh<A>& f){
+    return mul(sinh(f.argument), derivative(f.argument));
+}
+
+// tanh(f(x))' = sech(f(x))^2 * f'(x)
+template<class A>
+constexpr auto derivative(const Tanh<A>& f){
+    return mul(power<2>(sech(f.argument)), derivative(f.argument));
+}
+
+// sech(f(x))' = -sech(f(x)) * tanh(f(x)) * f'(x)
+template<class A>
+constexpr auto derivative(const Sech<A>& f){
+    return negate(mul(mul(f, tanh(f.argument)), derivative(f.argument)));
+}
+
+// csch(f(x))' = -csch(f(x)) * coth(f(x)) * f'(x)
+template<class A>
+constexpr auto derivative(const Csch<A>& f){
+    return negate(mul(mul(f, coth(f.argument)), derivative(f.argument)));
+}
+
+// coth(f(x))' = -csch(f(x))^2 * f'(x)
+template<class A>
+constexpr auto derivative(const Coth<A>& f){
+    return negate(mul(power<2>(csch(f.argument)), derivative(f.argument)));
+}
+
+// The derivative of an expression type, e.g. DerivativeOf<decltype(f)>
+template<class E>
+using DerivativeOf = decltype(derivative(std::declval<E>()));
+
+// The N-th derivative of f
+template<int N, class E>
+constexpr auto derivative(const E& f){
+    if constexpr(N == 0) return f;
+    else return derivative<N - 1>(derivative(f));
+}
+
+/*
+    Conversion to a Function tree
+*/
+
+inline std::shared_ptr<Function> toFunction(X){ return std::make_shared<Variable>("x"); }
+
+template<int N>
+std::shared_ptr<Function> toFunction(Int<N>){
+    if constexpr(N == 0) return Constant::zero();
+    else if constexpr(N == 1) return Constant::one();
+    else if constexpr(N == -1) return Constant::negativeOne();
+    else return std::make_shared<Constant>(N);
+}
+
+inline std::shared_ptr<Function> toFunction(Const c){ return std::make_shared<Constant>(c.value); }
+
+inline std::shared_ptr<Function> toFunction(const Runtime& f){ return f.function; }
+
+template<class L, class R>
+std::shared_ptr<Function> toFunction(const Add<L, R>& f){
+    return std::make_shared<Sum>(toFunction(f.left), toFunction(f.right));
+}
+
+template<class L, class R>
+std::shared_ptr<Function> toFunction(const Sub<L, R>& f){
+    return std::make_shared<Difference>(toFunction(f.left), toFunction(f.right));
+}
+
+template<class L, class R>
+std::shared_ptr<Function> toFunction(const Mul<L, R>& f){
+    return std::make_shared<Product>(toFunction(f.left), toFunction(f.right));
+}
+
+template<class L, class R>
+std::shared_ptr<Function> toFunction(const Div<L, R>& f){
+    return std::make_shared<Quotient>(toFunction(f.left), toFunction(f.right));
+}
+
+template<class A, int N, int D>
+std::shared_ptr<Function> toFunction(const Pow<A, N, D>& f){
+    return std::make_shared<Polynomial>(toFunction(f.argument), double(N) / D);
+}
+
+// Maps a unary node to its Function class
+template<class Op> struct FunctionOf;
+template<> struct FunctionOf<AbsOp> { using type = AbsVal; };
+template<> struct FunctionOf<SinOp> { using type = Sine; };
+template<> struct FunctionOf<CosOp> { using type = Cosine; };
+template<> struct FunctionOf<TanOp> { using type = Tangent; };
+template<> struct FunctionOf<SecOp> { using type = Secant; };
+template<> struct FunctionOf<CscOp> { using type = Cosecant; };
+template<> struct FunctionOf<CotOp> { using type = Cotangent; };
+template<> struct FunctionOf<AsinOp> { using type = Arcsin; };
+template<> struct FunctionOf<AcosOp> { using type = Arccos; };
+template<> struct FunctionOf<AtanOp> { using type = Arctan; };
+template<> struct FunctionOf<AcotOp> { using type = Arccot; };
+template<> struct FunctionOf<AsecOp> { using type = Arcsec; };
+template<> struct FunctionOf<AcscOp> { using type = Arccsc; };
+template<> struct FunctionOf<SinhOp> { using type = SineH; };
+template<> struct FunctionOf<CoshOp> { using type = CosineH; };
+template<> struct FunctionOf<TanhOp> { using type = TangentH; };
+template<> struct FunctionOf<SechOp> { using type = SecantH; };
+template<> struct FunctionOf<CschOp> { using type = CosecantH; };
+template<> struct FunctionOf<CothOp> { using type = CotangentH; };
+
+template<class Op, class A>
+std::shared_ptr<Function> toFunction(const Apply<Op, A>& f){
+    if constexpr(std::is_same_v<Op, LogOp>) return std::make_shared<Logarithmic>(Constant::e(), toFunction(f.argument));
+    else if constexpr(std::is_same_v<Op, ExpOp>) return std::make_shared<Exponential>(Constant::e(), toFunction(f.argument));
+    else return std::make_shared<typename FunctionOf<Op>::type>(toFunction(f.argument));
+}
+
+// Wraps a Function tree for use in a compile-time expression
+inline Runtime fromFunction(std::shared_ptr<Function> f){
+    return {std::move(f)};
+}
+
+}
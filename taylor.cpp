@@ -0,0 +1,282 @@
+#include "taylor.h"
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+/*
+    Series recurrences
+    A series of length n = order + 1 holds the normalized coefficients u_k = u^(k)(x) / k!.
+    Every function writes the coefficients 1..order of its result, the caller sets coefficient 0
+    with the kernel of the node so values match evaluate() exactly.
+*/
+
+namespace {
+
+class SeriesMath {
+    int n;
+
+    public:
+    explicit SeriesMath(int length) : n(length) {}
+
+    void product(const double* a, const double* b, double* out) const{
+        for(int k = 0; k < n; k++){
+            double sum = 0.0;
+            for(int j = 0; j <= k; j++) sum += a[j] * b[k - j];
+            out[k] = sum;
+        }
+    }
+
+    // out = a / b, out[0] must be set
+    void quotient(const double* a, const double* b, double* out) const{
+        for(int k = 1; k < n; k++){
+            double sum = a[k];
+            for(int j = 1; j <= k; j++) sum -= b[j] * out[k - j];
+            out[k] = sum / b[0];
+        }
+    }
+
+    // out = exp(u), out[0] must be set: k out_k = sum j u_j out_{k-j}
+    void exp(const double* u, double* out) const{
+        for(int k = 1; k < n; k++){
+            double sum = 0.0;
+            for(int j = 1; j <= k; j++) sum += j * u[j] * out[k - j];
+            out[k] = sum / k;
+        }
+    }
+
+    // out = ln(u): u_0 out_k = u_k - (1 / k) sum_{j < k} j out_j u_{k-j}
+    void log(const double* u, double* out) const{
+        for(int k = 1; k < n; k++){
+            double sum = 0.0;
+            for(int j = 1; j < k; j++) sum += j * out[j] * u[k - j];
+            out[k] = (u[k] - sum / k) / u[0];
+        }
+    }
+
+    // out = u^p with u_0 != 0: k u_0 out_k = sum (p j - (k - j)) u_j out_{k-j}
+    void power(const double* u, double p, double* out) const{
+        for(int k = 1; k < n; k++){
+            double sum = 0.0;
+            for(int j = 1; j <= k; j++) sum += (p * j - (k - j)) * u[j] * out[k - j];
+            out[k] = sum / (k * u[0]);
+        }
+    }
+
+    // s = sin(u), c = cos(u) (sign = -1) or s = sinh(u), c = cosh(u) (sign = 1), s[0] and c[0] must be set
+    void sineCosine(const double* u, double* s, double* c, double sign) const{
+        for(int k = 1; k < n; k++){
+            double sumS = 0.0, sumC = 0.0;
+            for(int j = 1; j <= k; j++){
+                sumS += j * u[j] * c[k - j];
+                sumC += j * u[j] * s[k - j];
+            }
+            s[k] = sumS / k;
+            c[k] = sign * sumC / k;
+        }
+    }
+
+    // out = integral of u' w, the form of every inverse function: k out_k = sum j u_j w_{k-j}
+    void integrate(const double* u, const double* w, double* out, double sign) const{
+        for(int k = 1; k < n; k++){
+            double sum = 0.0;
+            for(int j = 1; j <= k; j++) sum += j * u[j] * w[k - j];
+            out[k] = sign * sum / k;
+        }
+    }
+};
+
+}
+
+TaylorEvaluator::TaylorEvaluator(const Function& f, int maxOrder) : program(buildProgram(f)), order(maxOrder){
+    if(order < 0) throw std::runtime_error("Error derivative order must not be negative");
+}
+
+void TaylorEvaluator::derivatives(double x, std::vector<double>& out) const{
+    const int n = order + 1;
+    SeriesMath math(n);
+    // Series of every instruction, then scratch series for the composite rules
+    thread_local std::vector<double> series;
+    series.assign(n * (program.instructions.size() + 4), 0.0);
+    double* t1 = series.data() + n * program.instructions.size();
+    double* t2 = t1 + n;
+    double* t3 = t2 + n;
+    double* t4 = t3 + n;
+    auto zero = [&](double* s){ std::fill(s, s + n, 0.0); };
+
+    for(size_t i = 0; i < program.instructions.size(); i++){
+        const Instruction& instruction = program.instructions[i];
+        double* y = series.data() + n * i;
+        const double* a = series.data() + n * instruction.a;
+        const double* b = series.data() + n * instruction.b;
+        int children = childCount(instruction.kind);
+        y[0] = evaluateKind(instruction.kind, instruction.kind == NodeKind::Variable ? x : children > 0 ? a[0] : 0.0,
+            children > 1 ? b[0] : 0.0, instruction.payload);
+        if(n == 1) continue;
+
+        switch(instruction.kind){
+            case NodeKind::Constant:
+            case NodeKind::Parameter:
+                break;
+            case NodeKind::Variable:
+                y[1] = 1.0;
+                break;
+            case NodeKind::Sum:
+                for(int k = 1; k < n; k++) y[k] = a[k] + b[k];
+                break;
+            case NodeKind::Difference:
+                for(int k = 1; k < n; k++) y[k] = a[k] - b[k];
+                break;
+            case NodeKind::Product: {
+                double value = y[0];
+                math.product(a, b, y);
+                y[0] = value;
+                break;
+            }
+            case NodeKind::Quotient:
+                math.quotient(a, b, y);
+                break;
+            case NodeKind::AbsVal: {
+                // |u| = sign(u) u away from 0, the sign of the first nonzero coefficient at 0
+                int first = 0;
+                while(first < n && a[first] == 0.0) first++;
+                double sign = first < n && a[first] < 0.0 ? -1.0 : 1.0;
+                for(int k = 1; k < n; k++) y[k] = sign * a[k];
+                break;
+            }
+            case NodeKind::Polynomial: {
+                double p = instruction.payload;
+                if(a[0] != 0.0){
+                    math.power(a, p, y);
+                }
+                else if(p >= 0.0 && p == std::floor(p) && p < n){
+                    // u^p with u_0 = 0 is only smooth for whole p: multiply it out
+                    zero(t1);
+                    t1[0] = 1.0;
+                    for(int m = 0; m < int(p); m++){
+                        math.product(t1, a, t2);
+                        std::copy(t2, t2 + n, t1);
+                    }
+                    std::copy(t1 + 1, t1 + n, y + 1);
+                }
+                else if(p >= 0.0 && p == std::floor(p)){
+                    // Every coefficient up to the order vanishes
+                }
+                else{
+                    for(int k = 1; k < n; k++) y[k] = NAN;
+                }
+                break;
+            }
+            case NodeKind::Logarithmic: {
+                // log_b(a) = ln(a) / ln(b), children are (base, argument)
+                t1[0] = std::log(a[0]);
+                math.log(a, t1);
+                t2[0] = std::log(b[0]);
+                math.log(b, t2);
+                math.quotient(t2, t1, y);
+                break;
+            }
+            case NodeKind::Exponential: {
+                // b^a = exp(a ln(b)), or the power rule when the exponent does not depend on x
+                bool constantExponent = true;
+                for(int k = 1; k < n; k++) constantExponent = constantExponent && b[k] == 0.0;
+                if(constantExponent && a[0] != 0.0){
+                    math.power(a, b[0], y);
+                }
+                else{
+                    t1[0] = std::log(a[0]);
+                    math.log(a, t1);
+                    math.product(b, t1, t2);
+                    math.exp(t2, y);
+                }
+                break;
+            }
+            case NodeKind::Sine:
+            case NodeKind::Cosine:
+            case NodeKind::Tangent:
+            case NodeKind::Secant:
+            case NodeKind::Cosecant:
+            case NodeKind::Cotangent:
+            case NodeKind::SineH:
+            case NodeKind::CosineH:
+            case NodeKind::TangentH:
+            case NodeKind::SecantH:
+            case NodeKind::CosecantH:
+            case NodeKind::CotangentH: {
+                bool hyperbolic = instruction.kind >= NodeKind::SineH;
+                double* s = t1;
+                double* c = t2;
+                s[0] = hyperbolic ? std::sinh(a[0]) : std::sin(a[0]);
+                c[0] = hyperbolic ? std::cosh(a[0]) : std::cos(a[0]);
+                math.sineCosine(a, s, c, hyperbolic ? 1.0 : -1.0);
+                zero(t3);
+                t3[0] = 1.0;
+                NodeKind base = hyperbolic ? NodeKind(size_t(instruction.kind) - size_t(NodeKind::SineH) + size_t(NodeKind::Sine)) : instruction.kind;
+                switch(base){
+                    case NodeKind::Sine: std::copy(s + 1, s + n, y + 1); break;
+                    case NodeKind::Cosine: std::copy(c + 1, c + n, y + 1); break;
+                    case NodeKind::Tangent: math.quotient(s, c, y); break;
+                    case NodeKind::Secant: math.quotient(t3, c, y); break;
+                    case NodeKind::Cosecant: math.quotient(t3, s, y); break;
+                    default: math.quotient(c, s, y); break;
+                }
+                break;
+            }
+            case NodeKind::Arcsin:
+            case NodeKind::Arccos:
+            case NodeKind::Arcsec:
+            case NodeKind::Arccsc: {
+                // arcsin(v)' = v' (1 - v^2)^(-1/2), arcsec(u) = arccos(1 / u), arccsc(u) = arcsin(1 / u)
+                const double* v = a;
+                if(instruction.kind == NodeKind::Arcsec || instruction.kind == NodeKind::Arccsc){
+                    zero(t4);
+                    t4[0] = 1.0;
+                    t3[0] = 1.0 / a[0];
+                    math.quotient(t4, a, t3);
+                    v = t3;
+                }
+                math.product(v, v, t1);
+                for(int k = 0; k < n; k++) t1[k] = -t1[k];
+                t1[0] += 1.0;
+                t2[0] = 1.0 / std::sqrt(t1[0]);
+                math.power(t1, -0.5, t2);
+                bool cosine = instruction.kind == NodeKind::Arccos || instruction.kind == NodeKind::Arcsec;
+                math.integrate(v, t2, y, cosine ? -1.0 : 1.0);
+                break;
+            }
+            case NodeKind::Arctan:
+            case NodeKind::Arccot: {
+                // arctan(u)' = u' / (1 + u^2), arccot(u) = arctan(1 / u) has the opposite derivative
+                math.product(a, a, t1);
+                t1[0] += 1.0;
+                zero(t3);
+                t3[0] = 1.0;
+                t2[0] = 1.0 / t1[0];
+                math.quotient(t3, t1, t2);
+                math.integrate(a, t2, y, instruction.kind == NodeKind::Arccot ? -1.0 : 1.0);
+                break;
+            }
+            default:
+                throw std::runtime_error("Error cannot differentiate node of this kind");
+        }
+    }
+
+    const double* root = series.data() + n * program.outputs[0];
+    out.resize(n);
+    double factorial = 1.0;
+    for(int k = 0; k < n; k++){
+        if(k > 0) factorial *= k;
+        out[k] = root[k] * factorial;
+    }
+}
+
+double TaylorEvaluator::derivative(double x) const{
+    thread_local std::vector<double> values;
+    derivatives(x, values);
+    return values[order];
+}
+
+void TaylorEvaluator::derivative(const std::vector<double>& xs, std::vector<double>& out) const{
+    out.resize(xs.size());
+    for(size_t i = 0; i < xs.size(); i++) out[i] = derivative(xs[i]);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include "program.h"
+
+/*
+    Taylor mode automatic differentiation
+    Pushes truncated Taylor series through the flattened program of f (program.h): every instruction
+    maps the series of its operands to its own with the recurrences for products, quotients, powers,
+    exp, log and the trigonometric functions. Derivatives of any order come from the tree of f alone,
+    without building a derivative tree, in O(instructions * order^2) per point instead of the
+    exponential growth of repeated symbolic differentiation.
+    The value (order 0) is computed with the same kernels as evaluate(). Parameters keep the values
+    they had when the evaluator was built.
+*/
+class TaylorEvaluator {
+    Program program;
+    int order;
+
+    public:
+    /**
+     * Flattens f for derivatives up to the given order
+     *
+     * Precondition: order >= 0
+     * Postcondition: derivatives(x, d) gives f^(k)(x) for k = 0..order
+     */
+    TaylorEvaluator(const Function& f, int maxOrder);
+
+    // out[k] = f^(k)(x) for k = 0..order
+    void derivatives(double x, std::vector<double>& out) const;
+
+    // f^(order)(x)
+    double derivative(double x) const;
+
+    // out[i] = f^(order)(xs[i])
+    void derivative(const std::vector<double>& xs, std::vector<double>& out) const;
+
+    int getOrder() const { return order; }
+};
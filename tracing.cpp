@@ -0,0 +1,187 @@
+#include "tracing.h"
+#include "printer.h"
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+
+/*
+    Ring buffers
+    Only the owning thread writes to a buffer. It fills the slot of index head, then publishes it by
+    storing head + 1 with release order. The exporter reads head, copies the slots, and then reads
+    head again: slots the writer may have reached in the meantime are discarded (a seqlock on the
+    whole buffer). Every field is a relaxed atomic, so a torn slot is never read as valid; a release
+    fence before the writer's slot stores and an acquire fence before the exporter's second read of
+    head make that read cover every slot whose stores the copy may have seen.
+*/
+
+namespace {
+
+struct TraceEvent {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<const char*> argumentName{nullptr};
+    std::atomic<int64_t> argument{0};
+    std::atomic<uint64_t> start{0};
+    std::atomic<uint64_t> duration{0};
+};
+
+struct ThreadTrace {
+    std::unique_ptr<TraceEvent[]> events{new TraceEvent[TRACE_CAPACITY]};
+    std::atomic<uint64_t> head{0};      // Index of the next span, slot head % TRACE_CAPACITY
+    std::atomic<uint64_t> first{0};     // Spans before this index were cleared
+    unsigned id = 0;
+};
+
+struct Registry {
+    std::mutex lock;
+    std::vector<std::shared_ptr<ThreadTrace>> threads;
+};
+
+// Never destroyed, threads can record after main returns
+Registry& registry(){
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+ThreadTrace& local(){
+    thread_local ThreadTrace* trace = []{
+        auto buffer = std::make_shared<ThreadTrace>();
+        std::lock_guard<std::mutex> guard(registry().lock);
+        buffer->id = registry().threads.size() + 1;
+        registry().threads.push_back(buffer);
+        return buffer.get();
+    }();
+    return *trace;
+}
+
+std::atomic<bool> enabled{false};
+const auto epoch = std::chrono::steady_clock::now();
+
+uint64_t now(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+struct SpanCopy {
+    const char* name;
+    const char* argumentName;
+    int64_t argument;
+    uint64_t start;
+    uint64_t duration;
+};
+
+// Consistent copy of the spans of one thread, oldest first
+std::vector<SpanCopy> snapshot(const ThreadTrace& trace){
+    uint64_t head = trace.head.load(std::memory_order_acquire);
+    uint64_t oldest = std::max(trace.first.load(std::memory_order_relaxed), head > TRACE_CAPACITY ? head - TRACE_CAPACITY : 0);
+    std::vector<SpanCopy> spans;
+    spans.reserve(head - std::min(head, oldest));
+    for(uint64_t i = oldest; i < head; i++){
+        const TraceEvent& event = trace.events[i % TRACE_CAPACITY];
+        spans.push_back({event.name.load(std::memory_order_relaxed), event.argumentName.load(std::memory_order_relaxed),
+            event.argument.load(std::memory_order_relaxed), event.start.load(std::memory_order_relaxed),
+            event.duration.load(std::memory_order_relaxed)});
+    }
+
+    // The writer reuses slot i % TRACE_CAPACITY for span i + TRACE_CAPACITY: drop the slots it may have reached
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = trace.head.load(std::memory_order_relaxed);
+    if(after >= TRACE_CAPACITY && after - TRACE_CAPACITY + 1 > oldest){
+        uint64_t overwritten = std::min<uint64_t>(after - TRACE_CAPACITY + 1 - oldest, spans.size());
+        spans.erase(spans.begin(), spans.begin() + overwritten);
+    }
+    return spans;
+}
+
+void appendString(std::string& out, const char* text){
+    // Span names are identifiers written in the source, they need no escaping
+    out += '"';
+    out += text;
+    out += '"';
+}
+
+}
+
+void setTracing(bool on){
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+bool tracingEnabled(){
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void clearTrace(){
+    std::lock_guard<std::mutex> guard(registry().lock);
+    for(const auto& thread : registry().threads){
+        thread->first.store(thread->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+TraceSpan::TraceSpan(const char* spanName, const char* spanArgumentName, int64_t spanArgument)
+    : name(tracingEnabled() ? spanName : nullptr), argumentName(spanArgumentName), argument(spanArgument), start(name ? now() : 0) {}
+
+TraceSpan::~TraceSpan(){
+    if(!name) return;
+    uint64_t end = now();
+    ThreadTrace& trace = local();
+    uint64_t index = trace.head.load(std::memory_order_relaxed);
+    TraceEvent& event = trace.events[index % TRACE_CAPACITY];
+    // Pairs with the acquire fence of snapshot(): a reader that sees any of these stores then reads
+    // a head of at least index, and drops the slot
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name.store(name, std::memory_order_relaxed);
+    event.argumentName.store(argumentName, std::memory_order_relaxed);
+    event.argument.store(argument, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.duration.store(end - start, std::memory_order_relaxed);
+    trace.head.store(index + 1, std::memory_order_release);
+}
+
+/*
+    Export
+    Complete events ("ph": "X") with times in microseconds, plus the name of every thread
+*/
+
+std::string traceJson(){
+    std::vector<std::shared_ptr<ThreadTrace>> threads;
+    {
+        std::lock_guard<std::mutex> guard(registry().lock);
+        threads = registry().threads;
+    }
+
+    std::string pid = std::to_string(getpid());
+    std::string out = "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    bool first = true;
+    for(const auto& thread : threads){
+        std::string tid = std::to_string(thread->id);
+        if(!first) out += ",";
+        first = false;
+        out += "\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " + pid + ", \"tid\": " + tid +
+            ", \"args\": {\"name\": \"thread " + tid + "\"}}";
+
+        for(const SpanCopy& span : snapshot(*thread)){
+            out += ",\n{\"name\": ";
+            appendString(out, span.name);
+            out += ", \"cat\": \"calculus\", \"ph\": \"X\", \"ts\": ";
+            appendNumber(out, span.start / 1000.0);
+            out += ", \"dur\": ";
+            appendNumber(out, span.duration / 1000.0);
+            out += ", \"pid\": " + pid + ", \"tid\": " + tid;
+            if(span.argumentName){
+                out += ", \"args\": {";
+                appendString(out, span.argumentName);
+                out += ": " + std::to_string(span.argument) + "}";
+            }
+            out += '}';
+        }
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+void writeTrace(std::ostream& out){
+    out << traceJson();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <ostream>
+
+/*
+    Timeline tracing
+    TraceSpan records the start and duration of a scope into a ring buffer owned by the calling
+    thread. Spans cover parsing, every derivative order, simplify(), printing and batch evaluation;
+    writeTrace() exports them in the Chrome trace event format, which chrome://tracing and Perfetto
+    open as one timeline row per thread.
+
+    Tracing is off until setTracing(true). A span then costs two clock reads and a few relaxed
+    stores, with no lock and no allocation after the first span of a thread. When the buffer of a
+    thread is full its oldest spans are overwritten, so a long running process keeps about the last
+    TRACE_CAPACITY spans of every thread (a buffer takes 2.5 MB, allocated by its first span).
+*/
+
+const size_t TRACE_CAPACITY = 1 << 16;     // Spans kept per thread
+
+void setTracing(bool enabled);
+bool tracingEnabled();
+
+// Drops every span recorded so far
+void clearTrace();
+
+/**
+ * Writes the recorded spans as a Chrome trace JSON object
+ *
+ * Precondition: None, may be called while other threads are recording
+ * Postcondition: every complete span still in a buffer is written once, spans being overwritten
+ *                during the export are left out
+ */
+void writeTrace(std::ostream& out);
+std::string traceJson();
+
+// Records the scope it lives in. Names must outlive the process (string literals)
+class TraceSpan {
+    const char* name;
+    const char* argumentName;
+    int64_t argument;
+    uint64_t start;
+
+    public:
+    explicit TraceSpan(const char* spanName, const char* spanArgumentName = nullptr, int64_t spanArgument = 0);
+    ~TraceSpan();
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
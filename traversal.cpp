@@ -0,0 +1,240 @@
+#include "traversal.h"
+#include "parameters.h"
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+bool isDeep(const Function& f){
+    return f.complexity().depth > DEEP_TREE_DEPTH;
+}
+
+/*
+    Walks
+    A frame is a node and the index of the next child to visit; a node is finished once all of its
+    children are, which gives the post-order of the recursive implementations.
+*/
+
+namespace {
+
+struct Frame {
+    const Function* node;
+    NodeKind kind;
+    int next;
+};
+
+}
+
+double evaluateIterative(const Function& f, double x){
+    // Per thread, evaluateKind() never comes back here
+    thread_local std::vector<Frame> frames;
+    thread_local std::vector<double> values;
+    // Value of every node already evaluated, so a subtree shared in a DAG (as derivatives build) is
+    // evaluated once instead of once per path to it
+    thread_local std::unordered_map<const Function*, double> evaluated;
+    frames.clear();
+    values.clear();
+    evaluated.clear();
+    frames.push_back({&f, kindOf(f), 0});
+    while(!frames.empty()){
+        Frame& frame = frames.back();
+        int children = childCount(frame.kind);
+        if(frame.next < children){
+            const Function& child = *childOf(*frame.node, frame.next++);
+            auto found = evaluated.find(&child);
+            if(found != evaluated.end()){
+                values.push_back(found->second);
+                continue;
+            }
+            frames.push_back({&child, kindOf(child), 0});
+            continue;
+        }
+        double a = frame.kind == NodeKind::Variable ? x : 0.0, b = 0.0;
+        if(children > 1){
+            b = values.back();
+            values.pop_back();
+        }
+        if(children > 0){
+            a = values.back();
+            values.pop_back();
+        }
+        double value = evaluateKind(frame.kind, a, b, payloadOf(*frame.node));
+        evaluated.emplace(frame.node, value);
+        values.push_back(value);
+        frames.pop_back();
+    }
+    return values.back();
+}
+
+std::shared_ptr<Function> derivativeIterative(const std::shared_ptr<Function>& f){
+    std::shared_ptr<Function> result = f->derivative();
+    // Every lazy node builds one level when it is looked through, so visiting them all builds the tree
+    std::unordered_set<const Function*> visited;
+    std::vector<const Function*> pending{result.get()};
+    while(!pending.empty()){
+        const Function* node = pending.back();
+        pending.pop_back();
+        if(!visited.insert(node).second) continue;
+        NodeKind kind = kindOf(*node);
+        for(int i = 0; i < childCount(kind); i++) pending.push_back(childOf(*node, i).get());
+    }
+    return result;
+}
+
+std::shared_ptr<Function> simplifyIterative(const std::shared_ptr<Function>& f){
+    std::unordered_map<const Function*, std::shared_ptr<Function>> simplified;
+    std::vector<Frame> frames{{f.get(), kindOf(*f), 0}};
+    while(!frames.empty()){
+        Frame& frame = frames.back();
+        int children = childCount(frame.kind);
+        if(frame.next < children){
+            const Function* child = childOf(*frame.node, frame.next++).get();
+            if(!simplified.count(child)) frames.push_back({child, kindOf(*child), 0});
+            continue;
+        }
+        std::shared_ptr<Function> result;
+        if(children == 0){
+            result = frame.node->simplify();
+        }
+        else{
+            std::shared_ptr<Function> a = simplified.at(childOf(*frame.node, 0).get());
+            std::shared_ptr<Function> b = children > 1 ? simplified.at(childOf(*frame.node, 1).get()) : nullptr;
+            result = frame.node->simplifyNode(std::move(a), std::move(b));
+        }
+        simplified.emplace(frame.node, std::move(result));
+        frames.pop_back();
+    }
+    return simplified.at(f.get());
+}
+
+bool isEqualIterative(const Function& f, const Function& g){
+    std::vector<std::pair<const Function*, const Function*>> pending{{&f, &g}};
+    while(!pending.empty()){
+        const Function* a = pending.back().first;
+        const Function* b = pending.back().second;
+        pending.pop_back();
+        if(a == b) continue;
+
+        NodeKind kind = kindOf(*a);
+        if(kindOf(*b) != kind) return false;
+        switch(kind){
+            case NodeKind::Constant:
+            case NodeKind::Polynomial:
+                if(payloadOf(*a) != payloadOf(*b)) return false;
+                break;
+            case NodeKind::Variable:
+                if(nameOf(*a) != nameOf(*b)) return false;
+                break;
+            case NodeKind::Parameter: {
+                const Parameter& p = static_cast<const Parameter&>(*a);
+                const Parameter& q = static_cast<const Parameter&>(*b);
+                if(p.getTable() != q.getTable() || p.getSlot() != q.getSlot()) return false;
+                break;
+            }
+            default:
+                break;
+        }
+        for(int i = 0; i < childCount(kind); i++) pending.push_back({childOf(*a, i).get(), childOf(*b, i).get()});
+    }
+    return true;
+}
+
+/*
+    Rebalancing
+*/
+
+namespace {
+
+bool isChain(NodeKind kind){
+    return kind == NodeKind::Sum || kind == NodeKind::Product;
+}
+
+struct RebalanceFrame {
+    std::shared_ptr<Function> node;
+    NodeKind kind;
+    std::vector<std::shared_ptr<Function>> operands;    // Chain operands left to right, or the children
+    size_t next = 0;
+};
+
+RebalanceFrame frameOf(const std::shared_ptr<Function>& node){
+    RebalanceFrame frame{node, kindOf(*node), {}};
+    if(!isChain(frame.kind)){
+        for(int i = 0; i < childCount(frame.kind); i++) frame.operands.push_back(childOf(*node, i));
+        return frame;
+    }
+    // Leaves of the chain of this kind, the right child is pushed first so the left is taken first
+    std::vector<std::shared_ptr<Function>> pending{node};
+    while(!pending.empty()){
+        std::shared_ptr<Function> current = std::move(pending.back());
+        pending.pop_back();
+        if(kindOf(*current) == frame.kind){
+            pending.push_back(childOf(*current, 1));
+            pending.push_back(childOf(*current, 0));
+        }
+        else{
+            frame.operands.push_back(std::move(current));
+        }
+    }
+    return frame;
+}
+
+// Weight of an operand in the split below: a subtree of depth d is worth 2^d leaves (capped so sums stay finite)
+double weightOf(const Function& f){
+    return std::ldexp(1.0, std::min<uint32_t>(f.complexity().depth, 900));
+}
+
+// Tree over operands [first, last) in order. Splitting where the weights to the left and right are
+// closest keeps deep operands near the root, so the result is at most about one level deeper than
+// the best tree with this order
+std::shared_ptr<Function> balanced(NodeKind kind, const std::vector<std::shared_ptr<Function>>& operands,
+    const std::vector<double>& prefix, size_t first, size_t last){
+    if(last - first == 1) return operands[first];
+    double half = (prefix[first] + prefix[last]) / 2;
+    size_t split = std::upper_bound(prefix.begin() + first + 1, prefix.begin() + last, half) - prefix.begin();
+    if(split > first + 1 && half - prefix[split - 1] < prefix[split] - half) split--;
+    split = std::min(std::max(split, first + 1), last - 1);
+    return makeNode(kind, balanced(kind, operands, prefix, first, split), balanced(kind, operands, prefix, split, last), 0.0);
+}
+
+std::shared_ptr<Function> balanced(NodeKind kind, const std::vector<std::shared_ptr<Function>>& operands){
+    std::vector<double> prefix{0.0};
+    for(const std::shared_ptr<Function>& operand : operands) prefix.push_back(prefix.back() + weightOf(*operand));
+    return balanced(kind, operands, prefix, 0, operands.size());
+}
+
+}
+
+std::shared_ptr<Function> rebalance(const std::shared_ptr<Function>& f){
+    std::unordered_map<const Function*, std::shared_ptr<Function>> rebuilt;
+    std::vector<RebalanceFrame> frames;
+    frames.push_back(frameOf(f));
+    while(!frames.empty()){
+        RebalanceFrame& frame = frames.back();
+        if(frame.next < frame.operands.size()){
+            std::shared_ptr<Function> operand = frame.operands[frame.next++];
+            if(!rebuilt.count(operand.get())) frames.push_back(frameOf(operand));
+            continue;
+        }
+
+        std::vector<std::shared_ptr<Function>> parts;
+        bool changed = false;
+        for(const std::shared_ptr<Function>& operand : frame.operands){
+            parts.push_back(rebuilt.at(operand.get()));
+            changed = changed || parts.back() != operand;
+        }
+        std::shared_ptr<Function> result = frame.node;
+        if(isChain(frame.kind) && parts.size() > 2){
+            // A chain that is already as shallow as the balanced tree is kept
+            std::shared_ptr<Function> tree = balanced(frame.kind, parts);
+            if(changed || tree->complexity().depth < frame.node->complexity().depth) result = std::move(tree);
+        }
+        else if(changed){
+            result = makeNode(frame.kind, parts[0], parts.size() > 1 ? parts[1] : nullptr, payloadOf(*frame.node));
+        }
+        rebuilt.emplace(frame.node.get(), std::move(result));
+        frames.pop_back();
+    }
+    return rebuilt.at(f.get());
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include "nodeKind.h"
+
+/*
+    Iterative traversals
+    evaluate(), derivative(), simplify() and isEqual() recurse once per level of the tree, so a
+    machine generated chain of tens of thousands of terms overflows the call stack. The functions
+    here walk the same trees with an explicit stack on the heap and give the same results; memory
+    grows with the depth of the tree (plus one entry per distinct node for memoized walks) instead
+    of the call stack. print() and display() (printer.h) are always iterative.
+    Trees deeper than DEEP_TREE_DEPTH (Complexity::depth, known in O(1)) should use these;
+    evaluateGrid() and the command line switch over by themselves.
+*/
+
+const uint32_t DEEP_TREE_DEPTH = 1000;
+
+// True if the recursive traversals of f may be too deep for the call stack
+bool isDeep(const Function& f);
+
+/**
+ * Evaluates f at x without recursion
+ *
+ * Precondition: None
+ * Postcondition: returns f.evaluate(x), shared subtrees are evaluated once
+ */
+double evaluateIterative(const Function& f, double x);
+
+/**
+ * Derivative of f with every lazy node built, without recursion
+ *
+ * Precondition: f is not null
+ * Postcondition: returns f->derivative(); walking it later builds nothing
+ */
+std::shared_ptr<Function> derivativeIterative(const std::shared_ptr<Function>& f);
+
+/**
+ * Simplifies f bottom up without recursion, with the rules of every class (Function::simplifyNode)
+ *
+ * Precondition: f is not null
+ * Postcondition: prints as f->simplify(), shared subtrees are simplified once. The rules compare
+ *                siblings with isEqual(), which only recurses as deep as the two subtrees match
+ */
+std::shared_ptr<Function> simplifyIterative(const std::shared_ptr<Function>& f);
+
+/**
+ * Structural equality without recursion
+ *
+ * Precondition: None
+ * Postcondition: returns f.isEqual(g), except that lazy derivatives are looked through at every
+ *                level rather than only at the top
+ */
+bool isEqualIterative(const Function& f, const Function& g);
+
+/**
+ * Turns every chain of Sums and of Products into a balanced tree of the same operands in the same
+ * order, e.g. ((a + b) + c) + d into (a + b) + (c + d). Depth drops from n to log2(n), which also
+ * lets the operands of a chain evaluate in parallel in the pipeline
+ *
+ * Precondition: f is not null
+ * Postcondition: same value as f up to rounding (sums are added in a different order), subtrees
+ *                without chains are shared with f
+ */
+std::shared_ptr<Function> rebalance(const std::shared_ptr<Function>& f);
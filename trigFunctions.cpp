@@ -1,11 +1,18 @@
 #include "trigFunctions.h"
+#include "printer.h"
+#include "instrumentation.h"
 
-std::shared_ptr<Function> Trigonometric::getArgument() const{
+const std::shared_ptr<Function>& Trigonometric::getArgument() const{
     return argument;
 }
 
 std::shared_ptr<Function> Sine::simplify() const{
-    if(auto constant = dynamic_cast<Constant*>(this->getArgument().get())){
+    CALC_PROBE(Simplify, Sine);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> Sine::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
+    if(auto constant = dynamic_cast<Constant*>(argument.get())){
             if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
@@ -13,140 +20,175 @@ std::shared_ptr<Function> Sine::simplify() const{
     // if(negativeArg(argument)){
     //     return std::make_shared<Cosine>(argument->simplify());
     // }
-    return std::make_shared<Sine>(this->getArgument()->simplify());
+    return std::make_shared<Sine>(simplifiedArgument);
 }
 
 bool Sine::isEqual(const std::shared_ptr<Function>& other) const{
     auto otherSine = dynamic_cast<Sine*>(other.get());
     if(!otherSine) return false;
-    return this->getArgument()->isEqual(otherSine->getArgument());
+    return argument->isEqual(otherSine->argument);
 }
 
 std::string Sine::display() const{
-    return "sin(" + this->getArgument()->display() + ")";
+    return toString(*this);
 }
 
 std::shared_ptr<Function> Cosine::simplify() const{
-    if(auto constant = dynamic_cast<Constant*>(this->getArgument().get())){
+    CALC_PROBE(Simplify, Cosine);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> Cosine::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
+    if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<Cosine>(this->getArgument()->simplify());
+    return std::make_shared<Cosine>(simplifiedArgument);
 }
 
 bool Cosine::isEqual(const std::shared_ptr<Function>& other) const{
     auto otherCosine = dynamic_cast<Cosine*>(other.get());
     if(!otherCosine) return false;
-    return this->getArgument()->isEqual(otherCosine->getArgument());
+    return argument->isEqual(otherCosine->argument);
 }
 
 std::string Cosine::display() const{
-    return "cos(" + argument->display() + ")";
+    return toString(*this);
 }
 
 std::shared_ptr<Function> Tangent::simplify() const{
+    CALC_PROBE(Simplify, Tangent);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> Tangent::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
     if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<Tangent>(argument->simplify());
+    return std::make_shared<Tangent>(simplifiedArgument);
 }
 
 bool Tangent::isEqual(const std::shared_ptr<Function>& other) const {
     auto otherTan = dynamic_cast<Tangent*>(other.get());
     if(!otherTan) return false;
-    return this->getArgument()->isEqual(otherTan->getArgument());
+    return argument->isEqual(otherTan->argument);
 }
 
 std::string Tangent::display() const{
-    return "tan(" + this->getArgument()->display() + ")";
+    return toString(*this);
 }
 
 std::shared_ptr<Function> Secant::simplify() const{
-    if(auto constant = dynamic_cast<Constant*>(this->getArgument().get())){
+    CALC_PROBE(Simplify, Secant);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> Secant::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
+    if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<Secant>(this->getArgument()->simplify());
+    return std::make_shared<Secant>(simplifiedArgument);
 }
 
 bool Secant::isEqual(const std::shared_ptr<Function>& other)const {
     auto otherSec = dynamic_cast<Secant*>(other.get());
     if(!otherSec) return false;
-    return this->getArgument()->isEqual(otherSec->getArgument());
+    return argument->isEqual(otherSec->argument);
 }
 
 std::string Secant::display() const{
-    return "sec(" + this->getArgument()->display() + ")";
+    return toString(*this);
 }
 
 std::shared_ptr<Function> Cosecant::simplify() const {
-    if(auto constant = dynamic_cast<Constant*>(this->getArgument().get())){
+    CALC_PROBE(Simplify, Cosecant);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> Cosecant::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
+    if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<Cotangent>(this->getArgument()->simplify());
+    return std::make_shared<Cotangent>(simplifiedArgument);
 }
 
 bool Cosecant::isEqual(const std::shared_ptr<Function>& other) const{
     auto otherTrig = dynamic_cast<Cosecant*>(other.get());
     if(!otherTrig) return false;
-    return this->getArgument()->isEqual(otherTrig->getArgument());
+    return argument->isEqual(otherTrig->argument);
 }
 
 std::string Cosecant::display() const {
-    return "csc(" + this->getArgument()->display() + ")";
+    return toString(*this);
 }
 
 std::shared_ptr<Function> Cotangent::simplify() const{
-    if(auto constant = dynamic_cast<Constant*>(this->getArgument().get())){
+    CALC_PROBE(Simplify, Cotangent);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> Cotangent::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
+    if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<Cotangent>(this->getArgument()->simplify());
+    return std::make_shared<Cotangent>(simplifiedArgument);
 }
 
 bool Cotangent::isEqual(const std::shared_ptr<Function>& other) const{
     auto otherTrig = dynamic_cast<Cotangent*>(other.get());
     if(!otherTrig) return false;
-    return this->getArgument()->isEqual(otherTrig->getArgument());
+    return argument->isEqual(otherTrig->argument);
 }
 
 std::string Cotangent::display() const{
-    return "cot(" + this->getArgument()->display() + ")";
+    return toString(*this);
 }
 
 std::shared_ptr<Function> Arcsin::simplify() const{
-    if(auto constant = dynamic_cast<Constant*>(this->getArgument().get())){
+    CALC_PROBE(Simplify, Arcsin);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> Arcsin::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
+    if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<Arcsin>(this->getArgument()->simplify());
+    return std::make_shared<Arcsin>(simplifiedArgument);
 }
 
 bool Arcsin::isEqual(const std::shared_ptr<Function>& other) const{
     auto otherTrig = dynamic_cast<Arcsin*>(other.get());
     if(!otherTrig) return false;
-    return this->getArgument()->isEqual(otherTrig->getArgument());
+    return argument->isEqual(otherTrig->argument);
 }
 
 std::string Arcsin::display() const{
-    return "arcsin(" + this->getArgument()->display() + ")";
+    return toString(*this);
 }
 
 std::shared_ptr<Function> Arccos::simplify() const {
+    CALC_PROBE(Simplify, Arccos);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> Arccos::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
     if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<Arccos>(argument->simplify());
+    return std::make_shared<Arccos>(simplifiedArgument);
 }
 
 bool Arccos::isEqual(const std::shared_ptr<Function>& other) const {
@@ -156,16 +198,21 @@ bool Arccos::isEqual(const std::shared_ptr<Function>& other) const {
 }
 
 std::string Arccos::display() const {
-    return "arccos(" + argument->display() + ")";
+    return toString(*this);
 }
 
 std::shared_ptr<Function> Arctan::simplify() const {
+    CALC_PROBE(Simplify, Arctan);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> Arctan::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
     if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<Tangent>(argument->simplify());
+    return std::make_shared<Tangent>(simplifiedArgument);
 }
 
 bool Arctan::isEqual(const std::shared_ptr<Function>& other) const{
@@ -175,16 +222,21 @@ bool Arctan::isEqual(const std::shared_ptr<Function>& other) const{
 }
 
 std::string Arctan::display() const {
-    return "arctan(" + argument->display() + ")";
+    return toString(*this);
 }
 
 std::shared_ptr<Function> Arccot::simplify() const {
+    CALC_PROBE(Simplify, Arccot);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> Arccot::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
     if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<Arccot>(argument->simplify());
+    return std::make_shared<Arccot>(simplifiedArgument);
 }
 
 bool Arccot::isEqual(const std::shared_ptr<Function>& other) const{
@@ -194,16 +246,21 @@ bool Arccot::isEqual(const std::shared_ptr<Function>& other) const{
 }
 
 std::string Arccot::display() const {
-    return "arccot(" + argument->display() + ")";
+    return toString(*this);
 }
 
 std::shared_ptr<Function> Arcsec::simplify() const {
+    CALC_PROBE(Simplify, Arcsec);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> Arcsec::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
     if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<Arcsec>(argument->simplify());
+    return std::make_shared<Arcsec>(simplifiedArgument);
 }
 
 bool Arcsec::isEqual(const std::shared_ptr<Function>& other) const {
@@ -213,16 +270,21 @@ bool Arcsec::isEqual(const std::shared_ptr<Function>& other) const {
 }
 
 std::string Arcsec::display() const{
-    return "arcsec(" + argument->display() + ")";
+    return toString(*this);
 }
 
 std::shared_ptr<Function> Arccsc::simplify() const {
+    CALC_PROBE(Simplify, Arccsc);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> Arccsc::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
     if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<Arccsc>(argument->simplify());
+    return std::make_shared<Arccsc>(simplifiedArgument);
 }
 
 bool Arccsc::isEqual(const std::shared_ptr<Function>& other) const {
@@ -232,16 +294,21 @@ bool Arccsc::isEqual(const std::shared_ptr<Function>& other) const {
 }
 
 std::string Arccsc::display() const {
-    return "arccsc(" + argument->display() + ")";
+    return toString(*this);
 }
 
 std::shared_ptr<Function> SineH::simplify() const {
+    CALC_PROBE(Simplify, SineH);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> SineH::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
     if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<SineH>(argument->simplify());
+    return std::make_shared<SineH>(simplifiedArgument);
 }
 
 bool SineH::isEqual(const std::shared_ptr<Function>& other) const{
@@ -251,17 +318,22 @@ bool SineH::isEqual(const std::shared_ptr<Function>& other) const{
 }
 
 std::string SineH::display() const {
-    return "sinh(" + argument->display() + ")";
+    return toString(*this);
 }
 //cosh
 
 std::shared_ptr<Function> CosineH::simplify() const {
+    CALC_PROBE(Simplify, CosineH);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> CosineH::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
     if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<CosineH>(argument->simplify());
+    return std::make_shared<CosineH>(simplifiedArgument);
 }
 
 bool CosineH::isEqual(const std::shared_ptr<Function>& other) const{
@@ -271,18 +343,23 @@ bool CosineH::isEqual(const std::shared_ptr<Function>& other) const{
 }
 
 std::string CosineH::display() const {
-    return "cosh(" + argument->display() + ")";
+    return toString(*this);
 }
 
 //tanh
 
 std::shared_ptr<Function> TangentH::simplify() const {
+    CALC_PROBE(Simplify, TangentH);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> TangentH::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
     if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<TangentH>(argument->simplify());
+    return std::make_shared<TangentH>(simplifiedArgument);
 }
 
 bool TangentH::isEqual(const std::shared_ptr<Function>& other) const{
@@ -292,18 +369,23 @@ bool TangentH::isEqual(const std::shared_ptr<Function>& other) const{
 }
 
 std::string TangentH::display() const {
-    return "tanh(" + argument->display() + ")";
+    return toString(*this);
 }
 
 //sech
 
 std::shared_ptr<Function> SecantH::simplify() const {
+    CALC_PROBE(Simplify, SecantH);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> SecantH::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
     if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<SecantH>(argument->simplify());
+    return std::make_shared<SecantH>(simplifiedArgument);
 }
 
 bool SecantH::isEqual(const std::shared_ptr<Function>& other) const{
@@ -313,18 +395,23 @@ bool SecantH::isEqual(const std::shared_ptr<Function>& other) const{
 }
 
 std::string SecantH::display() const {
-    return "sech(" + argument->display() + ")";
+    return toString(*this);
 }
 
 //csch
 
 std::shared_ptr<Function> CosecantH::simplify() const {
+    CALC_PROBE(Simplify, CosecantH);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> CosecantH::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
     if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<CosecantH>(argument->simplify());
+    return std::make_shared<CosecantH>(simplifiedArgument);
 }
 
 bool CosecantH::isEqual(const std::shared_ptr<Function>& other) const{
@@ -334,18 +421,23 @@ bool CosecantH::isEqual(const std::shared_ptr<Function>& other) const{
 }
 
 std::string CosecantH::display() const {
-    return "csch(" + argument->display() + ")";
+    return toString(*this);
 }
 
 //coth
 
 std::shared_ptr<Function> CotangentH::simplify() const{
+    CALC_PROBE(Simplify, CotangentH);
+    return simplifyNode(argument->simplify(), nullptr);
+}
+
+std::shared_ptr<Function> CotangentH::simplifyNode(std::shared_ptr<Function> simplifiedArgument, std::shared_ptr<Function>) const{
     if(auto constant = dynamic_cast<Constant*>(argument.get())){
         if(double eval = this->evaluate(1.0) == floor(eval)){
             return std::make_shared<Constant>(eval);
         }
     }
-    return std::make_shared<CotangentH>(argument->simplify());
+    return std::make_shared<CotangentH>(simplifiedArgument);
 }
 
 bool CotangentH::isEqual(const std::shared_ptr<Function>& other) const{
@@ -355,5 +447,5 @@ bool CotangentH::isEqual(const std::shared_ptr<Function>& other) const{
 }
 
 std::string CotangentH::display() const {
-    return "coth(" + argument->display() + ")";
+    return toString(*this);
 }
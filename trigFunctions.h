@@ -8,11 +8,17 @@ class Trigonometric : public Function{
     std::shared_ptr<Function> argument;
 
     public:
-    explicit Trigonometric(const std::shared_ptr<Function>& expr) : argument(expr){}
+    Trigonometric(std::shared_ptr<Function> expr, Complexity::Rule rule) : argument(std::move(expr)){
+        measure(Complexity::TRANSCENDENTAL, rule, argument.get());
+    }
+    ~Trigonometric() override { release(argument); }
 
-    std::shared_ptr<Function> getArgument() const;
+    const std::shared_ptr<Function>& getArgument() const;
+    const Function& getArgumentRef() const { return *argument; }
 
     virtual double evaluate(double x) const override = 0;   // Evaluate the function at x
+    virtual Interval evaluateInterval(const Interval& x) const override = 0;   // Bound the function over every x in [lo, hi]
+    virtual Complex evaluateComplex(const Complex& z) const override = 0;   // Evaluate the function at a complex z (principal branches)
     virtual std::shared_ptr<Function> derivative() const override = 0;  // Return the derivative of the function
     virtual std::shared_ptr<Function> simplify() const override = 0;
     virtual bool isEqual(const std::shared_ptr<Function>& other) const override = 0;
@@ -22,14 +28,22 @@ class Trigonometric : public Function{
 // Class for sine function (sin(f(x)))
 class Sine : public Trigonometric{
     public:
-    explicit Sine(const std::shared_ptr<Function>& arg) : Trigonometric(arg) {}    
+    static constexpr Complexity::Rule RULE = {2, 1, 0};
+
+    explicit Sine(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}    
 
     double evaluate(double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -38,14 +52,22 @@ class Sine : public Trigonometric{
 // Class for cosine function (cos(f(x)))
 class Cosine : public Trigonometric{
     public:
-    explicit Cosine(const std::shared_ptr<Function>& arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {4, 1, 0};
+
+    explicit Cosine(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
 
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -54,14 +76,22 @@ class Cosine : public Trigonometric{
 // Class for tangent function (tan(f(x)))
 class Tangent : public Trigonometric{
     public:
-    explicit Tangent(const std::shared_ptr<Function>& arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {3, 1, 0};
+
+    explicit Tangent(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
 
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -70,14 +100,22 @@ class Tangent : public Trigonometric{
 // Class for secant function (sec(f(x)))
 class Secant : public Trigonometric{
     public:
-    explicit Secant(const std::shared_ptr<Function>& arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {4, 2, 0};
+
+    explicit Secant(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
         
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other)const override;
 
     std::string display() const override;
@@ -86,14 +124,22 @@ class Secant : public Trigonometric{
 // Class for cosecant function (csc(f(x)))
 class Cosecant : public Trigonometric{
     public:
-    explicit Cosecant(const std::shared_ptr<Function>& arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {6, 2, 0};
+
+    explicit Cosecant(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
                 
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other)const override;
 
     std::string display() const override;
@@ -102,14 +148,22 @@ class Cosecant : public Trigonometric{
 // Class for cotangent function (cot(f(x)))
 class Cotangent : public Trigonometric{
     public:
-    explicit Cotangent(std::shared_ptr<Function> arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {5, 1, 0};
+
+    explicit Cotangent(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
         
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -118,19 +172,23 @@ class Cotangent : public Trigonometric{
 // Class for inverse sine function (arcsin(f(x)))
 class Arcsin : public Trigonometric{
     public:
-    explicit Arcsin(std::shared_ptr<Function> arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {5, 1, 0};
+
+    explicit Arcsin(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
         
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
-    bool isEqual(const std::shared_ptr<Function>& other) const override{
-        auto otherTrig = dynamic_cast<Arcsin*>(other.get());
-        if(!otherTrig) return false;
-        return argument->isEqual(otherTrig->argument);
-    }
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
+    bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
 };
@@ -138,14 +196,22 @@ class Arcsin : public Trigonometric{
 // Class for inverse cosine function (arccos(f(x)))
 class Arccos : public Trigonometric{
     public:
-    explicit Arccos(std::shared_ptr<Function> arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {7, 1, 0};
+
+    explicit Arccos(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
         
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -154,14 +220,22 @@ class Arccos : public Trigonometric{
 // Class for inverse tangent function (arctan(f(x)))
 class Arctan : public Trigonometric{
     public:
-    Arctan(std::shared_ptr<Function> arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {4, 1, 0};
+
+    Arctan(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
         
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -170,14 +244,22 @@ class Arctan : public Trigonometric{
 // Class for inverse cotangent function (arccot(f(x)))
 class Arccot : public Trigonometric{
     public:
-    Arccot(std::shared_ptr<Function> arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {6, 1, 0};
+
+    Arccot(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
 
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -186,15 +268,23 @@ class Arccot : public Trigonometric{
 // Class for inverse secant function (arcsec(f(x)))
 class Arcsec : public Trigonometric{
     public:
-    Arcsec(std::shared_ptr<Function> arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {7, 2, 0};
+
+    Arcsec(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
 
         
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -203,14 +293,22 @@ class Arcsec : public Trigonometric{
 // Class for inverse cosecant function (arccsc(f(X)))
 class Arccsc : public Trigonometric{
     public:
-    Arccsc(std::shared_ptr<Function> arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {9, 2, 0};
+
+    Arccsc(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
       
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -221,14 +319,22 @@ class Arccsc : public Trigonometric{
 // Class for hyperbolic sine function (sinh(f(x)))
 class SineH : public Trigonometric{
     public:
-    SineH(std::shared_ptr<Function> arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {2, 1, 0};
+
+    SineH(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
         
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -237,14 +343,22 @@ class SineH : public Trigonometric{
 // Class for hyperbolic cosine function (cosh(f(x)))
 class CosineH : public Trigonometric{
     public:
-    CosineH(std::shared_ptr<Function> arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {2, 1, 0};
+
+    CosineH(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
         
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -253,14 +367,22 @@ class CosineH : public Trigonometric{
 // Class for hyperbolic tangent function (tanh(f(x)))
 class TangentH : public Trigonometric{
     public:
-    TangentH(std::shared_ptr<Function> arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {3, 1, 0};
+
+    TangentH(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
 
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;
@@ -269,14 +391,22 @@ class TangentH : public Trigonometric{
 // Class for hyperbolic secant function (sech(f(x)))
 class SecantH : public Trigonometric{
     public:
-    SecantH(std::shared_ptr<Function> arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {6, 2, 0};
+
+    SecantH(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
         
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
     
     std::string display() const override;
@@ -285,14 +415,22 @@ class SecantH : public Trigonometric{
 // Class for hyperbolic cosecant function (csch(f(x)))
 class CosecantH : public Trigonometric{
     public:
-    CosecantH(std::shared_ptr<Function> arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {6, 2, 0};
+
+    CosecantH(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
         
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other)const override;
 
     std::string display() const override;
@@ -301,14 +439,22 @@ class CosecantH : public Trigonometric{
 // Class for hyperbolic cotangent function (coth(f(x)))
 class CotangentH : public Trigonometric{
     public:
-    CotangentH(std::shared_ptr<Function> arg) : Trigonometric(arg) {}
+    static constexpr Complexity::Rule RULE = {5, 1, 0};
+
+    CotangentH(std::shared_ptr<Function> arg) : Trigonometric(std::move(arg), RULE) {}
 
     double evaluate (double x) const override;
 
+    Interval evaluateInterval(const Interval& x) const override;
+
+    Complex evaluateComplex(const Complex& z) const override;
+
     std::shared_ptr<Function> derivative() const override;
 
     std::shared_ptr<Function> simplify() const override;
 
+    std::shared_ptr<Function> simplifyNode(std::shared_ptr<Function> a, std::shared_ptr<Function> b) const override;
+
     bool isEqual(const std::shared_ptr<Function>& other) const override;
 
     std::string display() const override;